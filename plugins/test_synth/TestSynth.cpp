@@ -19,7 +19,12 @@ PERFORMANCE OF THIS SOFTWARE.
 */
 
 #include "TestSynth.hpp"
+#include "../../DPF/distrho/DistrhoPluginUtils.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 
 #define ENABLE_LOGGING false
 #if ENABLE_LOGGING
@@ -28,7 +33,12 @@ PERFORMANCE OF THIS SOFTWARE.
 
 // public
 TestSynth::TestSynth() // inherits from Plugin(uint32_t parameterCount, uint32_t programCount, uint32_t stateCount)
-     : DISTRHO::Plugin(0,0,0) {
+     : DISTRHO::Plugin(Parameter_Index::count,0,State_Index::count) {
+    for (uint32_t index = 0; index < Parameter_Index::count; ++index) {
+        DISTRHO::Parameter parameter;
+        initParameter(index, parameter);
+        parameter_values[index] = parameter.ranges.def;
+    }
     }
 
 // protected
@@ -37,32 +47,734 @@ void TestSynth::activate() {
     if (ENABLE_LOGGING) printf("Sample rate: %f. Buffer size: %u\n", getSampleRate(), getBufferSize());
     if (ENABLE_LOGGING) printf("C++ version: %ld\n", __cplusplus);
 
-    sample_period = 1/getSampleRate();
+    // widest kernels this CPU runs, unless a test or benchmark forced a set
+    Kernel_Set kernel_set = select_kernels();
+    if (ENABLE_LOGGING) printf("DSP kernels: %s\n", get_kernel_set_name(kernel_set));
+
+    sample_period = 1/(getSampleRate()*oversampling_factor);
 
     frames_since_start = 0;
+    silent_blocks = 0;
+    tail_frames = 0;
 
+    bend_coefficient = 1.f;
+    tune_coefficient = 1.f;
     frequency_coefficient = 1.f;
+    pitch_bend_value = 0x2000;
+    mpe_zones.reset_expression();
+    modulation.set_mod_wheel(0);
+    modulation.reset_lfos();
+    last_note_frequency = 0;
+
+    // the voice arrays are sized here, so the setting takes effect on the next activation
+    max_polyphony = uint32_t(std::lround(std::clamp(parameter_values[Parameter_Index::max_polyphony].load(std::memory_order_relaxed), 1.f, float(max_polyphony_limit))));
+    active_voices.allocate(max_polyphony);
+    if (ENABLE_INSTRUMENTATION && std::strcmp(DISTRHO::getPluginFormatName(), "JACK/Standalone") == 0) {
+        instrumentation.start_reporter();
+    }
+    active_voices.set_steal_policy(steal_policy);
+    adaptive_voice_limit.reset(max_polyphony);
+    // threads only start and stop here, so the setting takes effect on the next activation
+    worker_threads = uint32_t(std::lround(std::clamp(parameter_values[Parameter_Index::worker_threads].load(std::memory_order_relaxed), 0.f, float(max_worker_threads))));
+    if (worker_threads > 0) {
+        worker_pool.start(worker_threads, max_polyphony, getBufferSize()*Decimator::max_factor);
+    }
+    sample_streamer.start(max_polyphony);
+
+    // the tables only depend on the phase increment, so they survive sample rate changes, and only the first
+    // instance in the process builds them, or maps them from the disk cache
+    if (!saw_table) {
+        saw_table = Table_Registry::acquire<Wavetable>({"saw wavetable", 0, {}}, []() {
+            std::unique_ptr<Wavetable> table = std::make_unique<Wavetable>();
+            table->load_saw();
+            return table;
+        });
+        triangle_table = Table_Registry::acquire<Wavetable>({"triangle wavetable", 0, {}}, []() {
+            std::unique_ptr<Wavetable> table = std::make_unique<Wavetable>();
+            table->load_triangle();
+            return table;
+        });
+    }
+    if (ENABLE_LOGGING) printf("Tables shared between instances: %zu\n", Table_Registry::get_table_count());
+
+    // every type create_oscillator() makes, so they all fit
+    oscillator_arena.allocate(Object_Arena::get_size_for<Fast_Sine_Oscillator, Saw_Oscillator, Pulse_Oscillator, Triangle_Oscillator,
+                                                         Additive_Oscillator, FM_Oscillator, Sample_Oscillator>());
+    for (uint8_t w_idx = 0; w_idx < uint8_t(Waveform::count); ++w_idx) {
+        oscillators[w_idx] = create_oscillator(Waveform(w_idx));
+    }
+    envelope.set_parameters(attack_time_s, decay_time_s, sustain_level, release_time_s, getSampleRate()*oversampling_factor);
+    unison.set_parameters(unison_copies, unison_detune_ct, unison_spread);
+    signal_generator = Signal_Generator(oscillators[uint8_t(waveform)], &envelope, &unison, &modulation, &sample_period, &frequency_coefficient);
+
+    gain_smoother.allocate(getBufferSize());
+    fine_tune_smoother.allocate(getBufferSize());
+    gain_smoother.set_ramp_time(smoothing_time_s, getSampleRate());
+    fine_tune_smoother.set_ramp_time(smoothing_time_s, getSampleRate());
+    reverb_level_smoother.allocate(getBufferSize());
+    reverb_level_smoother.set_ramp_time(smoothing_time_s, getSampleRate());
+    reverb.allocate(getSampleRate());
+    reverb_running = false;
+
+    // sized for the highest factor, so the oversampling parameter can change without allocating
+    oversampled_bus.assign(size_t(getBufferSize())*Decimator::max_factor, 0);
+    oversampled_side_bus.assign(size_t(getBufferSize())*Decimator::max_factor, 0);
+    decimator.allocate(getBufferSize());
+    side_decimator.allocate(getBufferSize());
+    set_oversampling(oversampling_factor);
 
-    sin_osc = new Sine_Oscillator(0, 0.5);
-    signal_generator = Signal_Generator(sin_osc, &sample_period, &frequency_coefficient);
+    parameters_changed = false;
+    apply_parameters();
+    // start at the current values rather than ramping from wherever the last activation left off
+    gain_smoother.reset(gain_smoother.get_target());
+    fine_tune_smoother.reset(fine_tune_smoother.get_target());
+    reverb_level_smoother.reset(reverb_level_smoother.get_target());
+    update_tune_coefficient(fine_tune_smoother.get_value());
 }
 void TestSynth::deactivate() {
-    delete sin_osc;
+    instrumentation.stop_reporter();
+    if (ENABLE_LOGGING && worker_pool.get_priority_failures() > 0) {
+        printf("%u worker threads couldn't get realtime priority\n", worker_pool.get_priority_failures());
+    }
+    worker_pool.stop();
+    sample_streamer.stop();
+    oscillator_arena.free_storage();
+    std::fill(oscillators, oscillators + uint8_t(Waveform::count), nullptr);
+    gain_smoother.free_storage();
+    fine_tune_smoother.free_storage();
+    reverb_level_smoother.free_storage();
+    reverb.free_storage();
+    decimator.free_storage();
+    side_decimator.free_storage();
+    oversampled_bus = std::vector<float>();
+    oversampled_side_bus = std::vector<float>();
+    active_voices.free_storage();
+}
+
+Oscillator* TestSynth::create_oscillator(Waveform waveform_in) {
+    switch (waveform_in) {
+    case Waveform::saw:
+        return oscillator_arena.create<Saw_Oscillator>(saw_table.get());
+    case Waveform::pulse:
+        return oscillator_arena.create<Pulse_Oscillator>(saw_table.get(), 0, 0.5);
+    case Waveform::triangle:
+        return oscillator_arena.create<Triangle_Oscillator>(triangle_table.get());
+    case Waveform::additive:
+        return oscillator_arena.create<Additive_Oscillator>(&additive_spectrum);
+    case Waveform::fm:
+        return oscillator_arena.create<FM_Oscillator>(&fm_patch);
+    case Waveform::sample:
+        return oscillator_arena.create<Sample_Oscillator>(&sample_streamer);
+    case Waveform::sine:
+    default:
+        return oscillator_arena.create<Fast_Sine_Oscillator>(0, 0.5);
+    }
 }
 
 void TestSynth::update_frequency_coefficient(uint16_t new_frequency_value) {
-    // Pitch bend has 14 bits of information, so the maximum possible value is 0x3fff, or 16383
-    // This leaves us with a center value of 8192.
-    const uint16_t mid_value = 0x2000;
-    frequency_coefficient = float(new_frequency_value - mid_value)/mid_value;
-    frequency_coefficient = pow(2, (max_frequency_coefficient_st/12)*frequency_coefficient);
+    pitch_bend_value = new_frequency_value & 0x3fff;
+    bend_coefficient = pitch_bend_table->coefficient[pitch_bend_value];
+    frequency_coefficient = bend_coefficient*tune_coefficient;
+}
+void TestSynth::update_tune_coefficient(float cents) {
+    tune_coefficient = std::exp2(cents/1200);
+    frequency_coefficient = bend_coefficient*tune_coefficient;
 }
 
 void TestSynth::sampleRateChanged (double newSampleRate) {
-    sample_period = 1/newSampleRate;
+    sample_period = 1/(newSampleRate*oversampling_factor);
+    envelope.set_parameters(attack_time_s, decay_time_s, sustain_level, release_time_s, newSampleRate*oversampling_factor);
+    gain_smoother.set_ramp_time(smoothing_time_s, newSampleRate);
+    fine_tune_smoother.set_ramp_time(smoothing_time_s, newSampleRate);
+    reverb_level_smoother.set_ramp_time(smoothing_time_s, newSampleRate);
     if (ENABLE_LOGGING) printf("Sample rate: %f (%f)\n", getSampleRate(), newSampleRate);
 }
 
+// parameters
+static const char* const mod_source_names[uint8_t(Mod_Source::count)] = {"None", "LFO 1", "LFO 2", "Envelope", "Velocity", "Pressure", "Timbre", "Mod wheel"};
+static const char* const mod_destination_names[uint8_t(Mod_Destination::count)] = {"None", "Pitch", "Amplitude", "Pulse width", "Pan"};
+static const char* const lfo_shape_names[uint8_t(LFO_Shape::count)] = {"Sine", "Triangle", "Saw", "Square"};
+static const char* const additive_preset_names[uint8_t(Additive_Preset::count)] = {"Saw", "Square", "Organ"};
+static const char* const fm_algorithm_names[uint8_t(FM_Algorithm::count)] = {
+    "6 > 5 > 4 > 3 > 2 > 1", "2 > 1, 6 > 5 > 4 > 3", "2 > 1, 4 > 3, 6 > 5", "2 > 1, 4 + (6 > 5) > 3", "2 > 1, 6 > 3 + 4 + 5",
+    "3 > 2 > 1, 6 > 4 + 5", "All carriers", "4 > 3 > 2 > 1", "2 > 1, 4 > 3",
+};
+
+// an integer parameter choosing one of `count` labels, valued 0 to count - 1
+static void set_enumeration(DISTRHO::Parameter& parameter, const char* const* labels, uint8_t count) {
+    DISTRHO::ParameterEnumerationValue* const values = new DISTRHO::ParameterEnumerationValue[count]; // freed by DPF
+    for (uint8_t v_idx = 0; v_idx < count; ++v_idx) {
+        values[v_idx].label = labels[v_idx];
+        values[v_idx].value = v_idx;
+    }
+    parameter.hints |= DISTRHO::kParameterIsInteger;
+    parameter.ranges.def = 0;
+    parameter.ranges.min = 0;
+    parameter.ranges.max = count - 1;
+    parameter.enumValues.count = count;
+    parameter.enumValues.restrictedMode = true;
+    parameter.enumValues.values = values;
+}
+
+void TestSynth::initParameter(uint32_t index, DISTRHO::Parameter& parameter) {
+    parameter.hints = DISTRHO::kParameterIsAutomatable;
+    switch (index) {
+    case Parameter_Index::gain:
+        parameter.name = "Gain";
+        parameter.symbol = "gain";
+        parameter.unit = "dB";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = -60;
+        parameter.ranges.max = 12;
+        break;
+    case Parameter_Index::pitch_bend_range:
+        parameter.hints |= DISTRHO::kParameterIsInteger;
+        parameter.name = "Pitch bend range";
+        parameter.symbol = "pitch_bend_range";
+        parameter.unit = "st";
+        parameter.ranges.def = default_pitch_bend_range_st;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 24;
+        break;
+    case Parameter_Index::fine_tune:
+        parameter.name = "Fine tune";
+        parameter.symbol = "fine_tune";
+        parameter.unit = "ct";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = -100;
+        parameter.ranges.max = 100;
+        break;
+    case Parameter_Index::waveform: {
+        parameter.hints |= DISTRHO::kParameterIsInteger;
+        parameter.name = "Waveform";
+        parameter.symbol = "waveform";
+        parameter.ranges.def = float(Waveform::sine);
+        parameter.ranges.min = 0;
+        parameter.ranges.max = float(Waveform::count) - 1;
+
+        DISTRHO::ParameterEnumerationValue* const values = new DISTRHO::ParameterEnumerationValue[uint8_t(Waveform::count)]; // freed by DPF
+        values[0].label = "Sine";
+        values[0].value = float(Waveform::sine);
+        values[1].label = "Saw";
+        values[1].value = float(Waveform::saw);
+        values[2].label = "Pulse";
+        values[2].value = float(Waveform::pulse);
+        values[3].label = "Triangle";
+        values[3].value = float(Waveform::triangle);
+        values[4].label = "Additive";
+        values[4].value = float(Waveform::additive);
+        values[5].label = "FM";
+        values[5].value = float(Waveform::fm);
+        values[6].label = "Sample";
+        values[6].value = float(Waveform::sample);
+        parameter.enumValues.count = uint8_t(Waveform::count);
+        parameter.enumValues.restrictedMode = true;
+        parameter.enumValues.values = values;
+    } break;
+    case Parameter_Index::attack:
+        parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+        parameter.name = "Attack";
+        parameter.symbol = "attack";
+        parameter.unit = "s";
+        parameter.ranges.def = 0.005;
+        parameter.ranges.min = 0.001;
+        parameter.ranges.max = 5;
+        break;
+    case Parameter_Index::decay:
+        parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+        parameter.name = "Decay";
+        parameter.symbol = "decay";
+        parameter.unit = "s";
+        parameter.ranges.def = 0.1;
+        parameter.ranges.min = 0.001;
+        parameter.ranges.max = 5;
+        break;
+    case Parameter_Index::sustain:
+        parameter.name = "Sustain";
+        parameter.symbol = "sustain";
+        parameter.ranges.def = 0.8;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::release:
+        parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+        parameter.name = "Release";
+        parameter.symbol = "release";
+        parameter.unit = "s";
+        parameter.ranges.def = 0.2;
+        parameter.ranges.min = 0.001;
+        parameter.ranges.max = 10;
+        break;
+    case Parameter_Index::oversampling: {
+        // changes the latency, so it's a setting rather than something to automate
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "Oversampling";
+        parameter.symbol = "oversampling";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 3;
+
+        DISTRHO::ParameterEnumerationValue* const values = new DISTRHO::ParameterEnumerationValue[4]; // freed by DPF
+        values[0].label = "Off";
+        values[0].value = 0;
+        values[1].label = "2x";
+        values[1].value = 1;
+        values[2].label = "4x";
+        values[2].value = 2;
+        values[3].label = "8x";
+        values[3].value = 3;
+        parameter.enumValues.count = 4;
+        parameter.enumValues.restrictedMode = true;
+        parameter.enumValues.values = values;
+    } break;
+    case Parameter_Index::unison_voices:
+        parameter.hints |= DISTRHO::kParameterIsInteger;
+        parameter.name = "Unison voices";
+        parameter.symbol = "unison_voices";
+        parameter.ranges.def = 1;
+        parameter.ranges.min = 1;
+        parameter.ranges.max = Unison::max_copies;
+        break;
+    case Parameter_Index::unison_detune:
+        parameter.name = "Unison detune";
+        parameter.symbol = "unison_detune";
+        parameter.unit = "ct";
+        parameter.ranges.def = 20;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 100;
+        break;
+    case Parameter_Index::unison_spread:
+        parameter.name = "Unison spread";
+        parameter.symbol = "unison_spread";
+        parameter.ranges.def = 0.5;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::mpe_layout: {
+        // changing it releases every held note, so it's a setting rather than something to automate
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "MPE zones";
+        parameter.symbol = "mpe_layout";
+        parameter.ranges.def = float(MPE_Layout::off);
+        parameter.ranges.min = 0;
+        parameter.ranges.max = float(MPE_Layout::count) - 1;
+
+        DISTRHO::ParameterEnumerationValue* const values = new DISTRHO::ParameterEnumerationValue[uint8_t(MPE_Layout::count)]; // freed by DPF
+        values[0].label = "Off";
+        values[0].value = float(MPE_Layout::off);
+        values[1].label = "Lower";
+        values[1].value = float(MPE_Layout::lower);
+        values[2].label = "Upper";
+        values[2].value = float(MPE_Layout::upper);
+        values[3].label = "Both";
+        values[3].value = float(MPE_Layout::both);
+        parameter.enumValues.count = uint8_t(MPE_Layout::count);
+        parameter.enumValues.restrictedMode = true;
+        parameter.enumValues.values = values;
+    } break;
+    case Parameter_Index::pressure_depth:
+        parameter.name = "Pressure depth";
+        parameter.symbol = "pressure_depth";
+        parameter.unit = "dB";
+        parameter.ranges.def = 6;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 12;
+        break;
+    case Parameter_Index::control_rate: {
+        // how often envelopes and modulation update; sets the grid every voice's control periods follow
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "Control rate";
+        parameter.symbol = "control_rate";
+        static const char* const labels[] = {"16 frames", "32 frames", "64 frames"};
+        set_enumeration(parameter, labels, 3);
+        parameter.ranges.def = 1;
+    } break;
+    case Parameter_Index::glide_time:
+        parameter.name = "Glide";
+        parameter.symbol = "glide_time";
+        parameter.unit = "s";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 2;
+        break;
+    case Parameter_Index::lfo_1_rate:
+    case Parameter_Index::lfo_2_rate: {
+        const bool first = index == Parameter_Index::lfo_1_rate;
+        parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+        parameter.name = first ? "LFO 1 rate" : "LFO 2 rate";
+        parameter.symbol = first ? "lfo_1_rate" : "lfo_2_rate";
+        parameter.unit = "Hz";
+        parameter.ranges.def = first ? 5 : 0.5;
+        parameter.ranges.min = 0.01;
+        parameter.ranges.max = 20;
+    } break;
+    case Parameter_Index::lfo_1_shape:
+    case Parameter_Index::lfo_2_shape: {
+        const bool first = index == Parameter_Index::lfo_1_shape;
+        parameter.name = first ? "LFO 1 shape" : "LFO 2 shape";
+        parameter.symbol = first ? "lfo_1_shape" : "lfo_2_shape";
+        set_enumeration(parameter, lfo_shape_names, uint8_t(LFO_Shape::count));
+    } break;
+    case Parameter_Index::additive_preset:
+        parameter.name = "Additive spectrum";
+        parameter.symbol = "additive_preset";
+        set_enumeration(parameter, additive_preset_names, uint8_t(Additive_Preset::count));
+        break;
+    case Parameter_Index::additive_partials:
+        parameter.hints |= DISTRHO::kParameterIsInteger;
+        parameter.name = "Additive partials";
+        parameter.symbol = "additive_partials";
+        parameter.ranges.def = 256;
+        parameter.ranges.min = 1;
+        parameter.ranges.max = Additive_Spectrum::max_partials;
+        break;
+    case Parameter_Index::additive_tilt:
+        // spectral slope on top of the preset; the level stays the same
+        parameter.name = "Additive tilt";
+        parameter.symbol = "additive_tilt";
+        parameter.unit = "dB/oct";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = -12;
+        parameter.ranges.max = 6;
+        break;
+    case Parameter_Index::fm_algorithm:
+        parameter.name = "FM algorithm";
+        parameter.symbol = "fm_algorithm";
+        set_enumeration(parameter, fm_algorithm_names, uint8_t(FM_Algorithm::count));
+        break;
+    case Parameter_Index::fm_feedback:
+        parameter.name = "FM feedback";
+        parameter.symbol = "fm_feedback";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::pan:
+        parameter.name = "Pan";
+        parameter.symbol = "pan";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = -1;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::pan_spread:
+        // low notes to the left and high notes to the right
+        parameter.name = "Pan spread";
+        parameter.symbol = "pan_spread";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::reverb_level:
+        parameter.name = "Reverb level";
+        parameter.symbol = "reverb_level";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::reverb_size:
+        // changing it clears the tail, so it's a setting rather than something to automate
+        parameter.hints = 0;
+        parameter.name = "Reverb size";
+        parameter.symbol = "reverb_size";
+        parameter.ranges.def = 0.5;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::reverb_decay:
+        // time to fall 60 dB
+        parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+        parameter.name = "Reverb decay";
+        parameter.symbol = "reverb_decay";
+        parameter.unit = "s";
+        parameter.ranges.def = 2;
+        parameter.ranges.min = 0.1;
+        parameter.ranges.max = 20;
+        break;
+    case Parameter_Index::reverb_damping:
+        parameter.name = "Reverb damping";
+        parameter.symbol = "reverb_damping";
+        parameter.ranges.def = 0.5;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    case Parameter_Index::reverb_lines: {
+        // changing it clears the tail, so it's a setting rather than something to automate
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "Reverb lines";
+        parameter.symbol = "reverb_lines";
+        static const char* const labels[] = {"8", "16"};
+        set_enumeration(parameter, labels, 2);
+        parameter.ranges.def = 1;
+    } break;
+    case Parameter_Index::worker_threads:
+        // starting and stopping threads isn't realtime safe, so it's a setting that applies on the next activate()
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "Worker threads";
+        parameter.symbol = "worker_threads";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = max_worker_threads;
+        break;
+    case Parameter_Index::max_polyphony:
+        // resizing the voice arrays allocates, so it's a setting that applies on the next activate()
+        parameter.hints = DISTRHO::kParameterIsInteger;
+        parameter.name = "Max polyphony";
+        parameter.symbol = "max_polyphony";
+        parameter.ranges.def = 64;
+        parameter.ranges.min = 1;
+        parameter.ranges.max = max_polyphony_limit;
+        break;
+    case Parameter_Index::adaptive_polyphony:
+        // a setting rather than something to automate: turning it on can drop voices
+        parameter.hints = DISTRHO::kParameterIsBoolean;
+        parameter.name = "Adaptive polyphony";
+        parameter.symbol = "adaptive_polyphony";
+        parameter.ranges.def = 0;
+        parameter.ranges.min = 0;
+        parameter.ranges.max = 1;
+        break;
+    default:
+        if (index >= Parameter_Index::mod_1_source && index <= Parameter_Index::mod_4_amount) {
+            // three parameters per modulation slot: source, destination and amount
+            const uint32_t slot = (index - Parameter_Index::mod_1_source)/3;
+            char name[32];
+            char symbol[32];
+            switch ((index - Parameter_Index::mod_1_source) % 3) {
+            case 0:
+                snprintf(name, sizeof(name), "Mod %u source", slot + 1);
+                snprintf(symbol, sizeof(symbol), "mod_%u_source", slot + 1);
+                set_enumeration(parameter, mod_source_names, uint8_t(Mod_Source::count));
+                break;
+            case 1:
+                snprintf(name, sizeof(name), "Mod %u destination", slot + 1);
+                snprintf(symbol, sizeof(symbol), "mod_%u_destination", slot + 1);
+                set_enumeration(parameter, mod_destination_names, uint8_t(Mod_Destination::count));
+                break;
+            default:
+                snprintf(name, sizeof(name), "Mod %u amount", slot + 1);
+                snprintf(symbol, sizeof(symbol), "mod_%u_amount", slot + 1);
+                parameter.ranges.def = 0;
+                parameter.ranges.min = -1;
+                parameter.ranges.max = 1;
+                break;
+            }
+            parameter.name = name;
+            parameter.symbol = symbol;
+        } else if (index >= Parameter_Index::op_1_ratio && index <= Parameter_Index::op_6_level) {
+            // two parameters per FM operator: frequency ratio and level. Operator 1 starts as a plain sine.
+            const uint32_t op = (index - Parameter_Index::op_1_ratio)/2;
+            char name[32];
+            char symbol[32];
+            if ((index - Parameter_Index::op_1_ratio) % 2 == 0) {
+                snprintf(name, sizeof(name), "Op %u ratio", op + 1);
+                snprintf(symbol, sizeof(symbol), "op_%u_ratio", op + 1);
+                parameter.hints |= DISTRHO::kParameterIsLogarithmic;
+                parameter.ranges.def = 1;
+                parameter.ranges.min = 0.5;
+                parameter.ranges.max = 32;
+            } else {
+                snprintf(name, sizeof(name), "Op %u level", op + 1);
+                snprintf(symbol, sizeof(symbol), "op_%u_level", op + 1);
+                parameter.ranges.def = (op == 0) ? 1 : 0;
+                parameter.ranges.min = 0;
+                parameter.ranges.max = 1;
+            }
+            parameter.name = name;
+            parameter.symbol = symbol;
+        }
+        break;
+    }
+    parameter.shortName = parameter.name;
+}
+float TestSynth::getParameterValue(uint32_t index) const {
+    if (index >= Parameter_Index::count) {
+        return 0;
+    }
+    return parameter_values[index].load(std::memory_order_relaxed);
+}
+// May be called from any thread; run() picks the values up at the start of its next block
+void TestSynth::setParameterValue(uint32_t index, float value) {
+    if (index >= Parameter_Index::count) {
+        return;
+    }
+    parameter_values[index].store(value, std::memory_order_relaxed);
+    parameters_changed.store(true, std::memory_order_release);
+}
+void TestSynth::apply_parameters() {
+    auto value = [this](uint32_t index) { return parameter_values[index].load(std::memory_order_relaxed); };
+
+    // gain, fine tune and reverb level ramp; everything else is either a setting or already changes smoothly
+    gain_smoother.set_target(std::pow(10.f, value(Parameter_Index::gain)/20));
+    fine_tune_smoother.set_target(value(Parameter_Index::fine_tune));
+    reverb_level_smoother.set_target(std::clamp(value(Parameter_Index::reverb_level), 0.f, 1.f));
+
+    if (value(Parameter_Index::pitch_bend_range) != max_frequency_coefficient_st) {
+        max_frequency_coefficient_st = value(Parameter_Index::pitch_bend_range);
+        if (max_frequency_coefficient_st == default_pitch_bend_range_st) {
+            pitch_bend_table = &default_pitch_bend_table;
+        } else {
+            // only when the range changes, so every pitch bend message stays a lookup
+            fill_pitch_bend_table(custom_pitch_bend_table, max_frequency_coefficient_st);
+            pitch_bend_table = &custom_pitch_bend_table;
+        }
+        update_frequency_coefficient(pitch_bend_value);
+    }
+
+    Waveform new_waveform = Waveform(std::lround(std::clamp(value(Parameter_Index::waveform), 0.f, float(Waveform::count) - 1)));
+    if (new_waveform != waveform) {
+        waveform = new_waveform;
+        signal_generator.set_oscillator(oscillators[uint8_t(waveform)]); // voices keep their phase
+    }
+
+    // voices only store their stage and level, so they carry on along the new curves; a new sustain level
+    // is approached at the decay rate rather than jumped to
+    float new_attack_s = value(Parameter_Index::attack);
+    float new_decay_s = value(Parameter_Index::decay);
+    float new_sustain_level = value(Parameter_Index::sustain);
+    float new_release_s = value(Parameter_Index::release);
+    if (new_attack_s != attack_time_s || new_decay_s != decay_time_s || new_sustain_level != sustain_level || new_release_s != release_time_s) {
+        attack_time_s = new_attack_s;
+        decay_time_s = new_decay_s;
+        sustain_level = new_sustain_level;
+        release_time_s = new_release_s;
+        envelope.set_parameters(attack_time_s, decay_time_s, sustain_level, release_time_s, getSampleRate()*oversampling_factor);
+    }
+
+    uint32_t new_unison_copies = uint32_t(std::lround(std::clamp(value(Parameter_Index::unison_voices), 1.f, float(Unison::max_copies))));
+    float new_unison_detune_ct = value(Parameter_Index::unison_detune);
+    float new_unison_spread = value(Parameter_Index::unison_spread);
+    const bool was_stereo = unison.is_enabled() || signal_generator.is_panning();
+    if (new_unison_copies != unison_copies || new_unison_detune_ct != unison_detune_ct || new_unison_spread != unison_spread) {
+        unison_copies = new_unison_copies;
+        unison_detune_ct = new_unison_detune_ct;
+        unison_spread = new_unison_spread;
+        unison.set_parameters(unison_copies, unison_detune_ct, unison_spread);
+    }
+
+    // voices held on channels that change role would keep the wrong expression, so they are released
+    MPE_Layout new_mpe_layout = MPE_Layout(std::lround(std::clamp(value(Parameter_Index::mpe_layout), 0.f, float(MPE_Layout::count) - 1)));
+    if (new_mpe_layout != mpe_zones.get_layout()) {
+        mpe_zones.set_layout(new_mpe_layout);
+        active_voices.release_all();
+    }
+    // gain at full pressure, in dB above the unpressed level
+    signal_generator.set_pressure_depth(std::pow(10.f, value(Parameter_Index::pressure_depth)/20) - 1);
+
+    Additive_Preset new_additive_preset = Additive_Preset(std::lround(std::clamp(value(Parameter_Index::additive_preset), 0.f, float(Additive_Preset::count) - 1)));
+    uint32_t new_additive_partials = uint32_t(std::lround(std::clamp(value(Parameter_Index::additive_partials), 1.f, float(Additive_Spectrum::max_partials))));
+    float new_additive_tilt_db = value(Parameter_Index::additive_tilt);
+    if (new_additive_preset != additive_preset || new_additive_partials != additive_partials || new_additive_tilt_db != additive_tilt_db) {
+        additive_preset = new_additive_preset;
+        additive_partials = new_additive_partials;
+        additive_tilt_db = new_additive_tilt_db;
+        additive_spectrum.set_preset(additive_preset, additive_partials, additive_tilt_db);
+    }
+
+    fm_patch.set_algorithm(FM_Algorithm(std::lround(std::clamp(value(Parameter_Index::fm_algorithm), 0.f, float(FM_Algorithm::count) - 1))));
+    fm_patch.set_feedback(value(Parameter_Index::fm_feedback));
+    for (uint32_t op = 0; op < FM_Patch::max_operators; ++op) {
+        fm_patch.set_operator(op, value(Parameter_Index::op_1_ratio + 2*op), value(Parameter_Index::op_1_level + 2*op));
+    }
+
+    envelope.set_control_period(Envelope::min_control_period << std::lround(std::clamp(value(Parameter_Index::control_rate), 0.f, 2.f)));
+    glide_time_s = std::max(0.f, value(Parameter_Index::glide_time));
+    for (uint32_t slot = 0; slot < Modulation_Matrix::slot_count; ++slot) {
+        const uint32_t base = Parameter_Index::mod_1_source + 3*slot;
+        Mod_Source source = Mod_Source(std::lround(std::clamp(value(base), 0.f, float(Mod_Source::count) - 1)));
+        Mod_Destination destination = Mod_Destination(std::lround(std::clamp(value(base + 1), 0.f, float(Mod_Destination::count) - 1)));
+        modulation.set_slot(slot, source, destination, std::clamp(value(base + 2), -1.f, 1.f));
+    }
+
+    // panning costs a second pass over each voice's span, so it's skipped while every voice would be centred
+    voice_pan = std::clamp(value(Parameter_Index::pan), -1.f, 1.f);
+    pan_spread = std::clamp(value(Parameter_Index::pan_spread), 0.f, 1.f);
+    signal_generator.set_panning(voice_pan != 0 || pan_spread != 0 || modulation.is_routed(Mod_Destination::pan));
+    if (!was_stereo && (unison.is_enabled() || signal_generator.is_panning())) {
+        side_decimator.set_factor(oversampling_factor); // clear whatever it held when the side channel last stopped
+    }
+
+    reverb.set_parameters(8u << std::lround(std::clamp(value(Parameter_Index::reverb_lines), 0.f, 1.f)), value(Parameter_Index::reverb_size),
+                          value(Parameter_Index::reverb_decay), value(Parameter_Index::reverb_damping));
+
+    bool new_adaptive_polyphony = value(Parameter_Index::adaptive_polyphony) >= 0.5f;
+    if (new_adaptive_polyphony != adaptive_polyphony) {
+        adaptive_polyphony = new_adaptive_polyphony;
+        // start again from every voice either way, rather than keeping a limit measured under the other setting
+        adaptive_voice_limit.reset(max_polyphony);
+        active_voices.set_voice_limit(max_polyphony);
+    }
+
+    uint32_t new_oversampling_factor = 1u << std::lround(std::clamp(value(Parameter_Index::oversampling), 0.f, 3.f));
+    if (new_oversampling_factor != oversampling_factor) {
+        set_oversampling(new_oversampling_factor);
+    }
+
+    // voices read the LFOs at the internal rate, so this comes after the oversampling factor
+    for (uint32_t lfo = 0; lfo < Modulation_Matrix::lfo_count; ++lfo) {
+        const uint32_t base = Parameter_Index::lfo_1_rate + 2*lfo;
+        LFO_Shape shape = LFO_Shape(std::lround(std::clamp(value(base + 1), 0.f, float(LFO_Shape::count) - 1)));
+        modulation.set_lfo(lfo, value(base), shape, getSampleRate()*oversampling_factor);
+    }
+}
+void TestSynth::set_oversampling(uint32_t factor) {
+    decimator.set_factor(factor);
+    side_decimator.set_factor(factor);
+    oversampling_factor = decimator.get_factor();
+    tail_frames = 0; // set_factor() cleared the filters
+    sample_period = 1/(getSampleRate()*oversampling_factor);
+    envelope.set_parameters(attack_time_s, decay_time_s, sustain_level, release_time_s, getSampleRate()*oversampling_factor);
+    // Voices advance the phase before reading it, so each frame holds the signal at its end: a whole host frame late
+    // at the host rate, but only 1/factor of one when oversampled. Compared to rendering at the host rate, the output
+    // lags by the difference on top of the filters' delay, which with these filter lengths is a whole number of frames.
+    setLatency(uint32_t(std::lround(decimator.get_latency() + 1 - 1.0/oversampling_factor)));
+}
+
+// state
+void TestSynth::initState(uint32_t index, DISTRHO::State& state) {
+    switch (index) {
+    case State_Index::scala_scale:
+        state.key = "scala_scale";
+        state.label = "Scala scale (.scl)";
+        break;
+    case State_Index::scala_mapping:
+        state.key = "scala_mapping";
+        state.label = "Scala keyboard mapping (.kbm)";
+        break;
+    case State_Index::sample_library:
+        state.key = "sample_library";
+        state.label = "Sample library (.sfz)";
+        break;
+    }
+    state.hints = DISTRHO::kStateIsFilenamePath;
+    state.defaultValue = "";
+}
+
+// Called from a non-RT thread; the new tuning table or sample library reaches the audio thread at the start of a later block
+void TestSynth::setState(const char* key, const char* value) {
+    if (std::strcmp(key, "sample_library") == 0) {
+        if (value[0] == '\0') {
+            sample_streamer.unload();
+        } else if (!sample_streamer.load_sfz(value)) {
+            if (ENABLE_LOGGING) printf("Could not load samples from %s\n", value);
+        }
+        return;
+    }
+
+    if (std::strcmp(key, "scala_scale") == 0) {
+        scala_scale_path = value;
+    } else if (std::strcmp(key, "scala_mapping") == 0) {
+        scala_mapping_path = value;
+    } else {
+        return;
+    }
+
+    if (scala_scale_path.isEmpty()) {
+        tuning.reset();
+    } else if (!tuning.load_scala(scala_scale_path.buffer(), scala_mapping_path.buffer())) {
+        if (ENABLE_LOGGING) printf("Could not load tuning from %s (%s)\n", scala_scale_path.buffer(), scala_mapping_path.buffer());
+    }
+}
+
 // information
 
 // Get the plugin version, in hexadecimal.
@@ -73,70 +785,264 @@ uint32_t TestSynth::getVersion() const {
 // Processing
 
 void TestSynth::run(const float** /* inputs*/, float** outputs, uint32_t frames, const DISTRHO::MidiEvent* midiEvents, uint32_t midiEventCount) {
-    // process MIDI events
-    for (uint32_t m_idx = 0; m_idx < midiEventCount; ++m_idx) {
-        process_midi_event(midiEvents[m_idx]);
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start_ns = Instrumentation::now();
+    uint64_t midi_ns = 0;
+    uint64_t voices_ns = 0;
+    Denormal_Guard denormal_guard;
+    Realtime_Scope realtime_scope; // aborts on any allocation or lock from here on in an RT_CHECK build
+
+    if (adaptive_polyphony) {
+        active_voices.set_voice_limit(adaptive_voice_limit.get_limit());
+        active_voices.enforce_voice_limit();
     }
 
     // define useful shorthand
     float* const outL = outputs[0];
     float* const outR = outputs[1];
 
-    // play notes
-    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
-        outL[f_idx] = 0;
+    tuning.update();
+    sample_streamer.update();
+
+    if (parameters_changed.exchange(false, std::memory_order_acquire)) {
+        apply_parameters();
+    }
+    modulation.start_block(frames_since_start*oversampling_factor);
+
+    // one ramp buffer per smoothed parameter per block, however much automation arrives
+    const bool gain_smoothing = gain_smoother.is_smoothing();
+    const bool tune_smoothing = fine_tune_smoother.is_smoothing();
+    const bool reverb_on = reverb_level_smoother.is_smoothing() || reverb_level_smoother.get_value() != 0;
+    const float* const gain_ramp = gain_smoother.render(frames);
+    const float* const fine_tune_ramp = fine_tune_smoother.render(frames);
+    const float* const reverb_level_ramp = reverb_level_smoother.render(frames);
+
+    // Idle: nothing sounding, no events that could start anything, and nothing left ringing in the decimators or reverb.
+    // The output is exactly zero, so skip straight to it.
+    if (active_voices.get_live_count() == 0 && midiEventCount == 0 && tail_frames == 0) {
+        std::memset(outL, 0, sizeof(float)*frames);
+        std::memset(outR, 0, sizeof(float)*frames);
+        if (tune_smoothing) {
+            update_tune_coefficient(fine_tune_smoother.get_value());
+        }
+        frames_since_start += frames;
+        modulation.advance_lfos(frames*oversampling_factor);
+        silent_blocks += (silent_blocks < UINT32_MAX) ? 1 : 0;
+
+        const uint64_t end_ns = Instrumentation::now();
+        instrumentation.record(Instrumentation::mixdown, end_ns - start_ns);
+        instrumentation.end_block(end_ns - start_ns, frames/getSampleRate(), 0);
+        return;
+    }
+    silent_blocks = 0;
+
+    // Voices mix into mid in outL and side in outR. With oversampling they mix into their own buses at the internal
+    // rate instead, which are decimated into outL and outR afterwards.
+    const uint32_t factor = oversampling_factor;
+    const bool stereo = unison.is_enabled() || signal_generator.is_panning();
+    float* const mid_bus = (factor > 1) ? oversampled_bus.data() : outL;
+    float* const side_bus = !stereo ? nullptr : (factor > 1) ? oversampled_side_bus.data() : outR;
+    std::memset(mid_bus, 0, sizeof(float)*frames*factor);
+    if (stereo) {
+        std::memset(side_bus, 0, sizeof(float)*frames*factor);
+    }
+
+    // Render in sub-blocks that end at each MIDI event's frame, so every event takes effect on the exact sample.
+    // Expression events (pressure, timbre, mod wheel and MPE pitch bend) are the exception: voices only pick them up at the next
+    // envelope control period anyway, so they wait for it instead of splitting the block, and a dense stream of them
+    // costs at most one split per control period. MIDI events arrive sorted by frame.
+    uint32_t m_idx = 0;
+    uint32_t f_idx = 0;
+    bool rendered_voices = false;
+    uint64_t phase_start_ns = Instrumentation::now();
+    while (f_idx < frames) {
+        while (m_idx < midiEventCount && midiEvents[m_idx].frame <= f_idx) {
+            process_midi_event(midiEvents[m_idx++]);
+        }
+        uint64_t phase_end_ns = Instrumentation::now();
+        midi_ns += phase_end_ns - phase_start_ns;
+        phase_start_ns = phase_end_ns;
+
+        const uint32_t control_period = envelope.get_control_period();
+        uint32_t sub_block_end = frames;
+        for (uint32_t e_idx = m_idx; e_idx < midiEventCount && midiEvents[e_idx].frame < sub_block_end; ++e_idx) {
+            uint32_t event_frame = midiEvents[e_idx].frame;
+            if (is_expression_event(midiEvents[e_idx])) {
+                event_frame += (control_period - uint32_t(frames_since_start + event_frame)) & (control_period - 1);
+            }
+            sub_block_end = std::min(sub_block_end, event_frame);
+        }
+        if (tune_smoothing) {
+            // follow the fine tune ramp every control_period frames, which is too often to hear as steps
+            uint32_t period_end = f_idx + control_period - (uint32_t(frames_since_start + f_idx) & (control_period - 1));
+            sub_block_end = std::min(sub_block_end, period_end);
+            update_tune_coefficient(fine_tune_ramp[f_idx]);
+        }
+
+        rendered_voices |= active_voices.get_live_count() > 0;
+        render_voices(mid_bus + f_idx*factor, stereo ? side_bus + f_idx*factor : nullptr, (sub_block_end - f_idx)*factor, (frames_since_start + f_idx)*factor);
+        active_voices.free_finished_voices();
+        f_idx = sub_block_end;
 
-        for (Active_Notes_it notes_it = active_notes.begin(); notes_it != active_notes.end(); notes_it++) {
-            outL[f_idx] += signal_generator.pop_time_step(notes_it->second);
+        phase_end_ns = Instrumentation::now();
+        voices_ns += phase_end_ns - phase_start_ns;
+        phase_start_ns = phase_end_ns;
+    }
+
+    // events stamped past the end of the block (which hosts shouldn't send) still apply, for the next block
+    while (m_idx < midiEventCount) {
+        process_midi_event(midiEvents[m_idx++]);
+    }
+    midi_ns += Instrumentation::now() - phase_start_ns;
+
+    if (tune_smoothing) {
+        update_tune_coefficient(fine_tune_smoother.get_value());
+    }
+    if (factor > 1) {
+        decimator.process(mid_bus, frames, outL);
+        if (stereo) {
+            side_decimator.process(side_bus, frames, outR);
         }
+    }
+    // the decimators and reverb keep ringing after the last voice stops, so the idle path has to wait for them
+    if (rendered_voices) {
+        tail_frames = decimator.get_tail_frames() + (reverb_on ? reverb.get_tail_frames() : 0);
+    } else {
+        tail_frames -= std::min(tail_frames, frames);
+    }
+    if (gain_smoothing || gain_smoother.get_value() != 1) {
+        multiply_block(outL, gain_ramp, frames);
+        if (stereo) {
+            multiply_block(outR, gain_ramp, frames);
+        }
+    }
 
-        frames_since_start += 1;
-        outR[f_idx] = outL[f_idx]; // plugin is mono for now; stereo may be introduced later
+    frames_since_start += frames;
+    modulation.advance_lfos(frames*factor);
+    if (stereo) {
+        mid_side_to_left_right(outL, outR, frames);
+    } else {
+        std::memcpy(outR, outL, sizeof(float)*frames); // mono
+    }
+    if (reverb_on) {
+        if (!reverb_running) {
+            reverb.clear(); // whatever was left when it last stopped would come back
+            reverb_running = true;
+        }
+        reverb.process(outL, outR, frames, reverb_level_ramp);
+    } else {
+        reverb_running = false;
+    }
+    const uint64_t end_ns = Instrumentation::now();
+
+    // everything that isn't MIDI or voices (clearing and copying the outputs, and the reverb) counts as mixdown
+    instrumentation.record(Instrumentation::midi, midi_ns);
+    instrumentation.record(Instrumentation::voices, voices_ns);
+    instrumentation.record(Instrumentation::mixdown, (end_ns - start_ns) - midi_ns - voices_ns);
+    instrumentation.end_block(end_ns - start_ns, frames/getSampleRate(), active_voices.get_live_count());
+
+    if (adaptive_polyphony) {
+        const double render_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        adaptive_voice_limit.update(render_seconds, frames/getSampleRate(), active_voices.get_live_count());
+    }
+}
+void TestSynth::render_voices(float* mid, float* side, uint32_t frames, uint64_t start_frame) {
+    const uint32_t live_count = active_voices.get_live_count();
+    if (live_count >= threaded_voice_threshold && worker_pool.is_running()) {
+        if (worker_pool.render(signal_generator, active_voices, mid, side, frames, start_frame)) {
+            return;
+        }
+    }
+
+    for (uint32_t v_idx = 0; v_idx < live_count; ++v_idx) {
+        signal_generator.render_block(active_voices, active_voices.get_live_voice(v_idx), mid, side, frames, start_frame);
     }
 }
 void TestSynth::process_midi_event(const DISTRHO::MidiEvent& midi_event) {
     uint8_t message_type = midi_event.data[0] & 0x70;
+    uint8_t channel = midi_event.data[0] & 0x0f; // meaningless for system_common
+    if (message_type == MIDI_Message_Type::note_on && (midi_event.data[2] & 0x7f) == 0) {
+        message_type = MIDI_Message_Type::note_off; // running status keyboards send note off as note on with velocity 0
+    }
     switch (message_type) {
     case MIDI_Message_Type::note_off: {
         uint8_t note_number = midi_event.data[1] & 0x7f;
         // uint8_t release_velocity = midi_event.data[2] & 0x7f; // no effect for release velocity yet
 
-        active_notes.erase(note_number);
+        active_voices.note_off(channel, note_number);
     } break;
     case MIDI_Message_Type::note_on: {
         uint8_t note_number = midi_event.data[1] & 0x7f;
         uint8_t press_velocity = midi_event.data[2] & 0x7f;
 
-        Note new_note = Note(note_number, press_velocity, midi_event.frame);
+        float frequency = tuning.get_note_frequency(note_number);
+        if (frequency <= 0) {
+            break; // key left unmapped by the tuning
+        }
+        int32_t voice = active_voices.note_on(channel, note_number, press_velocity, frequency);
+        if (voice >= 0) {
+            // MPE controllers send the note's initial expression on its channel just before the note
+            const Channel_Expression& expression = mpe_zones.expression[channel];
+            active_voices.bend[voice] = mpe_zones.is_member(channel) ? expression.bend : 1.f;
+            active_voices.pressure[voice] = expression.pressure;
+            active_voices.timbre[voice] = expression.timbre;
+            const float key_position = std::clamp((note_number - 60)/48.f, -1.f, 1.f);
+            active_voices.pan[voice] = std::clamp(voice_pan + pan_spread*key_position, -1.f, 1.f);
+
+            // glide from the last note played on any channel, taking glide_time_s whatever the interval
+            if (glide_time_s > 0 && last_note_frequency > 0 && last_note_frequency != frequency) {
+                float glide_st = 12*std::log2(last_note_frequency/frequency);
+                active_voices.glide_st[voice] = glide_st;
+                active_voices.glide_rate_st[voice] = std::abs(glide_st)/float(glide_time_s*getSampleRate()*oversampling_factor);
+            }
+            last_note_frequency = frequency;
+        }
 
-        if (ENABLE_LOGGING) printf("Note pressed! Note number: %u. Frequency: %f. frames since pressed: %d \n", note_number, new_note.frequency, new_note.frames_since_pressed);
-        
-        active_notes[note_number] = new_note;
+        if (ENABLE_LOGGING) printf("Note pressed! Channel: %u. Note number: %u. Voice: %d. Frame: %u \n", channel, note_number, voice, midi_event.frame);
     } break;
     case MIDI_Message_Type::polyphonic_aftertouch: {
-        // uint8_t note_number = midi_event.data[1] & 0x7f;
-        // uint8_t pressure = midi_event.data[2] & 0x7f;
-        // no effect currently
+        uint8_t note_number = midi_event.data[1] & 0x7f;
+        uint8_t pressure = midi_event.data[2] & 0x7f;
+
+        int32_t voice = active_voices.get_held_voice(channel, note_number);
+        if (voice >= 0) {
+            active_voices.pressure[voice] = pressure/127.f;
+        }
     } break;
     case MIDI_Message_Type::control_change: {
-        // uint8_t control_number = midi_event.data[1] & 0x7f;
-        // uint8_t value = midi_event.data[2] & 0x7f;
-        // no effect currently
+        uint8_t control_number = midi_event.data[1] & 0x7f;
+        uint8_t value = midi_event.data[2] & 0x7f;
+
+        if (mpe_zones.control_change(channel, control_number, value)) {
+            active_voices.release_all(); // the zones were reconfigured
+        }
+        if (control_number == 1) {
+            modulation.set_mod_wheel(value/127.f);
+        } else if (control_number == 74) {
+            mpe_zones.expression[channel].timbre = value/127.f;
+            set_held_voices(channel, active_voices.timbre, value/127.f);
+        }
     } break;
     case MIDI_Message_Type::program_change: {
         // uint8_t program = midi_event.data[1] & 0x7f;
         // no effect currently
     } break;
     case MIDI_Message_Type::channel_aftertouch: {
-        // uint8_t pressure = midi_event.data[1] & 0x7f;
-        // no effect currently
+        uint8_t pressure = midi_event.data[1] & 0x7f;
+
+        mpe_zones.expression[channel].pressure = pressure/127.f;
+        set_held_voices(channel, active_voices.pressure, pressure/127.f);
     } break;
     case MIDI_Message_Type::pitch_bend: {
         uint8_t LSB = midi_event.data[1] & 0x7f;
         uint8_t MSB = midi_event.data[2] & 0x7f;
         uint16_t pitch_bend = (MSB << 7) + LSB;
 
-        update_frequency_coefficient(pitch_bend);
+        if (mpe_zones.is_member(channel)) {
+            set_held_voices(channel, active_voices.bend, mpe_zones.member_pitch_bend(channel, pitch_bend));
+        } else {
+            update_frequency_coefficient(pitch_bend);
+        }
     } break;
     case MIDI_Message_Type::system_common: {
         // no effect currently
@@ -146,6 +1052,30 @@ void TestSynth::process_midi_event(const DISTRHO::MidiEvent& midi_event) {
         break;
     }
 }
+// Released voices keep the expression they had at note off, since MPE controllers reuse the channel for later notes
+void TestSynth::set_held_voices(uint8_t channel, std::vector<float>& per_voice, float value) {
+    for (uint32_t v_idx = 0; v_idx < active_voices.get_live_count(); ++v_idx) {
+        uint32_t voice = active_voices.get_live_voice(v_idx);
+        if (active_voices.channel[voice] == channel && active_voices.is_held(voice)) {
+            per_voice[voice] = value;
+        }
+    }
+}
+bool TestSynth::is_expression_event(const DISTRHO::MidiEvent& midi_event) const {
+    uint8_t message_type = midi_event.data[0] & 0x70;
+    uint8_t channel = midi_event.data[0] & 0x0f;
+    switch (message_type) {
+    case MIDI_Message_Type::polyphonic_aftertouch:
+    case MIDI_Message_Type::channel_aftertouch:
+        return true;
+    case MIDI_Message_Type::control_change:
+        return (midi_event.data[1] & 0x7f) == 1 || (midi_event.data[1] & 0x7f) == 74; // mod wheel and timbre
+    case MIDI_Message_Type::pitch_bend:
+        return mpe_zones.is_member(channel); // global pitch bend keeps sample-accurate timing
+    default:
+        return false;
+    }
+}
 
 // entry point for DPF plugins
 Plugin* DISTRHO::createPlugin() {
@@ -19,9 +19,26 @@ PERFORMANCE OF THIS SOFTWARE.
 */
 
 #include "../../DPF/distrho/DistrhoPlugin.hpp"
-#include <unordered_map>
 
+#include <atomic>
+
+#include <additive.hpp>
+#include <arena.hpp>
+#include <fm.hpp>
+#include <instrumentation.hpp>
+#include <modulation.hpp>
+#include <mpe.hpp>
 #include <oscillators.hpp>
+#include <oversampling.hpp>
+#include <parameters.hpp>
+#include <reverb.hpp>
+#include <rt_check.hpp>
+#include <sampler.hpp>
+#include <shared_tables.hpp>
+#include <tuning.hpp>
+#include <unison.hpp>
+#include <voices.hpp>
+#include <worker_pool.hpp>
 
 class TestSynth : public DISTRHO::Plugin {
 public:
@@ -47,6 +64,15 @@ virtual uint32_t getVersion() const override; // set in cpp file as it needs to
 // Processing
 virtual void run(const float** inputs, float** outputs, uint32_t frames, const DISTRHO::MidiEvent* midiEvents, uint32_t midiEventCount) override;
 
+// parameters
+virtual void initParameter(uint32_t index, DISTRHO::Parameter& parameter) override;
+virtual float getParameterValue(uint32_t index) const override;
+virtual void setParameterValue(uint32_t index, float value) override;
+
+// state
+virtual void initState(uint32_t index, DISTRHO::State& state) override;
+virtual void setState(const char* key, const char* value) override;
+
 // misc
 virtual void activate() override;
 virtual void deactivate() override;
@@ -54,6 +80,76 @@ virtual void sampleRateChanged (double newSampleRate) override;
 
 void update_frequency_coefficient(uint16_t new_frequency_value);
 
+struct Parameter_Index {enum parameter_index : uint32_t {
+    gain,
+    pitch_bend_range,
+    fine_tune,
+    waveform,
+    attack,
+    decay,
+    sustain,
+    release,
+    oversampling,
+    unison_voices,
+    unison_detune,
+    unison_spread,
+    mpe_layout,
+    pressure_depth,
+    control_rate,
+    glide_time,
+    lfo_1_rate,
+    lfo_1_shape,
+    lfo_2_rate,
+    lfo_2_shape,
+    mod_1_source,
+    mod_1_destination,
+    mod_1_amount,
+    mod_2_source,
+    mod_2_destination,
+    mod_2_amount,
+    mod_3_source,
+    mod_3_destination,
+    mod_3_amount,
+    mod_4_source,
+    mod_4_destination,
+    mod_4_amount,
+    additive_preset,
+    additive_partials,
+    additive_tilt,
+    fm_algorithm,
+    fm_feedback,
+    op_1_ratio,
+    op_1_level,
+    op_2_ratio,
+    op_2_level,
+    op_3_ratio,
+    op_3_level,
+    op_4_ratio,
+    op_4_level,
+    op_5_ratio,
+    op_5_level,
+    op_6_ratio,
+    op_6_level,
+    pan,
+    pan_spread,
+    reverb_level,
+    reverb_size,
+    reverb_decay,
+    reverb_damping,
+    reverb_lines,
+    worker_threads,
+    max_polyphony,
+    adaptive_polyphony,
+    count,
+};};
+
+struct State_Index {enum state_index : uint32_t {
+    scala_scale,
+    scala_mapping,
+    sample_library,
+    count,
+};};
+
 struct MIDI_Message_Type {enum MIDI_message_type : uint8_t {
     note_off             = 0x00,
     note_on              = 0x10,
@@ -68,18 +164,113 @@ struct MIDI_Message_Type {enum MIDI_message_type : uint8_t {
 
 // processing (internal)
 void process_midi_event(const DISTRHO::MidiEvent& midi_event);
+void set_held_voices(uint8_t channel, std::vector<float>& per_voice, float value); // expression for one channel's notes
+bool is_expression_event(const DISTRHO::MidiEvent& midi_event) const; // only needs control-rate timing (see run())
+void render_voices(float* mid, float* side, uint32_t frames, uint64_t start_frame); // render every live voice, adding to mid and side
+void apply_parameters(); // pick up values set by the host since the last block
+void update_tune_coefficient(float cents);
+void set_oversampling(uint32_t factor); // voices render at factor times the host rate
 
 // properties
 double sample_period;
 uint64_t frames_since_start;
 
-float frequency_coefficient;
-const float max_frequency_coefficient_st = 2; // maximum deviation from center frequency in semitones
+float frequency_coefficient; // bend_coefficient*tune_coefficient, applied to every voice
+float bend_coefficient;
+float tune_coefficient;
+uint16_t pitch_bend_value = 0x2000; // last 14-bit pitch bend received, kept to rescale when the range changes
+float max_frequency_coefficient_st = default_pitch_bend_range_st; // maximum deviation from center frequency in semitones
+const Pitch_Bend_Table* pitch_bend_table = &default_pitch_bend_table; // built for default_pitch_bend_range_st
+Pitch_Bend_Table custom_pitch_bend_table; // pitch_bend_table for any other range, refilled when the range changes
+
+// Written by the host through setParameterValue(), possibly from another thread; run() applies them once per block
+std::atomic<float> parameter_values[Parameter_Index::count];
+std::atomic<bool> parameters_changed{true};
+
+const float smoothing_time_s = 0.02;
+Smoothed_Parameter gain_smoother;      // linear gain, applied to the mixed output
+Smoothed_Parameter fine_tune_smoother; // cents, applied to the frequency coefficient every envelope control period
+
+Tuning tuning;
+DISTRHO::String scala_scale_path;
+DISTRHO::String scala_mapping_path;
+
+uint32_t max_polyphony = 64; // number of voices preallocated in activate()
+static const uint32_t max_polyphony_limit = 256;
+Voice_Pool active_voices; // Information about currently active notes; see voices.hpp
+Voice_Steal_Policy steal_policy = Voice_Steal_Policy::released_first;
+
+// Channel pressure, polyphonic aftertouch and CC74 reach individual voices on any channel. Pitch bend does too on MPE
+// member channels; elsewhere it stays global through frequency_coefficient.
+MPE_Zones mpe_zones;
+
+Instrumentation instrumentation; // does nothing unless built with INSTRUMENTATION=true
 
-std::unordered_map<uint8_t, Note> active_notes; // Information about currently active notes, indexed by the note number
-typedef std::unordered_map<uint8_t, Note>::iterator Active_Notes_it;
+bool adaptive_polyphony = false; // lower the voice limit when run() gets close to its deadline
+Adaptive_Voice_Limit adaptive_voice_limit;
+
+uint32_t worker_threads = 0; // extra threads rendering voices alongside the audio thread; 0 renders everything on the audio thread
+static const uint32_t max_worker_threads = 16;
+const uint32_t threaded_voice_threshold = 24; // below this many live voices, threading costs more than it saves
+Voice_Worker_Pool worker_pool;
+
+uint32_t oversampling_factor = 1;
+Decimator decimator;
+Decimator side_decimator;
+std::vector<float> oversampled_bus; // voices mix here at the oversampled rate before decimation
+std::vector<float> oversampled_side_bus;
+
+// Blocks with no voices and no MIDI only clear the outputs. silent_blocks counts consecutive blocks that did,
+// so later stages can skip their work as well; tail_frames counts down until the decimators have flushed.
+uint32_t silent_blocks = 0;
+uint32_t tail_frames = 0;
+
+// Voices mix into a mid/side pair, which becomes left/right at the end of run(). Only unison and panned voices have
+// any side, so while both are off the side channel is skipped entirely and the output is mono.
+Unison unison;
+uint32_t unison_copies = 1;
+float unison_detune_ct = 20;
+float unison_spread = 0.5;
+
+float voice_pan = 0;   // -1 left to 1 right, for every note
+float pan_spread = 0;  // keys pan apart from middle C, reaching this much of the way out at C0 and C8
+
+// Sources routed to pitch, amplitude and pulse width, evaluated per voice once per envelope control period
+Modulation_Matrix modulation;
+float glide_time_s = 0;         // portamento from the previous note, 0 for none
+float last_note_frequency = 0;  // where the next note glides from
 
 Signal_Generator signal_generator;
-Oscillator* sin_osc;
+Envelope envelope;
+float attack_time_s = 0.005;
+float decay_time_s = 0.1;
+float sustain_level = 0.8;
+float release_time_s = 0.2;
+Waveform waveform = Waveform::sine;
+Oscillator* oscillators[uint8_t(Waveform::count)]; // one of each, so changing waveform never allocates
+Object_Arena oscillator_arena; // holds the oscillators, from activate() to deactivate()
+
+// Shared with every other instance through Table_Registry, and held until this one is destroyed
+std::shared_ptr<const Wavetable> saw_table; // also used by the pulse oscillator
+std::shared_ptr<const Wavetable> triangle_table;
+
+// Harmonics for the additive waveform, rebuilt when its parameters change
+Additive_Spectrum additive_spectrum;
+Additive_Preset additive_preset = Additive_Preset::saw;
+uint32_t additive_partials = 256;
+float additive_tilt_db = 0;
+
+// Operators for the FM waveform; cheap to set, so it's updated with every parameter change
+FM_Patch fm_patch;
+
+// Multisample library for the sample waveform, streamed from disk (see sampler.hpp)
+Sample_Streamer sample_streamer;
+
+// Added to the stereo output after the gain, at the host rate. Off while the level is 0.
+Reverb reverb;
+Smoothed_Parameter reverb_level_smoother;
+bool reverb_running = false; // processed the last block; the tail is cleared before it starts again
+
+Oscillator* create_oscillator(Waveform waveform_in);
 };
 
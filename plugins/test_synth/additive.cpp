@@ -0,0 +1,91 @@
+/*
+additive.cpp
+Additive synthesis spectra for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "additive.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// drawbar registration for the organ preset, as harmonics of the 8' fundamental: 8', 4', 2 2/3', 2', 1 3/5', 1 1/3', 1'
+static const uint32_t organ_harmonics[] = {1, 2, 3, 4, 5, 6, 8};
+static const uint8_t organ_drawbars[] = {8, 8, 6, 6, 4, 4, 3}; // each step down is 3 dB quieter
+
+// power of a full-band saw, sum of (2/(pi*k))^2, so the presets are as loud as the saw waveform
+static const float saw_power = 2.f/3;
+
+static float preset_harmonic(Additive_Preset preset, uint32_t harmonic) {
+    switch (preset) {
+    case Additive_Preset::square:
+        return (harmonic % 2) ? float(4/(M_PI*harmonic)) : 0.f;
+    case Additive_Preset::organ:
+        for (uint32_t d_idx = 0; d_idx < sizeof(organ_harmonics)/sizeof(organ_harmonics[0]); ++d_idx) {
+            if (organ_harmonics[d_idx] == harmonic) {
+                return std::pow(10.f, -3.f*(8 - organ_drawbars[d_idx])/20);
+            }
+        }
+        return 0;
+    case Additive_Preset::saw:
+    default:
+        // same phase as the saw wavetable (see wavetables.cpp)
+        return float((harmonic % 2) ? 2/(M_PI*harmonic) : -2/(M_PI*harmonic));
+    }
+}
+
+Additive_Spectrum::Additive_Spectrum() {
+    set_preset(Additive_Preset::saw, 256, 0);
+}
+
+void Additive_Spectrum::set_preset(Additive_Preset preset, uint32_t partials, float tilt_db_per_octave) {
+    partial_count = std::min(partials, max_partials);
+    const float tilt_exponent = tilt_db_per_octave/(20*std::log10(2.f)); // amplitude is harmonic^tilt_exponent
+    float power = 0;
+    for (uint32_t p_idx = 0; p_idx < max_partials; ++p_idx) {
+        const uint32_t harmonic = p_idx + 1;
+        amplitudes[p_idx] = (p_idx < partial_count) ? preset_harmonic(preset, harmonic)*std::pow(float(harmonic), tilt_exponent) : 0.f;
+        power += amplitudes[p_idx]*amplitudes[p_idx];
+    }
+    const float scale = (power > 0) ? std::sqrt(saw_power/power) : 0.f;
+    for (uint32_t p_idx = 0; p_idx < partial_count; ++p_idx) {
+        amplitudes[p_idx] *= scale;
+    }
+}
+
+void Additive_Spectrum::set_amplitudes(const float* amplitudes_in, uint32_t count) {
+    partial_count = std::min(count, max_partials);
+    std::copy(amplitudes_in, amplitudes_in + partial_count, amplitudes);
+    std::fill(amplitudes + partial_count, amplitudes + max_partials, 0.f);
+}
+
+uint32_t Additive_Spectrum::band_limit(uint32_t increment, float* out) const {
+    // harmonic k is at k*increment/2^32 cycles per frame, and nyquist is half a cycle
+    uint32_t audible = partial_count;
+    if (increment > 0) {
+        audible = std::min(audible, 0x7fffffffu/increment);
+    }
+    const float nyquist_fraction = float(increment)*(1.f/2147483648.f); // of the first harmonic; harmonic k is at k times this
+    for (uint32_t p_idx = 0; p_idx < audible; ++p_idx) {
+        const float fade = (1 - float(p_idx + 1)*nyquist_fraction)*(1/band_fade);
+        out[p_idx] = amplitudes[p_idx]*std::min(fade, 1.f);
+    }
+
+    const uint32_t padded = (audible + additive_chains - 1) & ~(additive_chains - 1);
+    std::fill(out + audible, out + padded, 0.f);
+    return padded;
+}
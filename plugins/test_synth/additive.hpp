@@ -0,0 +1,61 @@
+/*
+additive.hpp
+Additive synthesis spectra for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "kernels.hpp"
+
+enum class Additive_Preset : uint8_t {
+    saw,    // every harmonic at 1/k
+    square, // odd harmonics at 1/k
+    organ,  // a few harmonics at drawbar levels
+    count,
+};
+
+class Additive_Spectrum {
+    // The amplitudes of up to max_partials harmonics for the additive oscillator, which sums them directly instead of
+    // reading a table, so any spectrum is band-limited exactly at any pitch. Fixed size, so changing it never
+    // allocates; only change it between blocks.
+    public:
+    static const uint32_t max_partials = 512;
+
+    Additive_Spectrum();
+
+    // Build one of the presets from its first `partials` harmonics, tilted by tilt_db_per_octave, at the same power as
+    // a saw whatever the settings. Calls pow() for each harmonic, so only when the settings change.
+    void set_preset(Additive_Preset preset, uint32_t partials, float tilt_db_per_octave);
+    // Set the harmonics directly, e.g. from the analysis of a recording; harmonics past `count` are silent
+    void set_amplitudes(const float* amplitudes_in, uint32_t count);
+
+    uint32_t get_partial_count() const { return partial_count; }
+    const float* get_amplitudes() const { return amplitudes; }
+
+    // Write the amplitudes to play at a phase increment to `out` (max_partials entries), and return the count for
+    // Additive_Partials. Harmonics at or above nyquist are left out, and the ones in the top band_fade of the band
+    // fade out towards it, so they come and go smoothly as the pitch moves.
+    uint32_t band_limit(uint32_t increment, float* out) const;
+    static constexpr float band_fade = 0.25f;
+
+    protected:
+    float amplitudes[max_partials]; // harmonic k + 1
+    uint32_t partial_count;
+};
@@ -0,0 +1,78 @@
+/*
+address_wait.cpp
+Sleeping on an atomic word for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "address_wait.hpp"
+
+#if defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+// What libc++ uses for atomic wait and notify; public since macOS 10.12, though not in any header
+extern "C" int __ulock_wait(uint32_t operation, void* address, uint64_t value, uint32_t timeout_us);
+extern "C" int __ulock_wake(uint32_t operation, void* address, uint64_t wake_value);
+static const uint32_t ulock_compare_and_wait = 1;
+static const uint32_t ulock_wake_all = 0x100;
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0602
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0602 // WaitOnAddress is Windows 8 and later
+#endif
+#include <windows.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the word waited on must be a plain 32-bit integer");
+
+void wait_on_address(std::atomic<uint32_t>& word, uint32_t value) {
+    uint32_t* address = reinterpret_cast<uint32_t*>(&word);
+#if defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#elif defined(__APPLE__)
+    __ulock_wait(ulock_compare_and_wait, address, value, 0);
+#elif defined(_WIN32)
+    WaitOnAddress(address, &value, sizeof(value), INFINITE);
+#else
+    (void)address;
+    if (word.load() == value) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+#endif
+}
+
+void wake_address(std::atomic<uint32_t>& word) {
+    uint32_t* address = reinterpret_cast<uint32_t*>(&word);
+#if defined(__linux__)
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#elif defined(__APPLE__)
+    __ulock_wake(ulock_compare_and_wait | ulock_wake_all, address, 0);
+#elif defined(_WIN32)
+    WakeByAddressAll(address);
+#else
+    (void)address;
+#endif
+}
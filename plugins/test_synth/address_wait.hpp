@@ -0,0 +1,32 @@
+/*
+address_wait.hpp
+Sleeping on an atomic word for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Sleep until another thread changes a 32-bit atomic and wakes the waiters, like C++20's atomic wait and notify:
+// a futex on Linux, __ulock on macOS and WaitOnAddress on Windows. Anywhere else the wait sleeps for a millisecond
+// and returns. Waking is a single system call that never blocks, so the audio thread can do it.
+
+// Returns once word may no longer be value, or spuriously; check again and wait again as needed
+void wait_on_address(std::atomic<uint32_t>& word, uint32_t value);
+void wake_address(std::atomic<uint32_t>& word); // every thread waiting on word
@@ -0,0 +1,61 @@
+/*
+arena.cpp
+DSP object arena for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "arena.hpp"
+
+Object_Arena::~Object_Arena() {
+    free_storage();
+}
+
+void Object_Arena::allocate(size_t capacity_in) {
+    free_storage();
+    block = static_cast<uint8_t*>(::operator new(capacity_in, std::align_val_t(block_alignment)));
+    capacity = capacity_in;
+}
+
+void Object_Arena::free_storage() {
+    destroy_all();
+    if (block != nullptr) {
+        ::operator delete(block, std::align_val_t(block_alignment));
+    }
+    block = nullptr;
+    capacity = 0;
+}
+
+void Object_Arena::destroy_all() {
+    for (Object_Header* header = newest; header != nullptr; header = header->previous) {
+        header->destroy(header->object);
+    }
+    newest = nullptr;
+    used = 0;
+}
+
+void* Object_Arena::reserve(size_t size, size_t alignment, void (*destroy)(void* object)) {
+    auto align = [](size_t offset, size_t to) { return (offset + to - 1)/to*to; };
+    const size_t header_offset = align(used, alignof(Object_Header));
+    const size_t object_offset = align(header_offset + sizeof(Object_Header), alignment);
+    if (block == nullptr || object_offset + size > capacity) {
+        return nullptr;
+    }
+    Object_Header* header = new (block + header_offset) Object_Header{destroy, block + object_offset, newest};
+    newest = header;
+    used = object_offset + size;
+    return header->object;
+}
@@ -0,0 +1,75 @@
+/*
+arena.hpp
+DSP object arena for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+class Object_Arena {
+    // One block of memory, allocated up front, that objects are constructed in one after another, so creating them
+    // afterwards never touches the heap. Objects stay where they are until destroy_all(), which runs their destructors,
+    // newest first, and keeps the block for the next lot.
+    public:
+    Object_Arena() {}
+    ~Object_Arena();
+    Object_Arena(const Object_Arena&) = delete;
+    Object_Arena& operator=(const Object_Arena&) = delete;
+
+    // Bytes that one of each of Types is sure to fit in, wherever the arena is up to
+    template <typename... Types>
+    static constexpr size_t get_size_for() {
+        return (size_t(0) + ... + (sizeof(Object_Header) + alignof(Object_Header) - 1 + sizeof(Types) + alignof(Types) - 1));
+    }
+
+    void allocate(size_t capacity_in); // not RT safe; destroys whatever is in the arena
+    void free_storage();               // not RT safe; destroys whatever is in the arena
+    void destroy_all();
+
+    // A new T made from arguments, or nullptr if it doesn't fit (the arena was allocated too small)
+    template <typename T, typename... Arguments>
+    T* create(Arguments&&... arguments) {
+        static_assert(alignof(T) <= block_alignment, "the arena's block isn't aligned enough for this type");
+        void* memory = reserve(sizeof(T), alignof(T), [](void* object) { static_cast<T*>(object)->~T(); });
+        return (memory != nullptr) ? new (memory) T(std::forward<Arguments>(arguments)...) : nullptr;
+    }
+
+    size_t get_used() const { return used; }
+    size_t get_capacity() const { return capacity; }
+
+    protected:
+    static const size_t block_alignment = 64;
+
+    // In front of every object, linking them newest first
+    struct Object_Header {
+        void (*destroy)(void* object);
+        void* object;
+        Object_Header* previous;
+    };
+
+    void* reserve(size_t size, size_t alignment, void (*destroy)(void* object));
+
+    uint8_t* block = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    Object_Header* newest = nullptr;
+};
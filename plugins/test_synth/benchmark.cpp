@@ -0,0 +1,807 @@
+/*
+benchmark.cpp
+Standalone DSP benchmark for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+// Runs the oscillator kernels and the whole TestSynth::run() without a plugin host or plugin format wrapper,
+// sweeping polyphony, buffer size and sample rate, and prints one CSV row per measurement.
+// Build and run with `make bench`. Pass --quick for a shorter sweep, and --kernels NAME (scalar, sse2, avx2 or avx512)
+// to force one kernel set; otherwise the oscillators are measured with every set the CPU supports.
+// --record DIR and --check DIR run the golden-render regression instead (see record_regression()).
+
+#include "src/DistrhoPlugin.cpp"
+#if __has_include("src/DistrhoUtils.cpp")
+#include "src/DistrhoUtils.cpp"
+#endif
+
+#include "TestSynth.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t read_cycle_counter() { return __rdtsc(); } // reference cycles, not core cycles
+static const bool have_cycle_counter = true;
+#else
+static inline uint64_t read_cycle_counter() { return 0; }
+static const bool have_cycle_counter = false;
+#endif
+
+// enough work per measurement for the timer resolution not to matter
+static const uint64_t min_voice_frames = 1 << 21;
+
+struct Measurement {
+    double ns_per_frame;
+    double cycles_per_frame;
+};
+
+static void print_header() {
+    printf("benchmark,kernel,voices,frames,sample_rate,ns_per_frame,ns_per_voice_frame,cycles_per_frame,max_error\n");
+}
+
+static void print_row(const char* benchmark, const char* kernel, uint32_t voices, uint32_t frames, double sample_rate, const Measurement& m, double max_error) {
+    printf("%s,%s,%u,%u,%.0f,%.3f,", benchmark, kernel, voices, frames, sample_rate, m.ns_per_frame);
+    if (voices > 0) printf("%.4f", m.ns_per_frame/voices);
+    printf(",");
+    if (have_cycle_counter) printf("%.2f", m.cycles_per_frame);
+    printf(",");
+    if (max_error >= 0) printf("%.3g", max_error);
+    printf("\n");
+}
+
+// Call `block` (which renders `frames` frames) until enough work has been done, after one warm-up call.
+template <typename Block>
+static Measurement measure(uint32_t voices, uint32_t frames, Block block) {
+    block();
+
+    uint64_t blocks = min_voice_frames/(uint64_t(voices)*frames) + 1;
+    auto start_time = std::chrono::steady_clock::now();
+    uint64_t start_cycles = read_cycle_counter();
+    for (uint64_t b = 0; b < blocks; ++b) {
+        block();
+    }
+    uint64_t cycles = read_cycle_counter() - start_cycles;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+
+    Measurement m;
+    m.ns_per_frame = ns/(blocks*frames);
+    m.cycles_per_frame = double(cycles)/(blocks*frames);
+    return m;
+}
+
+// Spread voices over the keyboard so that they all have different increments.
+static uint8_t note_for_voice(uint32_t voice) {
+    return uint8_t(24 + (voice*37) % 84);
+}
+
+static void bench_oscillator(const char* kernel, Oscillator* oscillator, Oscillator* reference, uint32_t voices, uint32_t frames, double sample_rate) {
+    std::vector<uint32_t> phases(voices, 0);
+    std::vector<uint32_t> increments(voices);
+    for (uint32_t v = 0; v < voices; ++v) {
+        increments[v] = phase_increment_from_frequency(Voice_Pool::get_frequency_from_note_number(note_for_voice(v)), 1/sample_rate);
+    }
+    std::vector<float> out(frames);
+    // oscillators with per-voice state (FM operators) find it in a Voice_Pool, with a note per voice
+    Voice_Pool pool;
+    if (oscillator->has_voice_state()) {
+        pool.allocate(voices);
+        for (uint32_t v = 0; v < voices; ++v) {
+            pool.note_on(v & 0x0f, uint8_t(v >> 4), 127, 0);
+        }
+    }
+
+    Measurement m = measure(voices, frames, [&]() {
+        std::memset(out.data(), 0, sizeof(float)*frames);
+        for (uint32_t v = 0; v < voices; ++v) {
+            if (oscillator->has_voice_state()) {
+                oscillator->render_voice_block(out.data(), frames, pool, pool.get_live_voice(v), increments[v], 1.f/voices, 0);
+            } else {
+                oscillator->render_block(out.data(), frames, phases[v], increments[v], 1.f/voices, 0, 0);
+            }
+        }
+    });
+
+    // compare one block of a single voice against the per-frame reference
+    double max_error = -1;
+    if (reference != nullptr) {
+        std::vector<float> fast(frames, 0), slow(frames, 0);
+        uint32_t fast_phase = 0x12345678, slow_phase = 0x12345678;
+        if (oscillator->has_voice_state()) {
+            Voice_Pool single;
+            single.allocate(1);
+            const uint32_t voice = single.note_on(0, 0, 127, 0);
+            slow_phase = 0; // a new note's first operators start from phase 0
+            oscillator->render_voice_block(fast.data(), frames, single, voice, increments[0], 1, 0);
+        } else {
+            oscillator->render_block(fast.data(), frames, fast_phase, increments[0], 1, 0, 0);
+        }
+        reference->render_block(slow.data(), frames, slow_phase, increments[0], 1, 0, 0);
+        max_error = 0;
+        for (uint32_t f = 0; f < frames; ++f) {
+            max_error = std::max(max_error, (double)std::fabs(fast[f] - slow[f]));
+        }
+    }
+
+    print_row("oscillator", kernel, voices, frames, sample_rate, m, max_error);
+}
+
+// the additive oscillator's per-frame sin() sum, through the generic render path
+class Additive_Reference : public Additive_Oscillator {
+    public:
+    using Additive_Oscillator::Additive_Oscillator;
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) override {
+        Oscillator::render_block(out, frames, phase, increment, amplitude, amplitude_step, duty_offset);
+    }
+};
+
+// FM through evaluate(), which only matches whole-number ratios without feedback
+class FM_Reference : public FM_Oscillator {
+    public:
+    using FM_Oscillator::FM_Oscillator;
+    virtual bool has_voice_state() const override { return false; }
+};
+
+// A one-region library in the temp directory: a 16-bit saw rooted at c6, so the benchmark notes play it at no more than
+// four times its own speed, and all in the head, so the prefetch thread has nothing to do.
+// Returns the SFZ path, or "" if it can't be written.
+static std::string write_sample_library() {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path()/"test_synth_benchmark";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    FILE* wav = fopen((directory/"saw.wav").string().c_str(), "wb");
+    FILE* sfz = fopen((directory/"saw.sfz").string().c_str(), "w");
+    if (wav == nullptr || sfz == nullptr) {
+        if (wav != nullptr) fclose(wav);
+        if (sfz != nullptr) fclose(sfz);
+        return std::string();
+    }
+
+    const uint32_t rate = 48000;
+    const uint32_t frames = Sample_Library::head_frames;
+    auto put = [wav](uint32_t value, uint32_t bytes) {
+        for (uint32_t b_idx = 0; b_idx < bytes; ++b_idx) {
+            fputc((value >> (8*b_idx)) & 0xff, wav);
+        }
+    };
+    fwrite("RIFF", 1, 4, wav);
+    put(36 + 2*frames, 4);
+    fwrite("WAVEfmt ", 1, 8, wav);
+    put(16, 4);
+    put(1, 2);      // PCM
+    put(1, 2);      // mono
+    put(rate, 4);
+    put(2*rate, 4); // bytes per second
+    put(2, 2);      // bytes per frame
+    put(16, 2);
+    fwrite("data", 1, 4, wav);
+    put(2*frames, 4);
+    const float period = rate/Voice_Pool::get_frequency_from_note_number(84);
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        const float cycle = f_idx/period - std::floor(f_idx/period);
+        put(uint16_t(int16_t(std::lround(16000*(2*cycle - 1)))), 2);
+    }
+    fclose(wav);
+
+    fprintf(sfz, "<region> sample=saw.wav pitch_keycenter=c6\n");
+    fclose(sfz);
+    return (directory/"saw.sfz").string();
+}
+
+// Every note starts over at each block, so this measures the interpolation from the in-memory heads rather than
+// racing the prefetch thread; frames from the rings go through the same loop.
+static void bench_sample(Sample_Streamer& streamer, uint32_t voices, uint32_t frames, double sample_rate) {
+    Voice_Pool pool;
+    pool.allocate(voices);
+    std::vector<uint32_t> increments(voices);
+    for (uint32_t v = 0; v < voices; ++v) {
+        increments[v] = phase_increment_from_frequency(Voice_Pool::get_frequency_from_note_number(note_for_voice(v)), 1/sample_rate);
+    }
+    std::vector<float> out(frames);
+
+    Measurement m = measure(voices, frames, [&]() {
+        std::memset(out.data(), 0, sizeof(float)*frames);
+        for (uint32_t v = 0; v < voices; ++v) {
+            const int32_t voice = pool.note_on(v & 0x0f, uint8_t(v >> 4), 127, 0); // the same note again restarts it
+            streamer.render(out.data(), frames, pool, voice, increments[v], 1.f/voices, 0);
+        }
+    });
+    print_row("oscillator", "sample", voices, frames, sample_rate, m, -1);
+}
+
+// The reverb bus on its own at full level, over noise; the voices column holds the number of delay lines
+static void bench_reverb(const char* kernel, uint32_t lines, uint32_t frames, double sample_rate) {
+    Reverb reverb;
+    reverb.allocate(sample_rate);
+    reverb.set_parameters(lines, 0.5f, 2, 0.5f);
+    std::vector<float> input(frames), left(frames), right(frames), wet_gains(frames, 1.f);
+    uint32_t seed = 1;
+    for (float& sample : input) {
+        seed = seed*1664525 + 1013904223;
+        sample = int32_t(seed)/4294967296.f;
+    }
+
+    Measurement m = measure(lines, frames, [&]() {
+        std::memcpy(left.data(), input.data(), sizeof(float)*frames);
+        std::memcpy(right.data(), input.data(), sizeof(float)*frames);
+        reverb.process(left.data(), right.data(), frames, wet_gains.data());
+    });
+    print_row("reverb", kernel, lines, frames, sample_rate, m, -1);
+}
+
+class Benchmark_Synth : public TestSynth {
+    // exposes what a host would call, plus the live voice count
+    public:
+    using TestSynth::activate;
+    using TestSynth::deactivate;
+    using TestSynth::run;
+    using TestSynth::setParameterValue;
+    using TestSynth::Parameter_Index;
+    using TestSynth::max_worker_threads;
+    uint32_t get_live_count() const { return active_voices.get_live_count(); }
+};
+
+// Measure run() with `voices` notes held; `sounding` is set to how many voices actually play
+static Measurement measure_run(uint32_t voices, uint32_t frames, double sample_rate, uint32_t threads, uint32_t oversampling, uint32_t unison, uint32_t& sounding) {
+    // the Plugin constructor picks these up, as it would from a host wrapper
+    DISTRHO::d_nextBufferSize = frames;
+    DISTRHO::d_nextSampleRate = sample_rate;
+    Benchmark_Synth plugin;
+    plugin.setParameterValue(Benchmark_Synth::Parameter_Index::worker_threads, threads);
+    plugin.setParameterValue(Benchmark_Synth::Parameter_Index::oversampling, oversampling); // 2^oversampling times the host rate
+    plugin.setParameterValue(Benchmark_Synth::Parameter_Index::unison_voices, unison);
+    plugin.activate();
+
+    std::vector<float> left(frames), right(frames);
+    float* outputs[2] = { left.data(), right.data() };
+
+    // press every note in the first block, leaving out duplicates
+    std::vector<DISTRHO::MidiEvent> note_ons;
+    bool pressed[128] = {};
+    for (uint32_t v = 0; v < voices; ++v) {
+        uint8_t note = note_for_voice(v);
+        for (uint32_t n = 0; pressed[note] && n < 128; ++n) {
+            note = (note + 1) & 0x7f;
+        }
+        if (pressed[note]) {
+            break;
+        }
+        pressed[note] = true;
+
+        DISTRHO::MidiEvent event = {};
+        event.frame = 0;
+        event.size = 3;
+        event.data[0] = 0x90;
+        event.data[1] = note;
+        event.data[2] = 100;
+        note_ons.push_back(event);
+    }
+    plugin.run(nullptr, outputs, frames, note_ons.data(), note_ons.size());
+
+    // the synth's polyphony limit may be below the requested voice count; report what is actually sounding
+    sounding = plugin.get_live_count();
+    Measurement m = measure(std::max(sounding, 1u), frames, [&]() {
+        plugin.run(nullptr, outputs, frames, nullptr, 0);
+    });
+
+    plugin.deactivate();
+    return m;
+}
+
+static void bench_run(uint32_t voices, uint32_t frames, double sample_rate, uint32_t threads, uint32_t oversampling = 0, uint32_t unison = 1) {
+    uint32_t sounding;
+    Measurement m = measure_run(voices, frames, sample_rate, threads, oversampling, unison, sounding);
+
+    char kernel[48];
+    if (voices == 0) {
+        snprintf(kernel, sizeof(kernel), "TestSynth_idle");
+    } else if (oversampling > 0) {
+        snprintf(kernel, sizeof(kernel), "TestSynth_%u_workers_%ux", threads, 1u << oversampling);
+    } else if (unison > 1) {
+        snprintf(kernel, sizeof(kernel), "TestSynth_%u_workers_unison_%u", threads, unison);
+    } else {
+        snprintf(kernel, sizeof(kernel), "TestSynth_%u_workers", threads);
+    }
+    print_row("run", kernel, sounding, frames, sample_rate, m, -1);
+}
+
+// Golden-render regression. `--record DIR` renders scripted MIDI through run() and stores the output, along with the
+// throughput of a few run() configurations. `--check DIR` does the same again and fails if any render drifts from its
+// recording by more than render_tolerance, or any configuration got more than throughput_tolerance slower.
+// Record before an optimization, check after it. Without --kernels, the check renders with every set the CPU supports,
+// and measures throughput with the widest. --renders-only leaves out throughput, whose baseline only means anything on
+// the machine that recorded it; `make test` checks the committed reference directory, recorded with the scalar set by
+// `make bench`, so with the flags the plugin ships with (DPF's -O3 -ffast-math -msse -msse2 -mfpmath=sse on x86).
+// Builds without -ffast-math match it within render_tolerance too.
+
+static const float render_tolerance = 1e-5f;    // the kernel sets only differ by float rounding (see kernels.hpp)
+static const double throughput_tolerance = 0.2; // timing noise between runs on an otherwise idle machine
+static const double regression_sample_rate = 48000;
+
+struct Scripted_Event {
+    uint32_t frame; // from the start of the render
+    uint8_t data[3];
+};
+
+struct Render_Script {
+    std::string name;
+    uint32_t block_frames;
+    uint32_t total_frames; // deliberately not a multiple of block_frames, so the last block is short
+    uint32_t workers;
+    std::vector<std::pair<uint32_t, float>> parameters; // Parameter_Index and value, set before activate()
+    std::vector<Scripted_Event> events;                // sorted by frame
+};
+
+static std::vector<Render_Script> get_render_scripts() {
+    using Index = Benchmark_Synth::Parameter_Index;
+    std::vector<Render_Script> scripts;
+
+    // a chord pressed in one frame, released one note at a time, then pressed again while the release tails ring
+    Render_Script chord = {"chord", 256, 48000 + 77, 0, {}, {}};
+    chord.events = {
+        {0, {0x90, 60, 100}}, {0, {0x90, 64, 90}}, {0, {0x90, 67, 80}},
+        {20000, {0x80, 64, 0}}, {22000, {0x80, 60, 0}}, {24000, {0x80, 67, 0}},
+        {25000, {0x90, 48, 127}}, {25000, {0x90, 55, 64}}, {25001, {0x90, 72, 1}},
+        {40000, {0x80, 48, 0}}, {40000, {0x80, 55, 0}}, {40000, {0x80, 72, 0}},
+    };
+    scripts.push_back(chord);
+
+    // the same with the worker pool, whose summation order is fixed so it should match the single thread render
+    Render_Script chord_workers = chord;
+    chord_workers.name = "chord_workers";
+    chord_workers.workers = 3;
+    scripts.push_back(chord_workers);
+
+    // held notes under a pitch bend sweep from the bottom to the top of the wheel and back to the centre
+    Render_Script bend = {"pitch_bend", 128, 36000 + 5, 0, {{Index::pitch_bend_range, 12}}, {}};
+    bend.events = {{10, {0x90, 57, 100}}, {10, {0x90, 69, 100}}};
+    for (uint32_t step = 0; step <= 32; ++step) {
+        uint32_t value = std::min(step*512u, 0x3fffu);
+        bend.events.push_back({1000 + step*800, {0xE0, uint8_t(value & 0x7f), uint8_t(value >> 7)}});
+    }
+    bend.events.push_back({30000, {0xE0, 0x00, 0x40}});
+    bend.events.push_back({33000, {0x80, 57, 0}});
+    bend.events.push_back({33000, {0x80, 69, 0}});
+    scripts.push_back(bend);
+
+    // the same key pressed again while it is held, released twice, and pressed in the frame it is released
+    Render_Script retrigger = {"retrigger", 256, 24000 + 200, 0, {}, {}};
+    retrigger.events = {
+        {100, {0x90, 60, 100}}, {2000, {0x90, 60, 60}}, {2001, {0x90, 60, 120}},
+        {8000, {0x80, 60, 0}}, {8001, {0x80, 60, 0}},
+        {12000, {0x90, 60, 90}}, {16000, {0x80, 60, 0}}, {16000, {0x90, 60, 90}}, {20000, {0x80, 60, 0}},
+    };
+    scripts.push_back(retrigger);
+
+    // running status note offs: note on with velocity 0 releases the note, so this renders the same as with 0x80
+    Render_Script velocity_0 = {"velocity_0_note_off", 256, 30000 + 11, 0, {}, {}};
+    velocity_0.events = {
+        {0, {0x90, 60, 100}}, {0, {0x90, 64, 100}}, {6000, {0x90, 60, 0}}, {9000, {0x90, 60, 80}}, {12000, {0x90, 64, 0}}, {15000, {0x90, 60, 0}},
+    };
+    scripts.push_back(velocity_0);
+
+    // an odd block size, so blocks straddle envelope control periods, with events on the first and last frame of blocks
+    Render_Script edges = {"block_edges", 61, 61*400 + 13, 0, {}, {}};
+    edges.events = {
+        {0, {0x90, 64, 100}}, {60, {0x90, 67, 100}}, {61, {0x90, 71, 100}},
+        {61*50 - 1, {0x80, 67, 0}}, {61*50, {0x80, 71, 0}}, {61*100, {0x90, 67, 50}}, {61*100, {0x80, 67, 0}},
+        {61*200 + 60, {0x80, 64, 0}}, {61*399 + 60, {0x90, 76, 100}},
+    };
+    scripts.push_back(edges);
+
+    // the wavetable paths, in unison and oversampled
+    Render_Script unison = {"saw_unison", 256, 24000 + 31, 0, {{Index::waveform, float(Waveform::saw)}, {Index::unison_voices, 7}, {Index::unison_detune, 25}, {Index::unison_spread, 1}}, {}};
+    unison.events = {{0, {0x90, 48, 100}}, {0, {0x90, 60, 100}}, {3000, {0xE0, 0x00, 0x60}}, {16000, {0x80, 48, 0}}, {16000, {0x80, 60, 0}}};
+    scripts.push_back(unison);
+    // more copies than one AVX2 vector, with every size of remainder group up to a whole vector
+    for (uint32_t copies = 13; copies <= Unison::max_copies; ++copies) {
+        Render_Script wide_unison = unison;
+        wide_unison.name = "saw_unison_" + std::to_string(copies);
+        wide_unison.parameters = {{Index::waveform, float(Waveform::saw)}, {Index::unison_voices, float(copies)}, {Index::unison_detune, 30}, {Index::unison_spread, 1}};
+        scripts.push_back(wide_unison);
+    }
+
+    Render_Script oversampled = {"pulse_oversampled", 200, 24000 + 99, 0, {{Index::waveform, float(Waveform::pulse)}, {Index::oversampling, 2}}, {}};
+    oversampled.events = {{0, {0x90, 96, 100}}, {500, {0x90, 108, 100}}, {16000, {0x80, 96, 0}}, {16000, {0x80, 108, 0}}};
+    scripts.push_back(oversampled);
+
+    // MPE lower zone: two member channels sliding and pressing independently, over a held note on the manager channel
+    // that only the manager's pitch bend moves. Expression streams densely, as from a real controller.
+    Render_Script mpe = {"mpe", 128, 24000 + 45, 0, {{Index::mpe_layout, float(MPE_Layout::lower)}}, {}};
+    mpe.events = {{0, {0x90, 55, 90}}, {5, {0xE1, 0x00, 0x40}}, {5, {0x91, 60, 100}}, {7, {0xE2, 0x00, 0x38}}, {7, {0x92, 64, 100}}};
+    for (uint32_t step = 0; step < 60; ++step) {
+        uint32_t frame = 1000 + step*250;
+        uint32_t value = 0x2000 + step*12;
+        mpe.events.push_back({frame, {0xE1, uint8_t(value & 0x7f), uint8_t(value >> 7)}});
+        mpe.events.push_back({frame + 3, {0xD2, uint8_t(step*2), 0}});
+        mpe.events.push_back({frame + 100, {0xB1, 74, uint8_t(step)}});
+    }
+    mpe.events.push_back({12000, {0xE0, 0x00, 0x50}});
+    mpe.events.push_back({17000, {0x81, 60, 0}});
+    mpe.events.push_back({17000, {0x82, 64, 0}});
+    mpe.events.push_back({19000, {0x80, 55, 0}});
+    std::stable_sort(mpe.events.begin(), mpe.events.end(), [](const Scripted_Event& a, const Scripted_Event& b) { return a.frame < b.frame; });
+    scripts.push_back(mpe);
+
+    // additive organ, with a bend sweeping the high note's partials across the band limit, then in unison
+    Render_Script additive = {"additive", 128, 24000 + 17, 0, {{Index::waveform, float(Waveform::additive)}, {Index::additive_preset, float(Additive_Preset::organ)}, {Index::additive_partials, 512}, {Index::additive_tilt, -3}}, {}};
+    additive.events = {{0, {0x90, 36, 100}}, {0, {0x90, 84, 100}}, {4000, {0xE0, 0x7f, 0x7f}}, {9000, {0xE0, 0x00, 0x40}}, {12000, {0x80, 84, 0}}, {16000, {0x80, 36, 0}}};
+    scripts.push_back(additive);
+    Render_Script additive_unison = additive;
+    additive_unison.name = "additive_unison";
+    additive_unison.parameters = {{Index::waveform, float(Waveform::additive)}, {Index::additive_preset, float(Additive_Preset::saw)}, {Index::unison_voices, 5}, {Index::unison_detune, 20}, {Index::unison_spread, 1}};
+    scripts.push_back(additive_unison);
+
+    // six operators with feedback and a fractional ratio, bent, then in unison
+    Render_Script fm = {"fm", 96, 24000 + 23, 0, {{Index::waveform, float(Waveform::fm)}, {Index::fm_algorithm, float(FM_Algorithm::branch)}, {Index::fm_feedback, 0.4f},
+        {Index::op_2_ratio, 2}, {Index::op_2_level, 0.5f}, {Index::op_3_level, 0.8f}, {Index::op_4_ratio, 1.41f}, {Index::op_4_level, 0.3f},
+        {Index::op_5_ratio, 3}, {Index::op_5_level, 0.4f}, {Index::op_6_ratio, 0.5f}, {Index::op_6_level, 0.3f}}, {}};
+    fm.events = {{0, {0x90, 45, 100}}, {0, {0x90, 69, 80}}, {5000, {0xE0, 0x00, 0x60}}, {9000, {0xE0, 0x00, 0x40}}, {12000, {0x80, 69, 0}}, {16000, {0x80, 45, 0}}};
+    scripts.push_back(fm);
+    Render_Script fm_unison = fm;
+    fm_unison.name = "fm_unison";
+    fm_unison.parameters.push_back({Index::unison_voices, 3});
+    fm_unison.parameters.push_back({Index::unison_spread, 1});
+    scripts.push_back(fm_unison);
+
+    // keys spread across the field and an LFO sweeping them, into the reverb, which rings on after the notes end
+    Render_Script pan_reverb = {"pan_reverb", 128, 36000 + 19, 0, {{Index::waveform, float(Waveform::saw)}, {Index::pan, -0.2f}, {Index::pan_spread, 1},
+        {Index::lfo_1_rate, 3}, {Index::mod_1_source, float(Mod_Source::lfo_1)}, {Index::mod_1_destination, float(Mod_Destination::pan)}, {Index::mod_1_amount, 0.5f},
+        {Index::reverb_level, 0.4f}, {Index::reverb_size, 0.3f}, {Index::reverb_decay, 0.8f}, {Index::reverb_damping, 0.3f}}, {}};
+    pan_reverb.events = {{0, {0x90, 36, 100}}, {0, {0x90, 84, 100}}, {6000, {0x90, 60, 90}}, {14000, {0x80, 36, 0}}, {14000, {0x80, 84, 0}}, {16000, {0x80, 60, 0}}};
+    scripts.push_back(pan_reverb);
+    // centred voices stay mono into the reverb, with 8 lines
+    Render_Script reverb_8_lines = pan_reverb;
+    reverb_8_lines.name = "reverb_8_lines";
+    reverb_8_lines.parameters = {{Index::waveform, float(Waveform::triangle)}, {Index::reverb_level, 0.6f}, {Index::reverb_lines, 0}, {Index::reverb_decay, 0.5f}};
+    scripts.push_back(reverb_8_lines);
+
+    // portamento up and down between overlapping notes, over an odd block size so glides cross block boundaries
+    Render_Script glide = {"glide", 100, 24000 + 37, 0, {{Index::waveform, float(Waveform::saw)}, {Index::glide_time, 0.15f}}, {}};
+    glide.events = {{0, {0x90, 48, 100}}, {4000, {0x90, 55, 100}}, {6000, {0x80, 48, 0}}, {9000, {0x90, 67, 90}}, {11000, {0x80, 55, 0}},
+                    {14000, {0x90, 43, 100}}, {15000, {0x80, 67, 0}}, {19000, {0x80, 43, 0}}};
+    scripts.push_back(glide);
+
+    // vibrato from an LFO, and amplitude from the envelope and a second LFO, on notes that start mid-render and
+    // retrigger, so new voices go through their first modulation period
+    Render_Script pitch_amp = {"pitch_amp_modulation", 128, 24000 + 41, 0, {{Index::waveform, float(Waveform::triangle)},
+        {Index::lfo_1_rate, 5}, {Index::lfo_1_shape, float(LFO_Shape::triangle)}, {Index::lfo_2_rate, 1.5f}, {Index::lfo_2_shape, float(LFO_Shape::square)},
+        {Index::mod_1_source, float(Mod_Source::lfo_1)}, {Index::mod_1_destination, float(Mod_Destination::pitch)}, {Index::mod_1_amount, 0.1f},
+        {Index::mod_2_source, float(Mod_Source::envelope)}, {Index::mod_2_destination, float(Mod_Destination::amplitude)}, {Index::mod_2_amount, -0.5f},
+        {Index::mod_3_source, float(Mod_Source::lfo_2)}, {Index::mod_3_destination, float(Mod_Destination::amplitude)}, {Index::mod_3_amount, 0.3f}}, {}};
+    pitch_amp.events = {{0, {0x90, 57, 100}}, {3000, {0x90, 64, 90}}, {7000, {0x90, 57, 110}}, {10000, {0x80, 64, 0}}, {12000, {0x90, 72, 80}},
+                        {16000, {0x80, 57, 0}}, {18000, {0x80, 72, 0}}};
+    scripts.push_back(pitch_amp);
+
+    return scripts;
+}
+
+// Interleaved left/right
+static std::vector<float> render_script(const Render_Script& script) {
+    DISTRHO::d_nextBufferSize = script.block_frames;
+    DISTRHO::d_nextSampleRate = regression_sample_rate;
+    Benchmark_Synth plugin;
+    plugin.setParameterValue(Benchmark_Synth::Parameter_Index::worker_threads, script.workers);
+    for (const auto& parameter : script.parameters) {
+        plugin.setParameterValue(parameter.first, parameter.second);
+    }
+    plugin.activate();
+
+    std::vector<float> left(script.block_frames), right(script.block_frames);
+    float* outputs[2] = { left.data(), right.data() };
+    std::vector<float> rendered;
+    rendered.reserve(2*size_t(script.total_frames));
+    std::vector<DISTRHO::MidiEvent> block_events;
+    size_t next_event = 0;
+    for (uint32_t start = 0; start < script.total_frames; start += script.block_frames) {
+        uint32_t frames = std::min(script.block_frames, script.total_frames - start);
+        block_events.clear();
+        for (; next_event < script.events.size() && script.events[next_event].frame < start + frames; ++next_event) {
+            DISTRHO::MidiEvent event = {};
+            event.frame = script.events[next_event].frame - start;
+            event.size = 3;
+            std::memcpy(event.data, script.events[next_event].data, 3);
+            block_events.push_back(event);
+        }
+        plugin.run(nullptr, outputs, frames, block_events.data(), block_events.size());
+        for (uint32_t f = 0; f < frames; ++f) {
+            rendered.push_back(left[f]);
+            rendered.push_back(right[f]);
+        }
+    }
+
+    plugin.deactivate();
+    return rendered;
+}
+
+struct Throughput_Config {
+    const char* name;
+    uint32_t voices;
+    uint32_t threads;
+    uint32_t oversampling;
+    uint32_t unison;
+};
+
+static const Throughput_Config throughput_configs[] = {
+    {"run_64_voices", 64, 0, 0, 1},
+    {"run_64_voices_workers", 64, 3, 0, 1},
+    {"run_16_voices_unison_8", 16, 0, 0, 8},
+    {"run_16_voices_4x", 16, 0, 2, 1},
+};
+
+// the fastest of a few measurements, since interference from the rest of the system only ever slows a run down
+static double measure_throughput(const Throughput_Config& config) {
+    double best = 0;
+    for (uint32_t attempt = 0; attempt < 5; ++attempt) {
+        uint32_t sounding;
+        double ns_per_frame = measure_run(config.voices, 256, regression_sample_rate, config.threads, config.oversampling, config.unison, sounding).ns_per_frame;
+        best = attempt == 0 ? ns_per_frame : std::min(best, ns_per_frame);
+    }
+    return best;
+}
+
+static bool write_floats(const std::string& path, const std::vector<float>& samples) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(samples.data(), sizeof(float), samples.size(), file) == samples.size();
+    return fclose(file) == 0 && written;
+}
+
+static bool read_floats(const std::string& path, std::vector<float>& samples) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    samples.clear();
+    float buffer[1024];
+    size_t count;
+    while ((count = fread(buffer, sizeof(float), 1024, file)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + count);
+    }
+    fclose(file);
+    return true;
+}
+
+static int record_regression(const std::string& directory, bool renders_only) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    for (const Render_Script& script : get_render_scripts()) {
+        if (!write_floats(directory + "/" + script.name + ".raw", render_script(script))) {
+            fprintf(stderr, "Could not write %s/%s.raw\n", directory.c_str(), script.name.c_str());
+            return 1;
+        }
+        printf("recorded render %s\n", script.name.c_str());
+    }
+    if (renders_only) {
+        return 0;
+    }
+
+    FILE* baseline = fopen((directory + "/throughput.csv").c_str(), "w");
+    if (baseline == nullptr) {
+        fprintf(stderr, "Could not write %s/throughput.csv\n", directory.c_str());
+        return 1;
+    }
+    for (const Throughput_Config& config : throughput_configs) {
+        double ns_per_frame = measure_throughput(config);
+        fprintf(baseline, "%s,%.3f\n", config.name, ns_per_frame);
+        printf("recorded throughput %s: %.3f ns/frame\n", config.name, ns_per_frame);
+    }
+    fclose(baseline);
+    return 0;
+}
+
+// kernel_sets are checked in order, so throughput is measured with the last one
+static int check_regression(const std::string& directory, const std::vector<Kernel_Set>& kernel_sets, bool renders_only) {
+    uint32_t failures = 0;
+    for (Kernel_Set set : kernel_sets) {
+        override_kernels(set);
+        const char* set_name = get_kernel_set_name(set);
+        for (const Render_Script& script : get_render_scripts()) {
+            std::vector<float> expected;
+            if (!read_floats(directory + "/" + script.name + ".raw", expected)) {
+                printf("FAIL render %s (%s): no recording in %s\n", script.name.c_str(), set_name, directory.c_str());
+                ++failures;
+                continue;
+            }
+            std::vector<float> rendered = render_script(script);
+            if (rendered.size() != expected.size()) {
+                printf("FAIL render %s (%s): %zu samples, recorded %zu\n", script.name.c_str(), set_name, rendered.size(), expected.size());
+                ++failures;
+                continue;
+            }
+            float max_error = 0;
+            size_t worst = 0;
+            for (size_t s_idx = 0; s_idx < rendered.size(); ++s_idx) {
+                float error = std::fabs(rendered[s_idx] - expected[s_idx]);
+                if (!(error <= max_error)) { // NaN counts as the worst error
+                    max_error = error;
+                    worst = s_idx;
+                }
+            }
+            bool pass = max_error <= render_tolerance;
+            printf("%s render %s (%s): max error %.3g at frame %zu\n", pass ? "PASS" : "FAIL", script.name.c_str(), set_name, max_error, worst/2);
+            failures += pass ? 0 : 1;
+        }
+    }
+    if (renders_only) {
+        printf("%u failed\n", failures);
+        return failures == 0 ? 0 : 1;
+    }
+
+    FILE* baseline = fopen((directory + "/throughput.csv").c_str(), "r");
+    if (baseline == nullptr) {
+        printf("FAIL throughput: no baseline in %s\n", directory.c_str());
+        return 1;
+    }
+    char name[64];
+    double baseline_ns;
+    while (fscanf(baseline, "%63[^,],%lf\n", name, &baseline_ns) == 2) {
+        const Throughput_Config* config = nullptr;
+        for (const Throughput_Config& candidate : throughput_configs) {
+            if (std::strcmp(candidate.name, name) == 0) {
+                config = &candidate;
+            }
+        }
+        if (config == nullptr) {
+            continue; // a configuration since removed
+        }
+        double ns_per_frame = measure_throughput(*config);
+        bool pass = ns_per_frame <= baseline_ns*(1 + throughput_tolerance);
+        printf("%s throughput %s: %.3f ns/frame, baseline %.3f (%.2fx)\n", pass ? "PASS" : "FAIL", name, ns_per_frame, baseline_ns, baseline_ns/ns_per_frame);
+        failures += pass ? 0 : 1;
+    }
+    fclose(baseline);
+
+    printf("%u failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    bool renders_only = false;
+    const char* record_directory = nullptr;
+    const char* check_directory = nullptr;
+    Kernel_Set forced_kernels = Kernel_Set::automatic;
+    for (int a_idx = 1; a_idx < argc; ++a_idx) {
+        if (std::strcmp(argv[a_idx], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[a_idx], "--renders-only") == 0) {
+            renders_only = true;
+        } else if (std::strcmp(argv[a_idx], "--record") == 0 && a_idx + 1 < argc) {
+            record_directory = argv[++a_idx];
+        } else if (std::strcmp(argv[a_idx], "--check") == 0 && a_idx + 1 < argc) {
+            check_directory = argv[++a_idx];
+        } else if (std::strcmp(argv[a_idx], "--kernels") == 0 && a_idx + 1 < argc) {
+            const char* name = argv[++a_idx];
+            Kernel_Set set = Kernel_Set::count;
+            for (uint8_t s_idx = 0; s_idx < uint8_t(Kernel_Set::count); ++s_idx) {
+                if (std::strcmp(name, get_kernel_set_name(Kernel_Set(s_idx))) == 0) {
+                    set = Kernel_Set(s_idx);
+                }
+            }
+            if (!override_kernels(set)) {
+                fprintf(stderr, "Kernel set %s is unknown or not supported by this CPU\n", name);
+                return 1;
+            }
+            forced_kernels = set;
+        }
+    }
+
+    std::vector<Kernel_Set> kernel_sets;
+    for (uint8_t s_idx = uint8_t(Kernel_Set::scalar); s_idx < uint8_t(Kernel_Set::count); ++s_idx) {
+        Kernel_Set set = Kernel_Set(s_idx);
+        if ((forced_kernels == Kernel_Set::automatic || forced_kernels == set) && is_kernel_set_supported(set)) {
+            kernel_sets.push_back(set);
+        }
+    }
+
+    if (record_directory != nullptr) {
+        return record_regression(record_directory, renders_only);
+    }
+    if (check_directory != nullptr) {
+        return check_regression(check_directory, kernel_sets, renders_only);
+    }
+
+    const std::vector<uint32_t> voice_counts = quick ? std::vector<uint32_t>{1, 16, 128} : std::vector<uint32_t>{1, 4, 16, 64, 128, 256};
+    const std::vector<uint32_t> buffer_sizes = quick ? std::vector<uint32_t>{256} : std::vector<uint32_t>{64, 256, 1024};
+    const uint32_t spare_cores = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+    const std::vector<uint32_t> worker_counts = {0, spare_cores < Benchmark_Synth::max_worker_threads ? spare_cores : uint32_t(Benchmark_Synth::max_worker_threads)};
+    const std::vector<double> sample_rates = quick ? std::vector<double>{48000} : std::vector<double>{44100, 48000, 96000};
+
+    Wavetable saw_table, triangle_table;
+    saw_table.build_saw();
+    triangle_table.build_triangle();
+
+    Sine_Oscillator sine_reference;
+    Fast_Sine_Oscillator fast_sine;
+    Saw_Oscillator saw(&saw_table);
+    Pulse_Oscillator pulse(&saw_table, 0, 0.3);
+    Triangle_Oscillator triangle(&triangle_table);
+    Additive_Spectrum spectrum; // 256 saw partials, all below nyquist for the lowest benchmark note
+    Additive_Oscillator additive(&spectrum);
+    Additive_Reference additive_reference(&spectrum);
+    FM_Patch fm_patch; // DX-style: three modulated pairs, every operator at a whole-number ratio
+    fm_patch.set_algorithm(FM_Algorithm::three_pairs);
+    for (uint32_t op = 0; op < FM_Patch::max_operators; ++op) {
+        fm_patch.set_operator(op, float(1 + op/2), (op % 2) ? 0.4f : 0.8f);
+    }
+    FM_Oscillator fm(&fm_patch);
+    FM_Reference fm_reference(&fm_patch);
+    FM_Patch fm_feedback_patch = fm_patch;
+    fm_feedback_patch.set_feedback(0.5f);
+    FM_Oscillator fm_feedback(&fm_feedback_patch);
+    Sample_Streamer sample_streamer;
+    const std::string sample_library = write_sample_library();
+    const bool have_samples = !sample_library.empty() && sample_streamer.load_sfz(sample_library.c_str());
+    sample_streamer.start(voice_counts.back());
+    sample_streamer.update();
+
+    print_header();
+    for (double sample_rate : sample_rates) {
+        for (uint32_t frames : buffer_sizes) {
+            for (uint32_t voices : voice_counts) {
+                bench_oscillator("sine_reference", &sine_reference, nullptr, voices, frames, sample_rate);
+                if (have_samples) {
+                    bench_sample(sample_streamer, voices, frames, sample_rate);
+                }
+                for (Kernel_Set set : kernel_sets) {
+                    override_kernels(set);
+                    select_kernels();
+                    std::string suffix = std::string(":") + get_kernel_set_name(set);
+                    bench_oscillator(("fast_sine" + suffix).c_str(), &fast_sine, &sine_reference, voices, frames, sample_rate);
+                    bench_oscillator(("saw" + suffix).c_str(), &saw, nullptr, voices, frames, sample_rate);
+                    bench_oscillator(("pulse" + suffix).c_str(), &pulse, nullptr, voices, frames, sample_rate);
+                    bench_oscillator(("triangle" + suffix).c_str(), &triangle, nullptr, voices, frames, sample_rate);
+                    bench_oscillator(("additive" + suffix).c_str(), &additive, &additive_reference, voices, frames, sample_rate);
+                    bench_oscillator(("fm" + suffix).c_str(), &fm, &fm_reference, voices, frames, sample_rate);
+                    bench_oscillator(("fm_feedback" + suffix).c_str(), &fm_feedback, nullptr, voices, frames, sample_rate);
+                    if (voices == voice_counts.front()) {
+                        bench_reverb(("reverb_8" + suffix).c_str(), 8, frames, sample_rate);
+                        bench_reverb(("reverb_16" + suffix).c_str(), 16, frames, sample_rate);
+                    }
+                }
+                // TestSynth::activate() selects the kernels again for the run() rows
+                override_kernels(forced_kernels);
+                for (uint32_t threads : worker_counts) {
+                    bench_run(voices, frames, sample_rate, threads);
+                }
+                if (voices == voice_counts.front()) {
+                    bench_run(0, frames, sample_rate, 0); // no notes at all: the cost of an idle instance
+                }
+                for (uint32_t oversampling = 1; oversampling <= 3; ++oversampling) {
+                    bench_run(voices, frames, sample_rate, 0, oversampling);
+                }
+                for (uint32_t unison : {4, 8, 16}) {
+                    for (uint32_t threads : worker_counts) {
+                        bench_run(voices, frames, sample_rate, threads, 0, unison);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
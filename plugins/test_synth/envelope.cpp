@@ -0,0 +1,99 @@
+/*
+envelope.cpp
+ADSR envelopes for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "envelope.hpp"
+#include <cmath>
+
+// The attack aims past full level, like an analog envelope, so it reaches 1 in finite time.
+static const float attack_target = 1.2f;
+
+// Decay and release times are how long the distance to the target takes to shrink by 60 dB
+static const float segment_ratio = 1e-3f;
+
+Envelope::Envelope() {
+    control_period = default_control_period;
+    set_parameters(0.005, 0.1, 0.8, 0.2, 48000);
+}
+
+void Envelope::set_parameters(float attack_s, float decay_s, float sustain_level_in, float release_s, double sample_rate) {
+    sustain_level = sustain_level_in;
+
+    target[uint8_t(Envelope_Stage::attack)] = attack_target;
+    target[uint8_t(Envelope_Stage::decay)] = sustain_level;
+    target[uint8_t(Envelope_Stage::release)] = 0;
+    target[uint8_t(Envelope_Stage::fade)] = 0;
+
+    // distance left to attack_target once the level reaches 1, relative to where the attack started from 0
+    set_segment(Envelope_Stage::attack, attack_s, (attack_target - 1)/attack_target, sample_rate);
+    set_segment(Envelope_Stage::decay, decay_s, segment_ratio, sample_rate);
+    set_segment(Envelope_Stage::release, release_s, segment_ratio, sample_rate);
+    set_segment(Envelope_Stage::fade, fade_time_s, segment_ratio, sample_rate);
+}
+
+void Envelope::set_segment(Envelope_Stage stage, float seconds, float ratio, double sample_rate) {
+    float coefficient = 0; // instant
+    float frames = seconds*sample_rate;
+    if (frames >= 1) {
+        coefficient = exp(log(ratio)/frames);
+    }
+
+    float* powers = coefficient_powers[uint8_t(stage)];
+    powers[0] = 1;
+    for (uint32_t n = 1; n <= max_control_period; ++n) {
+        powers[n] = powers[n - 1]*coefficient;
+    }
+}
+
+void Envelope::set_control_period(uint32_t frames) {
+    control_period = min_control_period;
+    while (control_period < frames && control_period < max_control_period) {
+        control_period *= 2;
+    }
+}
+
+float Envelope::advance(Envelope_Stage& stage, float& level, uint32_t frames) const {
+    if (stage == Envelope_Stage::finished) {
+        level = 0;
+        return level;
+    }
+
+    const uint8_t segment = uint8_t(stage);
+    level = target[segment] + (level - target[segment])*coefficient_powers[segment][frames];
+
+    // stage changes happen at control period boundaries
+    switch (stage) {
+    case Envelope_Stage::attack:
+        if (level >= 1) {
+            level = 1;
+            stage = Envelope_Stage::decay;
+        }
+        break;
+    case Envelope_Stage::release:
+    case Envelope_Stage::fade:
+        if (level < silence_threshold) {
+            level = 0;
+            stage = Envelope_Stage::finished;
+        }
+        break;
+    default:
+        break;
+    }
+    return level;
+}
@@ -0,0 +1,66 @@
+/*
+envelope.hpp
+ADSR envelopes for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+enum class Envelope_Stage : uint8_t {
+    attack,
+    decay,    // settles at the sustain level
+    release,
+    fade,     // a release of fade_time_s whatever the release time, for voices dropped to meet the voice limit
+    finished, // below the silence threshold; the voice can be freed
+};
+
+class Envelope {
+    // ADSR envelope with exponential segments. Each segment moves the level towards a target with
+    // level = target + (level - target)*coefficient per frame, which is evaluated in control periods of up to
+    // `control_period` frames using precomputed powers of the coefficient, so rendering never calls pow() or exp().
+    // Voices interpolate their amplitude linearly across each control period, and evaluate their modulation once per
+    // period, so the period is the synth's control rate.
+    public:
+    static const uint32_t min_control_period = 16;
+    static const uint32_t default_control_period = 32;
+    static const uint32_t max_control_period = 64;
+    static constexpr float silence_threshold = 1e-4f; // -80 dB
+    static constexpr float fade_time_s = 0.005f;
+
+    Envelope();
+
+    // Calls exp() once per segment, so only call it when the times or the sample rate change. Times are in seconds.
+    void set_parameters(float attack_s, float decay_s, float sustain_level_in, float release_s, double sample_rate);
+
+    // A power of two from min_control_period to max_control_period. Voices pick it up at their next period, and the
+    // periods stay on a grid of multiples of it, so only change it between blocks.
+    void set_control_period(uint32_t frames);
+    uint32_t get_control_period() const { return control_period; }
+
+    // Advance a voice's envelope by `frames` (at most control_period) and return the new level
+    float advance(Envelope_Stage& stage, float& level, uint32_t frames) const;
+
+    protected:
+    void set_segment(Envelope_Stage stage, float seconds, float ratio, double sample_rate);
+
+    uint32_t control_period;
+    float sustain_level;
+    float target[4];                                   // per stage, for attack, decay, release and fade
+    float coefficient_powers[4][max_control_period + 1]; // coefficient^n for n = 0..max_control_period
+};
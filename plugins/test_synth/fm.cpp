@@ -0,0 +1,107 @@
+/*
+fm.cpp
+FM operator patches for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "fm.hpp"
+
+#include <algorithm>
+
+// What each operator of an algorithm modulates (a bit per lower operator), whether it's heard, and which one feeds back
+struct Algorithm_Graph {
+    uint8_t targets[FM_Patch::max_operators];
+    uint8_t carriers;
+    uint8_t feedback;
+};
+
+static const Algorithm_Graph algorithm_graphs[uint8_t(FM_Algorithm::count)] = {
+    {{0, 1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4}, 0x01, 5},
+    {{0, 1 << 0, 0, 1 << 2, 1 << 3, 1 << 4}, 0x05, 5},
+    {{0, 1 << 0, 0, 1 << 2, 0, 1 << 4}, 0x15, 5},
+    {{0, 1 << 0, 0, 1 << 2, 1 << 2, 1 << 4}, 0x05, 5},
+    {{0, 1 << 0, 0, 0, 0, (1 << 2) | (1 << 3) | (1 << 4)}, 0x1d, 5},
+    {{0, 1 << 0, 1 << 1, 0, 0, (1 << 3) | (1 << 4)}, 0x19, 5},
+    {{0, 0, 0, 0, 0, 0}, 0x3f, 5},
+    {{0, 1 << 0, 1 << 1, 1 << 2, 0, 0}, 0x01, 3},
+    {{0, 1 << 0, 0, 1 << 2, 0, 0}, 0x05, 3},
+};
+
+FM_Patch::FM_Patch() {
+    algorithm = FM_Algorithm::stack;
+    std::fill(ratios, ratios + max_operators, 1.f);
+    std::fill(levels, levels + max_operators, 0.f);
+    levels[0] = 1;
+    feedback_cycles = 0;
+    update_steps();
+}
+
+void FM_Patch::set_algorithm(FM_Algorithm algorithm_in) {
+    algorithm = FM_Algorithm(std::min(uint8_t(algorithm_in), uint8_t(uint8_t(FM_Algorithm::count) - 1)));
+    update_steps();
+}
+
+void FM_Patch::set_operator(uint32_t op, float ratio, float level) {
+    if (op >= max_operators) {
+        return;
+    }
+    ratios[op] = std::max(ratio, 0.f);
+    levels[op] = std::clamp(level, 0.f, 1.f);
+    update_steps();
+}
+
+void FM_Patch::set_feedback(float amount) {
+    feedback_cycles = std::clamp(amount, 0.f, 1.f)*max_feedback_cycles;
+}
+
+void FM_Patch::update_steps() {
+    const Algorithm_Graph& graph = algorithm_graphs[uint8_t(algorithm)];
+
+    // Carriers share the output evenly, counting the silent ones, so turning one down doesn't make the others louder.
+    // Targets are lower-numbered, so going up from operator 1 finds out whether each operator's targets are heard first.
+    uint32_t carrier_count = 0;
+    for (uint32_t op = 0; op < max_operators; ++op) {
+        carrier_count += (graph.carriers >> op) & 1;
+    }
+    uint8_t audible = 0;
+    uint8_t modulated = 0;
+    for (uint32_t op = 0; op < max_operators; ++op) {
+        const uint8_t targets = graph.targets[op] & audible;
+        if (levels[op] > 0 && (((graph.carriers >> op) & 1) || targets != 0)) {
+            audible |= 1 << op;
+            modulated |= targets;
+        }
+    }
+
+    step_count = 0;
+    for (uint32_t op = max_operators; op-- > 0;) {
+        if (!((audible >> op) & 1)) {
+            continue;
+        }
+        Step& step = steps[step_count++];
+        step.op = uint8_t(op);
+        step.targets = graph.targets[op] & audible;
+        step.first_target = 0;
+        while (step.targets != 0 && !((step.targets >> step.first_target) & 1)) {
+            ++step.first_target;
+        }
+        step.modulated = (modulated >> op) & 1;
+        step.feedback = op == graph.feedback;
+        step.ratio = ratios[op];
+        step.gain = (step.targets != 0) ? levels[op]*max_modulation_cycles : levels[op]/carrier_count;
+    }
+}
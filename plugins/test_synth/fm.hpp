@@ -0,0 +1,87 @@
+/*
+fm.hpp
+FM operator patches for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Operator graphs, numbered from the bottom: an operator only ever modulates lower-numbered ones, so rendering from the
+// highest number down has every modulator ready before the operators it modulates. Each has one operator that
+// feeds back into itself. Operators an algorithm leaves out don't render at all.
+enum class FM_Algorithm : uint8_t {
+    stack,         // 6 > 5 > 4 > 3 > 2 > 1
+    two_stacks,    // 2 > 1, 6 > 5 > 4 > 3
+    three_pairs,   // 2 > 1, 4 > 3, 6 > 5
+    branch,        // 2 > 1, 4 > 3, 6 > 5 > 3 (3 has two modulators)
+    one_to_three,  // 2 > 1, 6 > 3 and 4 and 5
+    stack_and_fan, // 3 > 2 > 1, 6 > 4 and 5
+    organ,         // all six heard
+    four_stack,    // 4 > 3 > 2 > 1
+    four_pairs,    // 2 > 1, 4 > 3
+    count,
+};
+
+// The phases and feedback memory of one voice's operators, kept in the Voice_Pool: max_operators phases and the
+// feedback operator's last two outputs for each unison copy, copy 0 outside unison mode.
+struct Operator_State {
+    uint32_t* phases;
+    float* feedback;
+};
+
+class FM_Patch {
+    // The settings every voice of an FM_Oscillator plays: the algorithm, each operator's frequency ratio and level,
+    // and the feedback. The setters work out the order operators render in, so only change it between blocks.
+    public:
+    static const uint32_t max_operators = 6;
+    static constexpr float max_modulation_cycles = 2; // phase deviation of a modulator at full level, about 4pi radians
+    static constexpr float max_feedback_cycles = 0.5f;
+
+    FM_Patch();
+
+    void set_algorithm(FM_Algorithm algorithm_in);
+    void set_operator(uint32_t op, float ratio, float level); // op from 0; level from 0 to 1
+    void set_feedback(float amount);                         // 0 to 1
+
+    // One operator to render. Modulators add gain*sine, in cycles, to the phase of every operator in `targets`
+    // (a bit per operator); carriers have no targets, and add gain*sine to the output.
+    struct Step {
+        uint8_t op;
+        uint8_t targets;
+        uint8_t first_target; // the lowest operator in targets
+        bool modulated;  // something renders into this operator's phase
+        bool feedback;
+        float ratio;
+        float gain;
+    };
+    uint32_t get_step_count() const { return step_count; }
+    const Step* get_steps() const { return steps; }
+    float get_feedback_cycles() const { return feedback_cycles; }
+
+    protected:
+    void update_steps(); // the operators that can be heard, in rendering order
+
+    FM_Algorithm algorithm;
+    float ratios[max_operators];
+    float levels[max_operators];
+    float feedback_cycles;
+
+    Step steps[max_operators];
+    uint32_t step_count;
+};
@@ -0,0 +1,155 @@
+/*
+instrumentation.cpp
+Real-time performance instrumentation for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "instrumentation.hpp"
+
+#if ENABLE_INSTRUMENTATION
+
+#include <chrono>
+#include <cstdlib>
+
+static const char* const phase_names[Instrumentation::phase_count] = { "midi", "voices", "mixdown", "total" };
+static const uint32_t report_interval_ms = 1000;
+
+Instrumentation::Instrumentation() : blocks(0), deadline_misses(0), live_voices(0), peak_voices(0), reporter_running(false) {
+    for (Histogram& histogram : histograms) {
+        for (std::atomic<uint64_t>& bucket : histogram.buckets) {
+            bucket.store(0);
+        }
+        histogram.count.store(0);
+        histogram.sum_ns.store(0);
+        histogram.max_ns.store(0);
+    }
+    for (Snapshot& snapshot : last_reported) {
+        snapshot = Snapshot();
+    }
+    last_blocks = 0;
+    last_deadline_misses = 0;
+}
+
+Instrumentation::~Instrumentation() {
+    stop_reporter();
+}
+
+uint64_t Instrumentation::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Instrumentation::record(Phase phase, uint64_t duration) {
+    uint32_t bucket = 0;
+    for (uint64_t d = duration; d > 1 && bucket < bucket_count - 1; d >>= 1) {
+        ++bucket;
+    }
+
+    Histogram& histogram = histograms[phase];
+    add(histogram.buckets[bucket], 1);
+    add(histogram.count, 1);
+    add(histogram.sum_ns, duration);
+    if (duration > histogram.max_ns.load(std::memory_order_relaxed)) {
+        histogram.max_ns.store(duration, std::memory_order_relaxed);
+    }
+}
+
+void Instrumentation::end_block(uint64_t duration_ns, double deadline_s, uint32_t live_voices_in) {
+    record(total, duration_ns);
+    add(blocks, 1);
+    if (duration_ns > uint64_t(deadline_s*1e9)) {
+        add(deadline_misses, 1);
+    }
+    live_voices.store(live_voices_in, std::memory_order_relaxed);
+    if (live_voices_in > peak_voices.load(std::memory_order_relaxed)) {
+        peak_voices.store(live_voices_in, std::memory_order_relaxed);
+    }
+}
+
+void Instrumentation::write_report(FILE* file) {
+    const uint64_t block_count = blocks.load(std::memory_order_relaxed);
+    const uint64_t miss_count = deadline_misses.load(std::memory_order_relaxed);
+    fprintf(file, "blocks %llu, deadline misses %llu (%llu total), voices %u (peak %u)\n",
+            (unsigned long long)(block_count - last_blocks), (unsigned long long)(miss_count - last_deadline_misses),
+            (unsigned long long)miss_count, live_voices.load(std::memory_order_relaxed), peak_voices.load(std::memory_order_relaxed));
+    last_blocks = block_count;
+    last_deadline_misses = miss_count;
+
+    for (uint32_t phase = 0; phase < phase_count; ++phase) {
+        Histogram& histogram = histograms[phase];
+        Snapshot current;
+        for (uint32_t b = 0; b < bucket_count; ++b) {
+            current.buckets[b] = histogram.buckets[b].load(std::memory_order_relaxed);
+        }
+        current.count = histogram.count.load(std::memory_order_relaxed);
+        current.sum_ns = histogram.sum_ns.load(std::memory_order_relaxed);
+
+        Snapshot& last = last_reported[phase];
+        const uint64_t count = current.count - last.count;
+        if (count > 0) {
+            // percentiles are reported as the upper edge of their bucket
+            uint64_t p50 = 0, p99 = 0, seen = 0;
+            for (uint32_t b = 0; b < bucket_count; ++b) {
+                seen += current.buckets[b] - last.buckets[b];
+                if (p50 == 0 && seen*2 >= count) p50 = uint64_t(2) << b;
+                if (p99 == 0 && seen*100 >= count*99) p99 = uint64_t(2) << b;
+            }
+            fprintf(file, "  %-8s n %llu, mean %llu ns, p50 < %llu ns, p99 < %llu ns, max %llu ns\n", phase_names[phase],
+                    (unsigned long long)count, (unsigned long long)((current.sum_ns - last.sum_ns)/count),
+                    (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)histogram.max_ns.load(std::memory_order_relaxed));
+        }
+        last = current;
+    }
+    fflush(file);
+}
+
+void Instrumentation::start_reporter() {
+    stop_reporter();
+    reporter_running.store(true);
+    reporter = std::thread(&Instrumentation::reporter_main, this);
+}
+
+void Instrumentation::stop_reporter() {
+    if (reporter.joinable()) {
+        reporter_running.store(false);
+        reporter.join();
+    }
+}
+
+void Instrumentation::reporter_main() {
+    const char* path = getenv("TEST_SYNTH_STATS_FILE");
+    FILE* file = (path != nullptr) ? fopen(path, "a") : nullptr;
+    if (file == nullptr) {
+        file = stdout;
+    }
+
+    uint32_t waited_ms = 0;
+    while (reporter_running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        waited_ms += 50;
+        if (waited_ms >= report_interval_ms) {
+            write_report(file);
+            waited_ms = 0;
+        }
+    }
+    write_report(file);
+
+    if (file != stdout) {
+        fclose(file);
+    }
+}
+
+#endif
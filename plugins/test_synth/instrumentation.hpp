@@ -0,0 +1,103 @@
+/*
+instrumentation.hpp
+Real-time performance instrumentation for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Build with `make INSTRUMENTATION=true` to enable. When disabled, Instrumentation is an empty class
+// whose methods do nothing, so none of this costs anything.
+#ifndef ENABLE_INSTRUMENTATION
+#define ENABLE_INSTRUMENTATION 0
+#endif
+
+#if ENABLE_INSTRUMENTATION
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#endif
+
+class Instrumentation {
+    // Timing histograms and counters written by the audio thread and read by a reporter thread.
+    // There is a single writer, so the audio thread only does relaxed loads and stores: no locks, no read-modify-writes.
+    // The plugin only starts the reporter in the standalone JACK build, where stdout belongs to us; it prints
+    // to stdout, or appends to the file named by the TEST_SYNTH_STATS_FILE environment variable.
+    public:
+    enum Phase : uint8_t {
+        midi,      // process_midi_event()
+        voices,    // rendering and freeing voices
+        mixdown,   // clearing and copying the output buffers
+        total,     // the whole of run()
+        phase_count,
+    };
+
+#if ENABLE_INSTRUMENTATION
+    static const uint32_t bucket_count = 32; // bucket n counts durations in [2^n, 2^(n+1)) ns
+
+    Instrumentation();
+    ~Instrumentation();
+
+    static uint64_t now(); // ns, monotonic
+
+    void record(Phase phase, uint64_t duration_ns); // once per block per phase
+    void end_block(uint64_t duration_ns, double deadline_s, uint32_t live_voices_in); // records the total too
+
+    void start_reporter(); // not RT safe; call from activate()
+    void stop_reporter();  // not RT safe; call from deactivate()
+    void write_report(FILE* file); // everything since the last report
+
+    protected:
+    struct Histogram {
+        std::atomic<uint64_t> buckets[bucket_count];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum_ns;
+        std::atomic<uint64_t> max_ns;
+    };
+    struct Snapshot {
+        uint64_t buckets[bucket_count];
+        uint64_t count;
+        uint64_t sum_ns;
+    };
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    void reporter_main();
+
+    Histogram histograms[phase_count];
+    std::atomic<uint64_t> blocks;
+    std::atomic<uint64_t> deadline_misses;
+    std::atomic<uint32_t> live_voices;
+    std::atomic<uint32_t> peak_voices;
+
+    // reporter-side state
+    Snapshot last_reported[phase_count];
+    uint64_t last_blocks;
+    uint64_t last_deadline_misses;
+    std::thread reporter;
+    std::atomic<bool> reporter_running;
+#else
+    static uint64_t now() { return 0; }
+    void record(Phase, uint64_t) {}
+    void end_block(uint64_t, double, uint32_t) {}
+    void start_reporter() {}
+    void stop_reporter() {}
+#endif
+};
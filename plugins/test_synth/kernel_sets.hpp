@@ -0,0 +1,329 @@
+/*
+kernel_sets.hpp
+Per-instruction-set DSP kernel tables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+// Shared between the kernel implementations; the rest of the plugin only needs kernels.hpp
+
+#include "kernels.hpp"
+#include "wavetables.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// GCC and Clang can compile individual functions for instruction sets beyond the build's baseline, which keeps AVX
+// instructions out of everything but the kernels that are only called once the CPU is known to support them.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KERNELS_X86_DISPATCH 1
+#else
+#define KERNELS_X86_DISPATCH 0
+#endif
+
+// One implementation of every kernel in kernels.hpp, for one instruction set
+struct Kernel_Table {
+    void (*accumulate_fast_sine)(float*, uint32_t, uint32_t&, uint32_t, float, float);
+    void (*accumulate_wavetable)(float*, uint32_t, uint32_t&, uint32_t, const Wavetable_Levels&, float, float);
+    void (*accumulate_pulse)(float*, uint32_t, uint32_t&, uint32_t, const Pulse_Shape&, float, float);
+    void (*accumulate_additive)(float*, uint32_t, uint32_t&, uint32_t, const Additive_Partials&, float, float);
+    void (*accumulate_modulated_sine)(float*, uint32_t, uint32_t&, uint32_t, const float*, float, float);
+    void (*accumulate_unison_fast_sine)(float*, float*, uint32_t, const Unison_Copies&, float, float);
+    void (*accumulate_unison_wavetable)(float*, float*, uint32_t, const Unison_Copies&, const Wavetable_Levels&, float, float);
+    void (*accumulate_unison_pulse)(float*, float*, uint32_t, const Unison_Copies&, const Pulse_Shape&, float, float);
+    void (*accumulate_unison_additive)(float*, float*, uint32_t, const Unison_Copies&, const Additive_Partials&, float, float);
+    void (*fill_ramp)(float*, uint32_t, float, float);
+    void (*multiply_block)(float*, const float*, uint32_t);
+    void (*mid_side_to_left_right)(float*, float*, uint32_t);
+    void (*accumulate_panned)(float*, float*, const float*, const float*, uint32_t, const Pan_Gains&);
+    void (*mix_feedback_lines)(float* const*, uint32_t, uint32_t, const float*, const float*, float*, float*);
+};
+
+// null when the compiler can't build the set; whether the CPU can run it is checked separately
+const Kernel_Table* get_avx2_kernels();   // kernels_avx.cpp
+const Kernel_Table* get_avx512_kernels(); // kernels_avx.cpp
+
+// The phase to sample functions, one phase at a time. Every set uses these for the frames left after the last whole
+// vector, and the vector versions derive from them.
+struct Fast_Sine_Lanes {
+    float operator()(uint32_t phase) const { return fast_sine(phase); }
+};
+
+struct Wavetable_Lanes {
+    Wavetable_Levels levels;
+
+    float operator()(uint32_t phase) const {
+        float a = Wavetable::lookup(levels.level_a, phase);
+        float b = Wavetable::lookup(levels.level_b, phase);
+        return a + levels.b_weight*(b - a);
+    }
+};
+
+// The saw table is 0 at phase 0 and jumps at half a cycle, so reading it half a cycle later gives a ramp from -1 to 1.
+// ramp(phase) - ramp(phase - duty) is 2*duty - 2 while the phase is inside the first `duty` of the cycle, and 2*duty elsewhere.
+const uint32_t half_cycle = 0x80000000u;
+
+struct Pulse_Lanes {
+    Pulse_Shape shape;
+
+    float operator()(uint32_t phase) const {
+        uint32_t ramp_phase = phase + half_cycle;
+        float a = Wavetable::lookup(shape.saw.level_a, ramp_phase - shape.duty_phase) - Wavetable::lookup(shape.saw.level_a, ramp_phase);
+        float b = Wavetable::lookup(shape.saw.level_b, ramp_phase - shape.duty_phase) - Wavetable::lookup(shape.saw.level_b, ramp_phase);
+        return a + shape.saw.b_weight*(b - a) + shape.dc_offset;
+    }
+};
+
+// The sum of amplitude*sin(harmonic*phase) over the partials. Each chain steps with the Chebyshev recurrence
+// sin((k + n)x) = 2cos(nx)sin(kx) - sin((k - n)x), n = additive_chains, in Reinsch's form: it carries the difference
+// between consecutive sines and adds (2cos(nx) - 2)sin(kx) to it, which stays accurate at low pitches, where 2cos(nx)
+// would round to 2. Fixed-point phases multiply exactly, so a restart is just two fast_sine() calls per chain.
+// The vector versions do the same operations in the same order, so every set gives the same samples.
+static_assert(additive_chains == 4, "the additive kernels add each step's terms as a tree of four");
+
+struct Additive_Lanes {
+    Additive_Partials partials;
+
+    float operator()(uint32_t phase) const {
+        // 2cos(nx) - 2 = -4sin^2(nx/2)
+        const float step_sine = fast_sine((additive_chains/2)*phase);
+        const float step = -4*step_sine*step_sine;
+        float sum = 0;
+        for (uint32_t first = 0; first < partials.count; first += additive_restart_partials) {
+            float sines[additive_chains];
+            float differences[additive_chains];
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                const uint32_t harmonic = first + c_idx + 1;
+                sines[c_idx] = fast_sine(harmonic*phase);
+                differences[c_idx] = sines[c_idx] - fast_sine((harmonic - additive_chains)*phase);
+            }
+            const uint32_t last = (partials.count < first + additive_restart_partials) ? partials.count : first + additive_restart_partials;
+            for (uint32_t p_idx = first; p_idx < last; p_idx += additive_chains) {
+                float terms[additive_chains];
+                for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                    terms[c_idx] = partials.amplitudes[p_idx + c_idx]*sines[c_idx];
+                    differences[c_idx] += step*sines[c_idx];
+                    sines[c_idx] += differences[c_idx];
+                }
+                sum += (terms[0] + terms[1]) + (terms[2] + terms[3]);
+            }
+        }
+        return sum;
+    }
+};
+
+#if defined(__SSE2__)
+// The same four phases at a time. The wider sets derive from these, so every set can fall back to narrower vectors.
+struct Fast_Sine_Lanes_SSE2 : Fast_Sine_Lanes {
+    using Fast_Sine_Lanes::operator();
+    __m128 operator()(__m128i phases) const {
+        const __m128 sign_mask = _mm_set1_ps(-0.f);
+        __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(phases), _mm_set1_ps(phase_to_cycles));
+
+        // fold |x| > 0.25 back into [-0.25, 0.25]: x -> copysign(0.5, x) - x
+        __m128 sign = _mm_and_ps(x, sign_mask);
+        __m128 abs_x = _mm_andnot_ps(sign_mask, x);
+        __m128 folded = _mm_sub_ps(_mm_or_ps(_mm_set1_ps(0.5f), sign), x);
+        __m128 fold = _mm_cmpgt_ps(abs_x, _mm_set1_ps(0.25f));
+        x = _mm_or_ps(_mm_and_ps(fold, folded), _mm_andnot_ps(fold, x));
+
+        __m128 x2 = _mm_mul_ps(x, x);
+        __m128 y = _mm_set1_ps(fast_sine_c9);
+        y = _mm_add_ps(_mm_mul_ps(y, x2), _mm_set1_ps(fast_sine_c7));
+        y = _mm_add_ps(_mm_mul_ps(y, x2), _mm_set1_ps(fast_sine_c5));
+        y = _mm_add_ps(_mm_mul_ps(y, x2), _mm_set1_ps(fast_sine_c3));
+        y = _mm_add_ps(_mm_mul_ps(y, x2), _mm_set1_ps(fast_sine_c1));
+        return _mm_mul_ps(y, x);
+    }
+};
+
+// Wavetable::lookup() of four phases; SSE2 has no gather, so the table reads are scalar and the interpolation isn't
+inline __m128 lookup_sse2(const float* level, __m128i phases) {
+    const uint32_t frac_bits = 32 - Wavetable::size_bits;
+    alignas(16) uint32_t index[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(index), _mm_srli_epi32(phases, frac_bits));
+    __m128 left = _mm_setr_ps(level[index[0]], level[index[1]], level[index[2]], level[index[3]]);
+    __m128 right = _mm_setr_ps(level[index[0] + 1], level[index[1] + 1], level[index[2] + 1], level[index[3] + 1]);
+    __m128i frac_fixed = _mm_and_si128(phases, _mm_set1_epi32((1 << frac_bits) - 1));
+    __m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(frac_fixed), _mm_set1_ps(1.f/(1u << frac_bits)));
+    return _mm_add_ps(left, _mm_mul_ps(frac, _mm_sub_ps(right, left)));
+}
+
+struct Wavetable_Lanes_SSE2 : Wavetable_Lanes {
+    using Wavetable_Lanes::operator();
+    __m128 operator()(__m128i phases) const {
+        __m128 a = lookup_sse2(levels.level_a, phases);
+        __m128 b = lookup_sse2(levels.level_b, phases);
+        return _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(levels.b_weight), _mm_sub_ps(b, a)));
+    }
+};
+
+struct Pulse_Lanes_SSE2 : Pulse_Lanes {
+    using Pulse_Lanes::operator();
+    __m128 operator()(__m128i phases) const {
+        __m128i ramp_phases = _mm_add_epi32(phases, _mm_set1_epi32(int32_t(half_cycle)));
+        __m128i duty_phases = _mm_sub_epi32(ramp_phases, _mm_set1_epi32(int32_t(shape.duty_phase)));
+        __m128 a = _mm_sub_ps(lookup_sse2(shape.saw.level_a, duty_phases), lookup_sse2(shape.saw.level_a, ramp_phases));
+        __m128 b = _mm_sub_ps(lookup_sse2(shape.saw.level_b, duty_phases), lookup_sse2(shape.saw.level_b, ramp_phases));
+        __m128 y = _mm_add_ps(a, _mm_mul_ps(_mm_set1_ps(shape.saw.b_weight), _mm_sub_ps(b, a)));
+        return _mm_add_ps(y, _mm_set1_ps(shape.dc_offset));
+    }
+};
+
+struct Additive_Lanes_SSE2 : Additive_Lanes {
+    using Additive_Lanes::operator();
+    __m128 operator()(__m128i phases) const {
+        const Fast_Sine_Lanes_SSE2 sine;
+        const __m128 step_sine = sine(_mm_slli_epi32(phases, additive_chain_bits - 1));
+        const __m128 step = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-4.f), step_sine), step_sine);
+        // SSE2 has no 32-bit multiply, so the restarts walk through the harmonics' phases by adding
+        __m128i lowest = _mm_sub_epi32(phases, _mm_slli_epi32(phases, additive_chain_bits)); // harmonic first + 1 - additive_chains
+        const __m128i restart_step = _mm_slli_epi32(phases, additive_restart_bits);
+        __m128 sum = _mm_setzero_ps();
+        for (uint32_t first = 0; first < partials.count; first += additive_restart_partials) {
+            __m128 sines[additive_chains];
+            __m128 differences[additive_chains];
+            __m128i harmonic_phases = lowest;
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                differences[c_idx] = sine(harmonic_phases);
+                harmonic_phases = _mm_add_epi32(harmonic_phases, phases);
+            }
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                sines[c_idx] = sine(harmonic_phases);
+                differences[c_idx] = _mm_sub_ps(sines[c_idx], differences[c_idx]);
+                harmonic_phases = _mm_add_epi32(harmonic_phases, phases);
+            }
+            lowest = _mm_add_epi32(lowest, restart_step);
+
+            const uint32_t last = (partials.count < first + additive_restart_partials) ? partials.count : first + additive_restart_partials;
+            for (uint32_t p_idx = first; p_idx < last; p_idx += additive_chains) {
+                __m128 terms[additive_chains];
+                for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                    terms[c_idx] = _mm_mul_ps(_mm_set1_ps(partials.amplitudes[p_idx + c_idx]), sines[c_idx]);
+                    differences[c_idx] = _mm_add_ps(differences[c_idx], _mm_mul_ps(step, sines[c_idx]));
+                    sines[c_idx] = _mm_add_ps(sines[c_idx], differences[c_idx]);
+                }
+                sum = _mm_add_ps(sum, _mm_add_ps(_mm_add_ps(terms[0], terms[1]), _mm_add_ps(terms[2], terms[3])));
+            }
+        }
+        return sum;
+    }
+};
+
+// modulation_phase() of four frames; the conversion truncates like the scalar cast
+inline __m128i modulation_phases_sse2(__m128 cycles) {
+    return _mm_slli_epi32(_mm_cvttps_epi32(_mm_mul_ps(cycles, _mm_set1_ps(modulation_scale))), modulation_shift);
+}
+
+// Add four frames of four-lane sums to mid and side: rows are frames and columns are lanes, so after transposing,
+// summing the rows sums each frame's lanes. Shared with the wider sets, which fold their lanes down to four first.
+inline void store_unison_frames(float* mid, float* side, __m128 (&mid_frames)[4], __m128 (&side_frames)[4], float amplitude, float amplitude_step) {
+    _MM_TRANSPOSE4_PS(mid_frames[0], mid_frames[1], mid_frames[2], mid_frames[3]);
+    _MM_TRANSPOSE4_PS(side_frames[0], side_frames[1], side_frames[2], side_frames[3]);
+    __m128 mid_sum = _mm_add_ps(_mm_add_ps(mid_frames[0], mid_frames[1]), _mm_add_ps(mid_frames[2], mid_frames[3]));
+    __m128 side_sum = _mm_add_ps(_mm_add_ps(side_frames[0], side_frames[1]), _mm_add_ps(side_frames[2], side_frames[3]));
+
+    __m128 gain = _mm_setr_ps(amplitude, amplitude + amplitude_step, amplitude + 2*amplitude_step, amplitude + 3*amplitude_step);
+    _mm_storeu_ps(mid, _mm_add_ps(_mm_loadu_ps(mid), _mm_mul_ps(mid_sum, gain)));
+    _mm_storeu_ps(side, _mm_add_ps(_mm_loadu_ps(side), _mm_mul_ps(side_sum, gain)));
+}
+#endif
+
+// accumulate_panned() from frame `first` on, with the gains at each frame computed from its index like fill_ramp()
+inline void accumulate_panned_frames(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t first, uint32_t frames, const Pan_Gains& gains) {
+    for (uint32_t f_idx = first; f_idx < frames; ++f_idx) {
+        const float mid_gain = gains.mid + float(f_idx)*gains.mid_step;
+        const float side_gain = gains.side + float(f_idx)*gains.side_step;
+        const float y_mid = voice_mid[f_idx];
+        const float y_side = (voice_side != nullptr) ? voice_side[f_idx] : 0.f;
+        mid[f_idx] += mid_gain*y_mid + side_gain*y_side;
+        side[f_idx] += side_gain*y_mid + mid_gain*y_side;
+    }
+}
+
+// mix_feedback_lines() for the frames from `first` on, one at a time. The vector versions do the same operations in
+// the same order on whole vectors of frames.
+template <uint32_t line_count>
+inline void mix_feedback_frames(float* const* lines, uint32_t first, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    for (uint32_t f_idx = first; f_idx < frames; ++f_idx) {
+        float y[line_count];
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            y[l_idx] = lines[l_idx][f_idx];
+        }
+        float left = y[0];
+        float right = y[1];
+        for (uint32_t l_idx = 2; l_idx < line_count; l_idx += 2) {
+            left += (l_idx & 2) ? -y[l_idx] : y[l_idx];
+            right += (l_idx & 2) ? -y[l_idx + 1] : y[l_idx + 1];
+        }
+        // Sylvester's construction: log2(line_count) rounds of sums and differences
+        for (uint32_t stride = 1; stride < line_count; stride *= 2) {
+            for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+                if ((l_idx & stride) == 0) {
+                    const float a = y[l_idx];
+                    const float b = y[l_idx + stride];
+                    y[l_idx] = a + b;
+                    y[l_idx + stride] = a - b;
+                }
+            }
+        }
+        for (uint32_t l_idx = 0; l_idx < line_count; l_idx += 2) {
+            lines[l_idx][f_idx] = y[l_idx] + in_left[f_idx];
+            lines[l_idx + 1][f_idx] = y[l_idx + 1] + in_right[f_idx];
+        }
+        out_left[f_idx] = left;
+        out_right[f_idx] = right;
+    }
+}
+
+template <typename Evaluate>
+inline void accumulate_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        phase += increment;
+        out[f_idx] += amplitude*evaluate(phase);
+        amplitude += amplitude_step;
+    }
+}
+
+// accumulate_scalar() with each frame's phase offset by modulation[f] cycles (see modulation_phase())
+template <typename Evaluate>
+inline void accumulate_modulated_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        phase += increment;
+        out[f_idx] += amplitude*evaluate(phase + modulation_phase(modulation[f_idx]));
+        amplitude += amplitude_step;
+    }
+}
+
+template <typename Evaluate>
+inline void accumulate_unison_scalar(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        float mid_sum = 0;
+        float side_sum = 0;
+        for (uint32_t c_idx = 0; c_idx < copies.count; ++c_idx) {
+            copies.phases[c_idx] += copies.increments[c_idx];
+            float y = evaluate(copies.phases[c_idx]);
+            mid_sum += y*copies.mid_gains[c_idx];
+            side_sum += y*copies.side_gains[c_idx];
+        }
+        mid[f_idx] += amplitude*mid_sum;
+        side[f_idx] += amplitude*side_sum;
+        amplitude += amplitude_step;
+    }
+}
@@ -0,0 +1,497 @@
+/*
+kernels.cpp
+Block-rate DSP kernels for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "kernel_sets.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// MXCSR flush-to-zero (bit 15) and denormals-are-zero (bit 6); FPCR flush-to-zero (bit 24)
+static const uint32_t mxcsr_ftz_daz = 0x8040;
+static const uint64_t fpcr_fz = 1u << 24;
+
+Denormal_Guard::Denormal_Guard() {
+#if defined(__SSE__)
+    saved_mode = _mm_getcsr();
+    _mm_setcsr(uint32_t(saved_mode) | mxcsr_ftz_daz);
+#elif defined(__aarch64__)
+    asm volatile("mrs %0, fpcr" : "=r"(saved_mode));
+    asm volatile("msr fpcr, %0" : : "r"(saved_mode | fpcr_fz));
+#else
+    saved_mode = 0;
+#endif
+}
+
+Denormal_Guard::~Denormal_Guard() {
+#if defined(__SSE__)
+    _mm_setcsr(uint32_t(saved_mode));
+#elif defined(__aarch64__)
+    asm volatile("msr fpcr, %0" : : "r"(saved_mode));
+#endif
+}
+
+// scalar: the reference every other set has to match
+
+static void accumulate_fast_sine_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step) {
+    accumulate_scalar(out, frames, phase, increment, amplitude, amplitude_step, Fast_Sine_Lanes());
+}
+static void accumulate_wavetable_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_scalar(out, frames, phase, increment, amplitude, amplitude_step, Wavetable_Lanes{levels});
+}
+static void accumulate_pulse_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_scalar(out, frames, phase, increment, amplitude, amplitude_step, Pulse_Lanes{shape});
+}
+static void accumulate_additive_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_scalar(out, frames, phase, increment, amplitude, amplitude_step, Additive_Lanes{partials});
+}
+static void accumulate_modulated_sine_scalar(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step) {
+    accumulate_modulated_scalar(out, frames, phase, increment, modulation, amplitude, amplitude_step, Fast_Sine_Lanes());
+}
+static void accumulate_unison_fast_sine_scalar(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step) {
+    accumulate_unison_scalar(mid, side, frames, copies, amplitude, amplitude_step, Fast_Sine_Lanes());
+}
+static void accumulate_unison_wavetable_scalar(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_unison_scalar(mid, side, frames, copies, amplitude, amplitude_step, Wavetable_Lanes{levels});
+}
+static void accumulate_unison_pulse_scalar(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_unison_scalar(mid, side, frames, copies, amplitude, amplitude_step, Pulse_Lanes{shape});
+}
+static void accumulate_unison_additive_scalar(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_unison_scalar(mid, side, frames, copies, amplitude, amplitude_step, Additive_Lanes{partials});
+}
+static void fill_ramp_scalar(float* out, uint32_t frames, float start, float step) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        out[f_idx] = start + float(f_idx)*step;
+    }
+}
+static void multiply_block_scalar(float* out, const float* gains, uint32_t frames) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        out[f_idx] *= gains[f_idx];
+    }
+}
+static void mid_side_to_left_right_scalar(float* mid_left, float* side_right, uint32_t frames) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        float mid = mid_left[f_idx];
+        float side = side_right[f_idx];
+        mid_left[f_idx] = mid + side;
+        side_right[f_idx] = mid - side;
+    }
+}
+static void accumulate_panned_scalar(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains) {
+    accumulate_panned_frames(mid, side, voice_mid, voice_side, 0, frames, gains);
+}
+static void mix_feedback_lines_scalar(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    if (line_count == 16) {
+        mix_feedback_frames<16>(lines, 0, frames, in_left, in_right, out_left, out_right);
+    } else {
+        mix_feedback_frames<8>(lines, 0, frames, in_left, in_right, out_left, out_right);
+    }
+}
+
+static const Kernel_Table scalar_kernels = {
+    accumulate_fast_sine_scalar,
+    accumulate_wavetable_scalar,
+    accumulate_pulse_scalar,
+    accumulate_additive_scalar,
+    accumulate_modulated_sine_scalar,
+    accumulate_unison_fast_sine_scalar,
+    accumulate_unison_wavetable_scalar,
+    accumulate_unison_pulse_scalar,
+    accumulate_unison_additive_scalar,
+    fill_ramp_scalar,
+    multiply_block_scalar,
+    mid_side_to_left_right_scalar,
+    accumulate_panned_scalar,
+    mix_feedback_lines_scalar,
+};
+
+#if defined(__SSE2__)
+// SSE2: four lanes. Part of the x86-64 baseline, so it needs no special compiler flags.
+
+template <typename Evaluate>
+static void accumulate_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 4) {
+        // four consecutive frames per iteration; the integer adds wrap exactly like the scalar accumulator
+        __m128i phases = _mm_setr_epi32(phase + increment, phase + 2*increment, phase + 3*increment, phase + 4*increment);
+        const __m128i step = _mm_set1_epi32(4*increment);
+        __m128 gain = _mm_setr_ps(amplitude, amplitude + amplitude_step, amplitude + 2*amplitude_step, amplitude + 3*amplitude_step);
+        const __m128 gain_step = _mm_set1_ps(4*amplitude_step);
+
+        for (; f_idx + 4 <= frames; f_idx += 4) {
+            __m128 y = evaluate(phases);
+            _mm_storeu_ps(out + f_idx, _mm_add_ps(_mm_loadu_ps(out + f_idx), _mm_mul_ps(y, gain)));
+            phases = _mm_add_epi32(phases, step);
+            gain = _mm_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    accumulate_scalar(out + f_idx, frames - f_idx, phase, increment, amplitude, amplitude_step, evaluate);
+}
+
+template <typename Evaluate>
+static void accumulate_modulated_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 4) {
+        __m128i phases = _mm_setr_epi32(phase + increment, phase + 2*increment, phase + 3*increment, phase + 4*increment);
+        const __m128i step = _mm_set1_epi32(4*increment);
+        __m128 gain = _mm_setr_ps(amplitude, amplitude + amplitude_step, amplitude + 2*amplitude_step, amplitude + 3*amplitude_step);
+        const __m128 gain_step = _mm_set1_ps(4*amplitude_step);
+
+        for (; f_idx + 4 <= frames; f_idx += 4) {
+            __m128 y = evaluate(_mm_add_epi32(phases, modulation_phases_sse2(_mm_loadu_ps(modulation + f_idx))));
+            _mm_storeu_ps(out + f_idx, _mm_add_ps(_mm_loadu_ps(out + f_idx), _mm_mul_ps(y, gain)));
+            phases = _mm_add_epi32(phases, step);
+            gain = _mm_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    accumulate_modulated_scalar(out + f_idx, frames - f_idx, phase, increment, modulation + f_idx, amplitude, amplitude_step, evaluate);
+}
+
+template <typename Evaluate>
+static void accumulate_unison_sse2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    const uint32_t lane_groups = (copies.count + 3)/4;
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        __m128 mid_frames[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+        __m128 side_frames[4] = {_mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps()};
+        for (uint32_t group = 0; group < lane_groups; ++group) {
+            __m128i phase = _mm_loadu_si128(reinterpret_cast<const __m128i*>(copies.phases + 4*group));
+            const __m128i increment = _mm_loadu_si128(reinterpret_cast<const __m128i*>(copies.increments + 4*group));
+            const __m128 mid_gain = _mm_loadu_ps(copies.mid_gains + 4*group);
+            const __m128 side_gain = _mm_loadu_ps(copies.side_gains + 4*group);
+            for (uint32_t frame = 0; frame < 4; ++frame) {
+                phase = _mm_add_epi32(phase, increment);
+                __m128 y = evaluate(phase);
+                mid_frames[frame] = _mm_add_ps(mid_frames[frame], _mm_mul_ps(y, mid_gain));
+                side_frames[frame] = _mm_add_ps(side_frames[frame], _mm_mul_ps(y, side_gain));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(copies.phases + 4*group), phase);
+        }
+        store_unison_frames(mid + f_idx, side + f_idx, mid_frames, side_frames, amplitude, amplitude_step);
+        amplitude += 4*amplitude_step;
+    }
+    accumulate_unison_scalar(mid + f_idx, side + f_idx, frames - f_idx, copies, amplitude, amplitude_step, evaluate);
+}
+
+static void accumulate_fast_sine_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step) {
+    accumulate_sse2(out, frames, phase, increment, amplitude, amplitude_step, Fast_Sine_Lanes_SSE2());
+}
+static void accumulate_wavetable_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_sse2(out, frames, phase, increment, amplitude, amplitude_step, Wavetable_Lanes_SSE2{{levels}});
+}
+static void accumulate_pulse_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_sse2(out, frames, phase, increment, amplitude, amplitude_step, Pulse_Lanes_SSE2{{shape}});
+}
+static void accumulate_additive_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_sse2(out, frames, phase, increment, amplitude, amplitude_step, Additive_Lanes_SSE2{{partials}});
+}
+static void accumulate_modulated_sine_sse2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step) {
+    accumulate_modulated_sse2(out, frames, phase, increment, modulation, amplitude, amplitude_step, Fast_Sine_Lanes_SSE2());
+}
+static void accumulate_unison_fast_sine_sse2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step) {
+    accumulate_unison_sse2(mid, side, frames, copies, amplitude, amplitude_step, Fast_Sine_Lanes_SSE2());
+}
+static void accumulate_unison_wavetable_sse2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_unison_sse2(mid, side, frames, copies, amplitude, amplitude_step, Wavetable_Lanes_SSE2{{levels}});
+}
+static void accumulate_unison_pulse_sse2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_unison_sse2(mid, side, frames, copies, amplitude, amplitude_step, Pulse_Lanes_SSE2{{shape}});
+}
+static void accumulate_unison_additive_sse2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_unison_sse2(mid, side, frames, copies, amplitude, amplitude_step, Additive_Lanes_SSE2{{partials}});
+}
+
+static void fill_ramp_sse2(float* out, uint32_t frames, float start, float step) {
+    const __m128 starts = _mm_set1_ps(start);
+    const __m128 steps = _mm_set1_ps(step);
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i four = _mm_set1_epi32(4);
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        _mm_storeu_ps(out + f_idx, _mm_add_ps(starts, _mm_mul_ps(_mm_cvtepi32_ps(indices), steps)));
+        indices = _mm_add_epi32(indices, four);
+    }
+    for (; f_idx < frames; ++f_idx) {
+        out[f_idx] = start + float(f_idx)*step;
+    }
+}
+static void multiply_block_sse2(float* out, const float* gains, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        _mm_storeu_ps(out + f_idx, _mm_mul_ps(_mm_loadu_ps(out + f_idx), _mm_loadu_ps(gains + f_idx)));
+    }
+    multiply_block_scalar(out + f_idx, gains + f_idx, frames - f_idx);
+}
+static void mid_side_to_left_right_sse2(float* mid_left, float* side_right, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        __m128 mid = _mm_loadu_ps(mid_left + f_idx);
+        __m128 side = _mm_loadu_ps(side_right + f_idx);
+        _mm_storeu_ps(mid_left + f_idx, _mm_add_ps(mid, side));
+        _mm_storeu_ps(side_right + f_idx, _mm_sub_ps(mid, side));
+    }
+    mid_side_to_left_right_scalar(mid_left + f_idx, side_right + f_idx, frames - f_idx);
+}
+static void accumulate_panned_sse2(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains) {
+    const __m128 mid_steps = _mm_set1_ps(gains.mid_step);
+    const __m128 side_steps = _mm_set1_ps(gains.side_step);
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i four = _mm_set1_epi32(4);
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        const __m128 index = _mm_cvtepi32_ps(indices);
+        const __m128 mid_gain = _mm_add_ps(_mm_set1_ps(gains.mid), _mm_mul_ps(index, mid_steps));
+        const __m128 side_gain = _mm_add_ps(_mm_set1_ps(gains.side), _mm_mul_ps(index, side_steps));
+        const __m128 y_mid = _mm_loadu_ps(voice_mid + f_idx);
+        const __m128 y_side = (voice_side != nullptr) ? _mm_loadu_ps(voice_side + f_idx) : _mm_setzero_ps();
+        _mm_storeu_ps(mid + f_idx, _mm_add_ps(_mm_loadu_ps(mid + f_idx), _mm_add_ps(_mm_mul_ps(mid_gain, y_mid), _mm_mul_ps(side_gain, y_side))));
+        _mm_storeu_ps(side + f_idx, _mm_add_ps(_mm_loadu_ps(side + f_idx), _mm_add_ps(_mm_mul_ps(side_gain, y_mid), _mm_mul_ps(mid_gain, y_side))));
+        indices = _mm_add_epi32(indices, four);
+    }
+    accumulate_panned_frames(mid, side, voice_mid, voice_side, f_idx, frames, gains);
+}
+template <uint32_t line_count>
+static void mix_feedback_sse2(float* const* lines, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        __m128 y[line_count];
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            y[l_idx] = _mm_loadu_ps(lines[l_idx] + f_idx);
+        }
+        __m128 left = y[0];
+        __m128 right = y[1];
+        for (uint32_t l_idx = 2; l_idx < line_count; l_idx += 2) {
+            if (l_idx & 2) {
+                left = _mm_sub_ps(left, y[l_idx]);
+                right = _mm_sub_ps(right, y[l_idx + 1]);
+            } else {
+                left = _mm_add_ps(left, y[l_idx]);
+                right = _mm_add_ps(right, y[l_idx + 1]);
+            }
+        }
+        for (uint32_t stride = 1; stride < line_count; stride *= 2) {
+            for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+                if ((l_idx & stride) == 0) {
+                    const __m128 a = y[l_idx];
+                    const __m128 b = y[l_idx + stride];
+                    y[l_idx] = _mm_add_ps(a, b);
+                    y[l_idx + stride] = _mm_sub_ps(a, b);
+                }
+            }
+        }
+        const __m128 x_left = _mm_loadu_ps(in_left + f_idx);
+        const __m128 x_right = _mm_loadu_ps(in_right + f_idx);
+        for (uint32_t l_idx = 0; l_idx < line_count; l_idx += 2) {
+            _mm_storeu_ps(lines[l_idx] + f_idx, _mm_add_ps(y[l_idx], x_left));
+            _mm_storeu_ps(lines[l_idx + 1] + f_idx, _mm_add_ps(y[l_idx + 1], x_right));
+        }
+        _mm_storeu_ps(out_left + f_idx, left);
+        _mm_storeu_ps(out_right + f_idx, right);
+    }
+    mix_feedback_frames<line_count>(lines, f_idx, frames, in_left, in_right, out_left, out_right);
+}
+static void mix_feedback_lines_sse2(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    if (line_count == 16) {
+        mix_feedback_sse2<16>(lines, frames, in_left, in_right, out_left, out_right);
+    } else {
+        mix_feedback_sse2<8>(lines, frames, in_left, in_right, out_left, out_right);
+    }
+}
+
+static const Kernel_Table sse2_kernels = {
+    accumulate_fast_sine_sse2,
+    accumulate_wavetable_sse2,
+    accumulate_pulse_sse2,
+    accumulate_additive_sse2,
+    accumulate_modulated_sine_sse2,
+    accumulate_unison_fast_sine_sse2,
+    accumulate_unison_wavetable_sse2,
+    accumulate_unison_pulse_sse2,
+    accumulate_unison_additive_sse2,
+    fill_ramp_sse2,
+    multiply_block_sse2,
+    mid_side_to_left_right_sse2,
+    accumulate_panned_sse2,
+    mix_feedback_lines_sse2,
+};
+#endif
+
+// dispatch
+
+static const Kernel_Table* get_kernels(Kernel_Set set) {
+    switch (set) {
+    case Kernel_Set::scalar:
+        return &scalar_kernels;
+    case Kernel_Set::sse2:
+#if defined(__SSE2__)
+        return &sse2_kernels;
+#else
+        return nullptr;
+#endif
+    case Kernel_Set::avx2:
+        return get_avx2_kernels();
+    case Kernel_Set::avx512:
+        return get_avx512_kernels();
+    default:
+        return nullptr;
+    }
+}
+
+#if defined(__SSE2__)
+static std::atomic<const Kernel_Table*> active_kernels{&sse2_kernels}; // until select_kernels() runs
+static std::atomic<Kernel_Set> active_set{Kernel_Set::sse2};
+#else
+static std::atomic<const Kernel_Table*> active_kernels{&scalar_kernels};
+static std::atomic<Kernel_Set> active_set{Kernel_Set::scalar};
+#endif
+static std::atomic<Kernel_Set> overridden_set{Kernel_Set::automatic};
+
+bool is_kernel_set_supported(Kernel_Set set) {
+    if (set == Kernel_Set::automatic) {
+        return true;
+    }
+    if (get_kernels(set) == nullptr) {
+        return false;
+    }
+#if KERNELS_X86_DISPATCH
+    // checks the CPUID feature bits, and that the OS saves the wider registers
+    __builtin_cpu_init();
+    if (set == Kernel_Set::avx2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (set == Kernel_Set::avx512) {
+        return __builtin_cpu_supports("avx512f");
+    }
+#endif
+    return true;
+}
+
+const char* get_kernel_set_name(Kernel_Set set) {
+    switch (set) {
+    case Kernel_Set::automatic: return "automatic";
+    case Kernel_Set::scalar:    return "scalar";
+    case Kernel_Set::sse2:      return "sse2";
+    case Kernel_Set::avx2:      return "avx2";
+    case Kernel_Set::avx512:    return "avx512";
+    default:                    return "unknown";
+    }
+}
+
+bool override_kernels(Kernel_Set set) {
+    if (!is_kernel_set_supported(set)) {
+        return false;
+    }
+    overridden_set.store(set);
+    return true;
+}
+
+Kernel_Set select_kernels() {
+    Kernel_Set set = overridden_set.load();
+    if (set == Kernel_Set::automatic) {
+        const char* requested = std::getenv("TEST_SYNTH_KERNELS");
+        for (uint8_t s_idx = uint8_t(Kernel_Set::scalar); requested != nullptr && s_idx < uint8_t(Kernel_Set::count); ++s_idx) {
+            if (std::strcmp(requested, get_kernel_set_name(Kernel_Set(s_idx))) == 0 && is_kernel_set_supported(Kernel_Set(s_idx))) {
+                set = Kernel_Set(s_idx);
+            }
+        }
+    }
+    for (uint8_t s_idx = uint8_t(Kernel_Set::count) - 1; set == Kernel_Set::automatic; --s_idx) {
+        if (is_kernel_set_supported(Kernel_Set(s_idx))) {
+            set = Kernel_Set(s_idx);
+        }
+    }
+
+    // Instances share the table, but every instance selects the same set unless a test overrides it in between
+    active_kernels.store(get_kernels(set), std::memory_order_relaxed);
+    active_set.store(set, std::memory_order_relaxed);
+    return set;
+}
+
+Kernel_Set get_kernel_set() {
+    return active_set.load(std::memory_order_relaxed);
+}
+
+void accumulate_fast_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_fast_sine(out, frames, phase, increment, amplitude, amplitude_step);
+}
+void accumulate_wavetable(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_wavetable(out, frames, phase, increment, levels, amplitude, amplitude_step);
+}
+void accumulate_pulse(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_pulse(out, frames, phase, increment, shape, amplitude, amplitude_step);
+}
+void accumulate_additive(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_additive(out, frames, phase, increment, partials, amplitude, amplitude_step);
+}
+void accumulate_modulated_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_modulated_sine(out, frames, phase, increment, modulation, amplitude, amplitude_step);
+}
+void accumulate_unison_fast_sine(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_unison_fast_sine(mid, side, frames, copies, amplitude, amplitude_step);
+}
+void accumulate_unison_wavetable(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_unison_wavetable(mid, side, frames, copies, levels, amplitude, amplitude_step);
+}
+void accumulate_unison_pulse(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_unison_pulse(mid, side, frames, copies, shape, amplitude, amplitude_step);
+}
+void accumulate_unison_additive(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_unison_additive(mid, side, frames, copies, partials, amplitude, amplitude_step);
+}
+// the same in every set, so it isn't in the tables
+void accumulate_feedback_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float* feedback, float feedback_cycles, float amplitude, float amplitude_step) {
+    const float feedback_gain = 0.5f*feedback_cycles;
+    float previous = feedback[1];
+    float latest = feedback[0];
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        phase += increment;
+        const float cycles = feedback_gain*(latest + previous) + ((modulation != nullptr) ? modulation[f_idx] : 0.f);
+        previous = latest;
+        latest = fast_sine(phase + modulation_phase(cycles));
+        out[f_idx] += amplitude*latest;
+        amplitude += amplitude_step;
+    }
+    feedback[0] = latest;
+    feedback[1] = previous;
+}
+void fill_ramp(float* out, uint32_t frames, float start, float step) {
+    active_kernels.load(std::memory_order_relaxed)->fill_ramp(out, frames, start, step);
+}
+void multiply_block(float* out, const float* gains, uint32_t frames) {
+    active_kernels.load(std::memory_order_relaxed)->multiply_block(out, gains, frames);
+}
+void mid_side_to_left_right(float* mid_left, float* side_right, uint32_t frames) {
+    active_kernels.load(std::memory_order_relaxed)->mid_side_to_left_right(mid_left, side_right, frames);
+}
+void accumulate_panned(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains) {
+    active_kernels.load(std::memory_order_relaxed)->accumulate_panned(mid, side, voice_mid, voice_side, frames, gains);
+}
+void mix_feedback_lines(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    active_kernels.load(std::memory_order_relaxed)->mix_feedback_lines(lines, line_count, frames, in_left, in_right, out_left, out_right);
+}
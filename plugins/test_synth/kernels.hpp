@@ -0,0 +1,195 @@
+/*
+kernels.hpp
+Block-rate DSP kernels for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Phases are stored as unsigned 32-bit fixed point, where 2^32 is one full cycle.
+// This makes the phase accumulator wrap for free on overflow.
+const double phase_units_per_cycle = 4294967296.0;
+const float phase_to_cycles = 1.f/4294967296.f;
+
+inline uint32_t phase_from_cycles(double cycles) {
+    return (uint32_t)(int64_t)(cycles*phase_units_per_cycle); // going through int64_t wraps whole cycles away
+}
+
+inline uint32_t phase_increment_from_frequency(double frequency, double sample_period) {
+    double cycles_per_frame = frequency*sample_period;
+    cycles_per_frame -= (int64_t)cycles_per_frame; // anything above one cycle per frame aliases anyway
+    return (uint32_t)(int64_t)(cycles_per_frame*phase_units_per_cycle);
+}
+
+// Polynomial approximation of sin(2*pi*phase), accurate to about 3e-9 before float rounding
+// (so to within a couple of float ulps of the reference Sine_Oscillator).
+// The phase is treated as a signed value in [-0.5, 0.5) cycles, then folded into [-0.25, 0.25].
+const float fast_sine_c1 =   6.283185160126069f;
+const float fast_sine_c3 = -41.341655037258754f;
+const float fast_sine_c5 =  81.60100435790447f;
+const float fast_sine_c7 = -76.54978772671224f;
+const float fast_sine_c9 =  39.536741735887794f;
+
+inline float fast_sine(uint32_t phase) {
+    float x = float(int32_t(phase))*phase_to_cycles;
+    if (x > 0.25f) {
+        x = 0.5f - x;
+    } else if (x < -0.25f) {
+        x = -0.5f - x;
+    }
+    float x2 = x*x;
+    return x*(fast_sine_c1 + x2*(fast_sine_c3 + x2*(fast_sine_c5 + x2*(fast_sine_c7 + x2*fast_sine_c9))));
+}
+
+// Makes the calling thread flush denormal results and inputs to zero while it's in scope (FTZ and DAZ on x86, FZ on
+// AArch64), then restores the previous mode. Release tails and filter states decay through the denormal range,
+// where every operation can be a hundred times slower, and nothing that small is audible.
+class Denormal_Guard {
+    public:
+    Denormal_Guard();
+    ~Denormal_Guard();
+    Denormal_Guard(const Denormal_Guard&) = delete;
+    Denormal_Guard& operator=(const Denormal_Guard&) = delete;
+
+    protected:
+    uint64_t saved_mode;
+};
+
+// The kernels below are compiled for several instruction sets, and select_kernels() picks one set for the whole
+// process at activate(), so one binary uses the widest vectors each machine has without risking illegal instructions.
+// None of them fuse multiplies and adds, so every set produces the same samples up to float rounding in how unison
+// copies are summed: within the benchmark's render_tolerance (1e-5) of the scalar set, which is the reference.
+enum class Kernel_Set : uint8_t {
+    automatic, // the widest set the CPU supports
+    scalar,
+    sse2,
+    avx2,
+    avx512,    // AVX-512F
+    count,
+};
+
+// Pick the kernels for this CPU. A set forced with override_kernels(), or else by the TEST_SYNTH_KERNELS environment
+// variable (scalar, sse2, avx2 or avx512), takes precedence if the CPU supports it. Returns the set now in use.
+// Not RT safe; call from activate().
+Kernel_Set select_kernels();
+bool override_kernels(Kernel_Set set); // for tests and benchmarks; false if the CPU lacks the set. automatic undoes it.
+bool is_kernel_set_supported(Kernel_Set set);
+Kernel_Set get_kernel_set();
+const char* get_kernel_set_name(Kernel_Set set);
+
+// Two adjacent mip levels of a Wavetable, and how far to crossfade from a to b (see Wavetable::select_levels())
+struct Wavetable_Levels {
+    const float* level_a;
+    const float* level_b;
+    float b_weight;
+};
+
+// A pulse built from a saw table: saw(phase - duty_phase) - saw(phase) + dc_offset, read half a cycle later
+struct Pulse_Shape {
+    Wavetable_Levels saw;
+    uint32_t duty_phase;
+    float dc_offset;
+};
+
+// The harmonics of an additive voice: amplitudes[k] is the sine amplitude of harmonic k + 1. count is a multiple of
+// additive_chains, padded with zero amplitudes (see Additive_Spectrum::band_limit()).
+struct Additive_Partials {
+    const float* amplitudes;
+    uint32_t count;
+};
+
+// Additive kernels sum the harmonics with additive_chains interleaved recurrences instead of a sine per harmonic:
+// chain c steps through harmonics c + 1, c + 1 + additive_chains, ..., and every chain restarts from exact sines each
+// additive_restart_partials harmonics, so rounding can't build up however many harmonics there are.
+const uint32_t additive_chain_bits = 2;
+const uint32_t additive_chains = 1 << additive_chain_bits;
+const uint32_t additive_restart_bits = 8;
+const uint32_t additive_restart_partials = 1 << additive_restart_bits;
+
+// Phase modulation arrives as a float in cycles per frame. It's converted in steps of 2^-24 cycles, so the integer
+// conversion can't overflow below 128 cycles, then shifted up to phase units, which wraps whole cycles away.
+const float modulation_scale = 16777216.f;
+const uint32_t modulation_shift = 8;
+
+inline uint32_t modulation_phase(float cycles) {
+    return uint32_t(int32_t(cycles*modulation_scale)) << modulation_shift;
+}
+
+// The detuned copies of one unison voice. Copy c advances phases[c] by increments[c] each frame and is mixed with
+// mid_gains[c] and side_gains[c]. All four arrays hold 16 entries, padded with zero increments and gains past
+// `count`, because the copies are processed a whole vector of lanes at a time.
+struct Unison_Copies {
+    uint32_t* phases;
+    const uint32_t* increments;
+    const float* mid_gains;
+    const float* side_gains;
+    uint32_t count;
+};
+
+// Single voices: advance the phase by `increment` each frame, then add amplitude*waveform(phase) to out,
+// with the amplitude ramping by amplitude_step per frame. Consecutive frames run in vector lanes.
+void accumulate_fast_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step);
+void accumulate_wavetable(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step);
+void accumulate_pulse(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step);
+void accumulate_additive(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step);
+// The same as accumulate_fast_sine(), with modulation[f] cycles added to the phase of frame f (FM operators)
+void accumulate_modulated_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step);
+// A modulated sine that also feeds back into its own phase, by feedback_cycles times the mean of its last two
+// samples, which are kept in feedback[0] and feedback[1]. modulation may be null. Every frame depends on the one
+// before, so there is only a scalar version.
+void accumulate_feedback_sine(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float* feedback, float feedback_cycles, float amplitude, float amplitude_step);
+
+// Unison voices: the same for every copy, added to a mid/side pair. The copies run in vector lanes; every lane group
+// advances four frames, then the frames' lanes are transposed and summed, so each output frame costs a single store
+// however many copies there are.
+void accumulate_unison_fast_sine(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step);
+void accumulate_unison_wavetable(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step);
+void accumulate_unison_pulse(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step);
+void accumulate_unison_additive(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step);
+
+// Write start, start + step, start + 2*step, ... to out. Each value is computed from its index rather than
+// accumulated, so long ramps don't drift.
+void fill_ramp(float* out, uint32_t frames, float start, float step);
+
+// out[i] *= gains[i]
+void multiply_block(float* out, const float* gains, uint32_t frames);
+
+// Convert a mid/side pair to left/right in place: left = mid + side, right = mid - side
+void mid_side_to_left_right(float* mid_left, float* side_right, uint32_t frames);
+
+// How a panned voice reaches a mid/side pair (see constant_power_pan() in unison.hpp), with each gain ramping by its
+// step per frame. A centred voice has a mid gain of 1 and a side gain of 0.
+struct Pan_Gains {
+    float mid;
+    float side;
+    float mid_step;
+    float side_step;
+};
+
+// Add a voice rendered on its own to a mid/side pair, panned: mid += m*voice_mid + s*voice_side and
+// side += s*voice_mid + m*voice_side, where m and s are the gains at each frame. voice_side is null for a mono voice.
+void accumulate_panned(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains);
+
+// One pass of a feedback delay network through line_count (8 or 16) delay lines, frames at a time. lines[l] holds
+// what line l puts out over those frames; it's replaced with what goes back into the line. For each frame, out_left
+// is set to lines 0 - 2 + 4 - 6 ... and out_right to lines 1 - 3 + 5 - 7 ..., then the lines are mixed through an
+// unnormalised Hadamard matrix, and in_left is added to the even lines and in_right to the odd ones. (With the same
+// signs in and out, echoes that visit two lines in either order would add up on the side they went in, and the tail
+// would lean towards it.) Frames run in vector lanes, so the matrix is whole-vector butterflies and never shuffles lanes.
+void mix_feedback_lines(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right);
@@ -0,0 +1,723 @@
+/*
+kernels_avx.cpp
+AVX2 and AVX-512 DSP kernels for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "kernel_sets.hpp"
+
+#if KERNELS_X86_DISPATCH
+#if !defined(__clang__)
+// GCC 12 warns about _mm512_undefined_ps() initialising itself (GCC bug 105593)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+#include <immintrin.h>
+
+// Only these functions may contain AVX instructions; kernels.cpp calls them once the CPU is known to support them.
+// AVX-512F implies FMA, and GNU C++ fuses a*b + c by default, which rounds differently to the scalar code; keep
+// every multiply and add separate so the sets stay interchangeable.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#else
+#pragma GCC optimize("fp-contract=off")
+#endif
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+// AVX2: eight lanes, with hardware gathers for the table reads
+
+struct Fast_Sine_Lanes_AVX2 : Fast_Sine_Lanes_SSE2 {
+    using Fast_Sine_Lanes_SSE2::operator();
+    TARGET_AVX2 __m256 operator()(__m256i phases) const {
+        const __m256 sign_mask = _mm256_set1_ps(-0.f);
+        __m256 x = _mm256_mul_ps(_mm256_cvtepi32_ps(phases), _mm256_set1_ps(phase_to_cycles));
+
+        // fold |x| > 0.25 back into [-0.25, 0.25]: x -> copysign(0.5, x) - x
+        __m256 sign = _mm256_and_ps(x, sign_mask);
+        __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+        __m256 folded = _mm256_sub_ps(_mm256_or_ps(_mm256_set1_ps(0.5f), sign), x);
+        x = _mm256_blendv_ps(x, folded, _mm256_cmp_ps(abs_x, _mm256_set1_ps(0.25f), _CMP_GT_OQ));
+
+        __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 y = _mm256_set1_ps(fast_sine_c9);
+        y = _mm256_add_ps(_mm256_mul_ps(y, x2), _mm256_set1_ps(fast_sine_c7));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x2), _mm256_set1_ps(fast_sine_c5));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x2), _mm256_set1_ps(fast_sine_c3));
+        y = _mm256_add_ps(_mm256_mul_ps(y, x2), _mm256_set1_ps(fast_sine_c1));
+        return _mm256_mul_ps(y, x);
+    }
+};
+
+TARGET_AVX2 static inline __m256 lookup_avx2(const float* level, __m256i phases) {
+    const uint32_t frac_bits = 32 - Wavetable::size_bits;
+    __m256i index = _mm256_srli_epi32(phases, frac_bits);
+    __m256 left = _mm256_i32gather_ps(level, index, 4);
+    __m256 right = _mm256_i32gather_ps(level + 1, index, 4);
+    __m256i frac_fixed = _mm256_and_si256(phases, _mm256_set1_epi32((1 << frac_bits) - 1));
+    __m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(frac_fixed), _mm256_set1_ps(1.f/(1u << frac_bits)));
+    return _mm256_add_ps(left, _mm256_mul_ps(frac, _mm256_sub_ps(right, left)));
+}
+
+struct Wavetable_Lanes_AVX2 : Wavetable_Lanes_SSE2 {
+    using Wavetable_Lanes_SSE2::operator();
+    TARGET_AVX2 __m256 operator()(__m256i phases) const {
+        __m256 a = lookup_avx2(levels.level_a, phases);
+        __m256 b = lookup_avx2(levels.level_b, phases);
+        return _mm256_add_ps(a, _mm256_mul_ps(_mm256_set1_ps(levels.b_weight), _mm256_sub_ps(b, a)));
+    }
+};
+
+struct Pulse_Lanes_AVX2 : Pulse_Lanes_SSE2 {
+    using Pulse_Lanes_SSE2::operator();
+    TARGET_AVX2 __m256 operator()(__m256i phases) const {
+        __m256i ramp_phases = _mm256_add_epi32(phases, _mm256_set1_epi32(int32_t(half_cycle)));
+        __m256i duty_phases = _mm256_sub_epi32(ramp_phases, _mm256_set1_epi32(int32_t(shape.duty_phase)));
+        __m256 a = _mm256_sub_ps(lookup_avx2(shape.saw.level_a, duty_phases), lookup_avx2(shape.saw.level_a, ramp_phases));
+        __m256 b = _mm256_sub_ps(lookup_avx2(shape.saw.level_b, duty_phases), lookup_avx2(shape.saw.level_b, ramp_phases));
+        __m256 y = _mm256_add_ps(a, _mm256_mul_ps(_mm256_set1_ps(shape.saw.b_weight), _mm256_sub_ps(b, a)));
+        return _mm256_add_ps(y, _mm256_set1_ps(shape.dc_offset));
+    }
+};
+
+struct Additive_Lanes_AVX2 : Additive_Lanes_SSE2 {
+    using Additive_Lanes_SSE2::operator();
+    TARGET_AVX2 __m256 operator()(__m256i phases) const {
+        const Fast_Sine_Lanes_AVX2 sine;
+        const __m256 step_sine = sine(_mm256_slli_epi32(phases, additive_chain_bits - 1));
+        const __m256 step = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(-4.f), step_sine), step_sine);
+        __m256i lowest = _mm256_sub_epi32(phases, _mm256_slli_epi32(phases, additive_chain_bits));
+        const __m256i restart_step = _mm256_slli_epi32(phases, additive_restart_bits);
+        __m256 sum = _mm256_setzero_ps();
+        for (uint32_t first = 0; first < partials.count; first += additive_restart_partials) {
+            __m256 sines[additive_chains];
+            __m256 differences[additive_chains];
+            __m256i harmonic_phases = lowest;
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                differences[c_idx] = sine(harmonic_phases);
+                harmonic_phases = _mm256_add_epi32(harmonic_phases, phases);
+            }
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                sines[c_idx] = sine(harmonic_phases);
+                differences[c_idx] = _mm256_sub_ps(sines[c_idx], differences[c_idx]);
+                harmonic_phases = _mm256_add_epi32(harmonic_phases, phases);
+            }
+            lowest = _mm256_add_epi32(lowest, restart_step);
+
+            const uint32_t last = (partials.count < first + additive_restart_partials) ? partials.count : first + additive_restart_partials;
+            for (uint32_t p_idx = first; p_idx < last; p_idx += additive_chains) {
+                __m256 terms[additive_chains];
+                for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                    terms[c_idx] = _mm256_mul_ps(_mm256_set1_ps(partials.amplitudes[p_idx + c_idx]), sines[c_idx]);
+                    differences[c_idx] = _mm256_add_ps(differences[c_idx], _mm256_mul_ps(step, sines[c_idx]));
+                    sines[c_idx] = _mm256_add_ps(sines[c_idx], differences[c_idx]);
+                }
+                sum = _mm256_add_ps(sum, _mm256_add_ps(_mm256_add_ps(terms[0], terms[1]), _mm256_add_ps(terms[2], terms[3])));
+            }
+        }
+        return sum;
+    }
+};
+
+template <typename Evaluate>
+TARGET_AVX2 static void accumulate_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 8) {
+        const __m256i lane = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+        __m256i phases = _mm256_add_epi32(_mm256_set1_epi32(int32_t(phase)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(int32_t(increment))));
+        const __m256i step = _mm256_set1_epi32(int32_t(8*increment));
+        __m256 gain = _mm256_add_ps(_mm256_set1_ps(amplitude), _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(lane, _mm256_set1_epi32(1))), _mm256_set1_ps(amplitude_step)));
+        const __m256 gain_step = _mm256_set1_ps(8*amplitude_step);
+
+        for (; f_idx + 8 <= frames; f_idx += 8) {
+            __m256 y = evaluate(phases);
+            _mm256_storeu_ps(out + f_idx, _mm256_add_ps(_mm256_loadu_ps(out + f_idx), _mm256_mul_ps(y, gain)));
+            phases = _mm256_add_epi32(phases, step);
+            gain = _mm256_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    accumulate_scalar(out + f_idx, frames - f_idx, phase, increment, amplitude, amplitude_step, evaluate);
+}
+
+template <typename Evaluate>
+TARGET_AVX2 static void accumulate_modulated_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 8) {
+        const __m256i lane = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8);
+        __m256i phases = _mm256_add_epi32(_mm256_set1_epi32(int32_t(phase)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(int32_t(increment))));
+        const __m256i step = _mm256_set1_epi32(int32_t(8*increment));
+        __m256 gain = _mm256_add_ps(_mm256_set1_ps(amplitude), _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(lane, _mm256_set1_epi32(1))), _mm256_set1_ps(amplitude_step)));
+        const __m256 gain_step = _mm256_set1_ps(8*amplitude_step);
+        const __m256 scale = _mm256_set1_ps(modulation_scale);
+
+        for (; f_idx + 8 <= frames; f_idx += 8) {
+            __m256i offsets = _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(modulation + f_idx), scale)), modulation_shift);
+            __m256 y = evaluate(_mm256_add_epi32(phases, offsets));
+            _mm256_storeu_ps(out + f_idx, _mm256_add_ps(_mm256_loadu_ps(out + f_idx), _mm256_mul_ps(y, gain)));
+            phases = _mm256_add_epi32(phases, step);
+            gain = _mm256_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    accumulate_modulated_scalar(out + f_idx, frames - f_idx, phase, increment, modulation + f_idx, amplitude, amplitude_step, evaluate);
+}
+
+TARGET_AVX2 static inline __m128 fold_lanes(__m256 lanes) {
+    return _mm_add_ps(_mm256_castps256_ps128(lanes), _mm256_extractf128_ps(lanes, 1));
+}
+
+// Copies run eight to a vector; a last group of up to four copies uses a four-lane vector instead, so two or three
+// copies cost no more than with SSE2
+template <typename Evaluate>
+TARGET_AVX2 static void accumulate_unison_avx2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    const uint32_t wide_groups = (copies.count + 3)/8;
+    const bool narrow_group = copies.count > 8*wide_groups;
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        __m256 wide_mid[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+        __m256 wide_side[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+        for (uint32_t group = 0; group < wide_groups; ++group) {
+            __m256i phase = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(copies.phases + 8*group));
+            const __m256i increment = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(copies.increments + 8*group));
+            const __m256 mid_gain = _mm256_loadu_ps(copies.mid_gains + 8*group);
+            const __m256 side_gain = _mm256_loadu_ps(copies.side_gains + 8*group);
+            for (uint32_t frame = 0; frame < 4; ++frame) {
+                phase = _mm256_add_epi32(phase, increment);
+                __m256 y = evaluate(phase);
+                wide_mid[frame] = _mm256_add_ps(wide_mid[frame], _mm256_mul_ps(y, mid_gain));
+                wide_side[frame] = _mm256_add_ps(wide_side[frame], _mm256_mul_ps(y, side_gain));
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(copies.phases + 8*group), phase);
+        }
+
+        __m128 mid_frames[4];
+        __m128 side_frames[4];
+        for (uint32_t frame = 0; frame < 4; ++frame) {
+            mid_frames[frame] = fold_lanes(wide_mid[frame]);
+            side_frames[frame] = fold_lanes(wide_side[frame]);
+        }
+        if (narrow_group) {
+            const uint32_t first = 8*wide_groups;
+            __m128i phase = _mm_loadu_si128(reinterpret_cast<const __m128i*>(copies.phases + first));
+            const __m128i increment = _mm_loadu_si128(reinterpret_cast<const __m128i*>(copies.increments + first));
+            const __m128 mid_gain = _mm_loadu_ps(copies.mid_gains + first);
+            const __m128 side_gain = _mm_loadu_ps(copies.side_gains + first);
+            for (uint32_t frame = 0; frame < 4; ++frame) {
+                phase = _mm_add_epi32(phase, increment);
+                __m128 y = evaluate(phase);
+                mid_frames[frame] = _mm_add_ps(mid_frames[frame], _mm_mul_ps(y, mid_gain));
+                side_frames[frame] = _mm_add_ps(side_frames[frame], _mm_mul_ps(y, side_gain));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(copies.phases + first), phase);
+        }
+        store_unison_frames(mid + f_idx, side + f_idx, mid_frames, side_frames, amplitude, amplitude_step);
+        amplitude += 4*amplitude_step;
+    }
+    accumulate_unison_scalar(mid + f_idx, side + f_idx, frames - f_idx, copies, amplitude, amplitude_step, evaluate);
+}
+
+TARGET_AVX2 static void accumulate_fast_sine_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step) {
+    accumulate_avx2(out, frames, phase, increment, amplitude, amplitude_step, Fast_Sine_Lanes_AVX2());
+}
+TARGET_AVX2 static void accumulate_wavetable_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_avx2(out, frames, phase, increment, amplitude, amplitude_step, Wavetable_Lanes_AVX2{{{levels}}});
+}
+TARGET_AVX2 static void accumulate_pulse_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_avx2(out, frames, phase, increment, amplitude, amplitude_step, Pulse_Lanes_AVX2{{{shape}}});
+}
+TARGET_AVX2 static void accumulate_additive_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_avx2(out, frames, phase, increment, amplitude, amplitude_step, Additive_Lanes_AVX2{{{partials}}});
+}
+TARGET_AVX2 static void accumulate_modulated_sine_avx2(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step) {
+    accumulate_modulated_avx2(out, frames, phase, increment, modulation, amplitude, amplitude_step, Fast_Sine_Lanes_AVX2());
+}
+TARGET_AVX2 static void accumulate_unison_fast_sine_avx2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step) {
+    accumulate_unison_avx2(mid, side, frames, copies, amplitude, amplitude_step, Fast_Sine_Lanes_AVX2());
+}
+TARGET_AVX2 static void accumulate_unison_wavetable_avx2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_unison_avx2(mid, side, frames, copies, amplitude, amplitude_step, Wavetable_Lanes_AVX2{{{levels}}});
+}
+TARGET_AVX2 static void accumulate_unison_pulse_avx2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_unison_avx2(mid, side, frames, copies, amplitude, amplitude_step, Pulse_Lanes_AVX2{{{shape}}});
+}
+TARGET_AVX2 static void accumulate_unison_additive_avx2(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_unison_avx2(mid, side, frames, copies, amplitude, amplitude_step, Additive_Lanes_AVX2{{{partials}}});
+}
+
+TARGET_AVX2 static void fill_ramp_avx2(float* out, uint32_t frames, float start, float step) {
+    const __m256 starts = _mm256_set1_ps(start);
+    const __m256 steps = _mm256_set1_ps(step);
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i eight = _mm256_set1_epi32(8);
+    uint32_t f_idx = 0;
+    for (; f_idx + 8 <= frames; f_idx += 8) {
+        _mm256_storeu_ps(out + f_idx, _mm256_add_ps(starts, _mm256_mul_ps(_mm256_cvtepi32_ps(indices), steps)));
+        indices = _mm256_add_epi32(indices, eight);
+    }
+    for (; f_idx < frames; ++f_idx) {
+        out[f_idx] = start + float(f_idx)*step;
+    }
+}
+TARGET_AVX2 static void multiply_block_avx2(float* out, const float* gains, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 8 <= frames; f_idx += 8) {
+        _mm256_storeu_ps(out + f_idx, _mm256_mul_ps(_mm256_loadu_ps(out + f_idx), _mm256_loadu_ps(gains + f_idx)));
+    }
+    for (; f_idx < frames; ++f_idx) {
+        out[f_idx] *= gains[f_idx];
+    }
+}
+TARGET_AVX2 static void mid_side_to_left_right_avx2(float* mid_left, float* side_right, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 8 <= frames; f_idx += 8) {
+        __m256 mid = _mm256_loadu_ps(mid_left + f_idx);
+        __m256 side = _mm256_loadu_ps(side_right + f_idx);
+        _mm256_storeu_ps(mid_left + f_idx, _mm256_add_ps(mid, side));
+        _mm256_storeu_ps(side_right + f_idx, _mm256_sub_ps(mid, side));
+    }
+    for (; f_idx < frames; ++f_idx) {
+        float mid = mid_left[f_idx];
+        float side = side_right[f_idx];
+        mid_left[f_idx] = mid + side;
+        side_right[f_idx] = mid - side;
+    }
+}
+
+TARGET_AVX2 static void accumulate_panned_avx2(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains) {
+    const __m256 mid_steps = _mm256_set1_ps(gains.mid_step);
+    const __m256 side_steps = _mm256_set1_ps(gains.side_step);
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    uint32_t f_idx = 0;
+    for (; f_idx + 8 <= frames; f_idx += 8) {
+        const __m256 index = _mm256_cvtepi32_ps(indices);
+        const __m256 mid_gain = _mm256_add_ps(_mm256_set1_ps(gains.mid), _mm256_mul_ps(index, mid_steps));
+        const __m256 side_gain = _mm256_add_ps(_mm256_set1_ps(gains.side), _mm256_mul_ps(index, side_steps));
+        const __m256 y_mid = _mm256_loadu_ps(voice_mid + f_idx);
+        const __m256 y_side = (voice_side != nullptr) ? _mm256_loadu_ps(voice_side + f_idx) : _mm256_setzero_ps();
+        _mm256_storeu_ps(mid + f_idx, _mm256_add_ps(_mm256_loadu_ps(mid + f_idx), _mm256_add_ps(_mm256_mul_ps(mid_gain, y_mid), _mm256_mul_ps(side_gain, y_side))));
+        _mm256_storeu_ps(side + f_idx, _mm256_add_ps(_mm256_loadu_ps(side + f_idx), _mm256_add_ps(_mm256_mul_ps(side_gain, y_mid), _mm256_mul_ps(mid_gain, y_side))));
+        indices = _mm256_add_epi32(indices, step);
+    }
+    accumulate_panned_frames(mid, side, voice_mid, voice_side, f_idx, frames, gains);
+}
+template <uint32_t line_count>
+TARGET_AVX2 static void mix_feedback_avx2(float* const* lines, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 8 <= frames; f_idx += 8) {
+        __m256 y[line_count];
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            y[l_idx] = _mm256_loadu_ps(lines[l_idx] + f_idx);
+        }
+        __m256 left = y[0];
+        __m256 right = y[1];
+        for (uint32_t l_idx = 2; l_idx < line_count; l_idx += 2) {
+            if (l_idx & 2) {
+                left = _mm256_sub_ps(left, y[l_idx]);
+                right = _mm256_sub_ps(right, y[l_idx + 1]);
+            } else {
+                left = _mm256_add_ps(left, y[l_idx]);
+                right = _mm256_add_ps(right, y[l_idx + 1]);
+            }
+        }
+        for (uint32_t stride = 1; stride < line_count; stride *= 2) {
+            for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+                if ((l_idx & stride) == 0) {
+                    const __m256 a = y[l_idx];
+                    const __m256 b = y[l_idx + stride];
+                    y[l_idx] = _mm256_add_ps(a, b);
+                    y[l_idx + stride] = _mm256_sub_ps(a, b);
+                }
+            }
+        }
+        const __m256 x_left = _mm256_loadu_ps(in_left + f_idx);
+        const __m256 x_right = _mm256_loadu_ps(in_right + f_idx);
+        for (uint32_t l_idx = 0; l_idx < line_count; l_idx += 2) {
+            _mm256_storeu_ps(lines[l_idx] + f_idx, _mm256_add_ps(y[l_idx], x_left));
+            _mm256_storeu_ps(lines[l_idx + 1] + f_idx, _mm256_add_ps(y[l_idx + 1], x_right));
+        }
+        _mm256_storeu_ps(out_left + f_idx, left);
+        _mm256_storeu_ps(out_right + f_idx, right);
+    }
+    mix_feedback_frames<line_count>(lines, f_idx, frames, in_left, in_right, out_left, out_right);
+}
+TARGET_AVX2 static void mix_feedback_lines_avx2(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    if (line_count == 16) {
+        mix_feedback_avx2<16>(lines, frames, in_left, in_right, out_left, out_right);
+    } else {
+        mix_feedback_avx2<8>(lines, frames, in_left, in_right, out_left, out_right);
+    }
+}
+
+static const Kernel_Table avx2_kernels = {
+    accumulate_fast_sine_avx2,
+    accumulate_wavetable_avx2,
+    accumulate_pulse_avx2,
+    accumulate_additive_avx2,
+    accumulate_modulated_sine_avx2,
+    accumulate_unison_fast_sine_avx2,
+    accumulate_unison_wavetable_avx2,
+    accumulate_unison_pulse_avx2,
+    accumulate_unison_additive_avx2,
+    fill_ramp_avx2,
+    multiply_block_avx2,
+    mid_side_to_left_right_avx2,
+    accumulate_panned_avx2,
+    mix_feedback_lines_avx2,
+};
+
+// AVX-512F: sixteen lanes. Only the foundation subset, so the float bit operations go through the integer forms.
+
+struct Fast_Sine_Lanes_AVX512 : Fast_Sine_Lanes_AVX2 {
+    using Fast_Sine_Lanes_AVX2::operator();
+    TARGET_AVX512 __m512 operator()(__m512i phases) const {
+        __m512 x = _mm512_mul_ps(_mm512_cvtepi32_ps(phases), _mm512_set1_ps(phase_to_cycles));
+
+        // fold x > 0.25 to 0.5 - x and x < -0.25 to -0.5 - x
+        __mmask16 above = _mm512_cmp_ps_mask(x, _mm512_set1_ps(0.25f), _CMP_GT_OQ);
+        __mmask16 below = _mm512_cmp_ps_mask(x, _mm512_set1_ps(-0.25f), _CMP_LT_OQ);
+        x = _mm512_mask_sub_ps(x, above, _mm512_set1_ps(0.5f), x);
+        x = _mm512_mask_sub_ps(x, below, _mm512_set1_ps(-0.5f), x);
+
+        __m512 x2 = _mm512_mul_ps(x, x);
+        __m512 y = _mm512_set1_ps(fast_sine_c9);
+        y = _mm512_add_ps(_mm512_mul_ps(y, x2), _mm512_set1_ps(fast_sine_c7));
+        y = _mm512_add_ps(_mm512_mul_ps(y, x2), _mm512_set1_ps(fast_sine_c5));
+        y = _mm512_add_ps(_mm512_mul_ps(y, x2), _mm512_set1_ps(fast_sine_c3));
+        y = _mm512_add_ps(_mm512_mul_ps(y, x2), _mm512_set1_ps(fast_sine_c1));
+        return _mm512_mul_ps(y, x);
+    }
+};
+
+TARGET_AVX512 static inline __m512 lookup_avx512(const float* level, __m512i phases) {
+    const uint32_t frac_bits = 32 - Wavetable::size_bits;
+    __m512i index = _mm512_srli_epi32(phases, frac_bits);
+    __m512 left = _mm512_i32gather_ps(index, level, 4);
+    __m512 right = _mm512_i32gather_ps(index, level + 1, 4);
+    __m512i frac_fixed = _mm512_and_si512(phases, _mm512_set1_epi32((1 << frac_bits) - 1));
+    __m512 frac = _mm512_mul_ps(_mm512_cvtepi32_ps(frac_fixed), _mm512_set1_ps(1.f/(1u << frac_bits)));
+    return _mm512_add_ps(left, _mm512_mul_ps(frac, _mm512_sub_ps(right, left)));
+}
+
+struct Wavetable_Lanes_AVX512 : Wavetable_Lanes_AVX2 {
+    using Wavetable_Lanes_AVX2::operator();
+    TARGET_AVX512 __m512 operator()(__m512i phases) const {
+        __m512 a = lookup_avx512(levels.level_a, phases);
+        __m512 b = lookup_avx512(levels.level_b, phases);
+        return _mm512_add_ps(a, _mm512_mul_ps(_mm512_set1_ps(levels.b_weight), _mm512_sub_ps(b, a)));
+    }
+};
+
+struct Pulse_Lanes_AVX512 : Pulse_Lanes_AVX2 {
+    using Pulse_Lanes_AVX2::operator();
+    TARGET_AVX512 __m512 operator()(__m512i phases) const {
+        __m512i ramp_phases = _mm512_add_epi32(phases, _mm512_set1_epi32(int32_t(half_cycle)));
+        __m512i duty_phases = _mm512_sub_epi32(ramp_phases, _mm512_set1_epi32(int32_t(shape.duty_phase)));
+        __m512 a = _mm512_sub_ps(lookup_avx512(shape.saw.level_a, duty_phases), lookup_avx512(shape.saw.level_a, ramp_phases));
+        __m512 b = _mm512_sub_ps(lookup_avx512(shape.saw.level_b, duty_phases), lookup_avx512(shape.saw.level_b, ramp_phases));
+        __m512 y = _mm512_add_ps(a, _mm512_mul_ps(_mm512_set1_ps(shape.saw.b_weight), _mm512_sub_ps(b, a)));
+        return _mm512_add_ps(y, _mm512_set1_ps(shape.dc_offset));
+    }
+};
+
+struct Additive_Lanes_AVX512 : Additive_Lanes_AVX2 {
+    using Additive_Lanes_AVX2::operator();
+    TARGET_AVX512 __m512 operator()(__m512i phases) const {
+        const Fast_Sine_Lanes_AVX512 sine;
+        const __m512 step_sine = sine(_mm512_slli_epi32(phases, additive_chain_bits - 1));
+        const __m512 step = _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(-4.f), step_sine), step_sine);
+        __m512i lowest = _mm512_sub_epi32(phases, _mm512_slli_epi32(phases, additive_chain_bits));
+        const __m512i restart_step = _mm512_slli_epi32(phases, additive_restart_bits);
+        __m512 sum = _mm512_setzero_ps();
+        for (uint32_t first = 0; first < partials.count; first += additive_restart_partials) {
+            __m512 sines[additive_chains];
+            __m512 differences[additive_chains];
+            __m512i harmonic_phases = lowest;
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                differences[c_idx] = sine(harmonic_phases);
+                harmonic_phases = _mm512_add_epi32(harmonic_phases, phases);
+            }
+            for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                sines[c_idx] = sine(harmonic_phases);
+                differences[c_idx] = _mm512_sub_ps(sines[c_idx], differences[c_idx]);
+                harmonic_phases = _mm512_add_epi32(harmonic_phases, phases);
+            }
+            lowest = _mm512_add_epi32(lowest, restart_step);
+
+            const uint32_t last = (partials.count < first + additive_restart_partials) ? partials.count : first + additive_restart_partials;
+            for (uint32_t p_idx = first; p_idx < last; p_idx += additive_chains) {
+                __m512 terms[additive_chains];
+                for (uint32_t c_idx = 0; c_idx < additive_chains; ++c_idx) {
+                    terms[c_idx] = _mm512_mul_ps(_mm512_set1_ps(partials.amplitudes[p_idx + c_idx]), sines[c_idx]);
+                    differences[c_idx] = _mm512_add_ps(differences[c_idx], _mm512_mul_ps(step, sines[c_idx]));
+                    sines[c_idx] = _mm512_add_ps(sines[c_idx], differences[c_idx]);
+                }
+                sum = _mm512_add_ps(sum, _mm512_add_ps(_mm512_add_ps(terms[0], terms[1]), _mm512_add_ps(terms[2], terms[3])));
+            }
+        }
+        return sum;
+    }
+};
+
+template <typename Evaluate>
+TARGET_AVX512 static void accumulate_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 16) {
+        const __m512i lane = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+        __m512i phases = _mm512_add_epi32(_mm512_set1_epi32(int32_t(phase)), _mm512_mullo_epi32(lane, _mm512_set1_epi32(int32_t(increment))));
+        const __m512i step = _mm512_set1_epi32(int32_t(16*increment));
+        __m512 gain = _mm512_add_ps(_mm512_set1_ps(amplitude), _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(lane, _mm512_set1_epi32(1))), _mm512_set1_ps(amplitude_step)));
+        const __m512 gain_step = _mm512_set1_ps(16*amplitude_step);
+
+        for (; f_idx + 16 <= frames; f_idx += 16) {
+            __m512 y = evaluate(phases);
+            _mm512_storeu_ps(out + f_idx, _mm512_add_ps(_mm512_loadu_ps(out + f_idx), _mm512_mul_ps(y, gain)));
+            phases = _mm512_add_epi32(phases, step);
+            gain = _mm512_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    // up to 15 frames left; the AVX2 kernel takes eight of them
+    accumulate_avx2(out + f_idx, frames - f_idx, phase, increment, amplitude, amplitude_step, evaluate);
+}
+
+template <typename Evaluate>
+TARGET_AVX512 static void accumulate_modulated_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    uint32_t f_idx = 0;
+    if (frames >= 16) {
+        const __m512i lane = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+        __m512i phases = _mm512_add_epi32(_mm512_set1_epi32(int32_t(phase)), _mm512_mullo_epi32(lane, _mm512_set1_epi32(int32_t(increment))));
+        const __m512i step = _mm512_set1_epi32(int32_t(16*increment));
+        __m512 gain = _mm512_add_ps(_mm512_set1_ps(amplitude), _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(lane, _mm512_set1_epi32(1))), _mm512_set1_ps(amplitude_step)));
+        const __m512 gain_step = _mm512_set1_ps(16*amplitude_step);
+        const __m512 scale = _mm512_set1_ps(modulation_scale);
+
+        for (; f_idx + 16 <= frames; f_idx += 16) {
+            __m512i offsets = _mm512_slli_epi32(_mm512_cvttps_epi32(_mm512_mul_ps(_mm512_loadu_ps(modulation + f_idx), scale)), modulation_shift);
+            __m512 y = evaluate(_mm512_add_epi32(phases, offsets));
+            _mm512_storeu_ps(out + f_idx, _mm512_add_ps(_mm512_loadu_ps(out + f_idx), _mm512_mul_ps(y, gain)));
+            phases = _mm512_add_epi32(phases, step);
+            gain = _mm512_add_ps(gain, gain_step);
+        }
+        phase += f_idx*increment;
+        amplitude += f_idx*amplitude_step;
+    }
+    accumulate_modulated_avx2(out + f_idx, frames - f_idx, phase, increment, modulation + f_idx, amplitude, amplitude_step, evaluate);
+}
+
+TARGET_AVX512 static inline __m128 fold_lanes(__m512 lanes) {
+    __m128 low = _mm_add_ps(_mm512_extractf32x4_ps(lanes, 0), _mm512_extractf32x4_ps(lanes, 1));
+    __m128 high = _mm_add_ps(_mm512_extractf32x4_ps(lanes, 2), _mm512_extractf32x4_ps(lanes, 3));
+    return _mm_add_ps(low, high);
+}
+
+// All sixteen copies fit one vector. Up to eight copies are left to the AVX2 kernel, which wastes fewer lanes.
+template <typename Evaluate>
+TARGET_AVX512 static void accumulate_unison_avx512(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step, const Evaluate& evaluate) {
+    if (copies.count <= 8) {
+        accumulate_unison_avx2(mid, side, frames, copies, amplitude, amplitude_step, evaluate);
+        return;
+    }
+
+    __m512i phase = _mm512_loadu_si512(copies.phases);
+    const __m512i increment = _mm512_loadu_si512(copies.increments);
+    const __m512 mid_gain = _mm512_loadu_ps(copies.mid_gains);
+    const __m512 side_gain = _mm512_loadu_ps(copies.side_gains);
+    uint32_t f_idx = 0;
+    for (; f_idx + 4 <= frames; f_idx += 4) {
+        __m128 mid_frames[4];
+        __m128 side_frames[4];
+        for (uint32_t frame = 0; frame < 4; ++frame) {
+            phase = _mm512_add_epi32(phase, increment);
+            __m512 y = evaluate(phase);
+            mid_frames[frame] = fold_lanes(_mm512_mul_ps(y, mid_gain));
+            side_frames[frame] = fold_lanes(_mm512_mul_ps(y, side_gain));
+        }
+        store_unison_frames(mid + f_idx, side + f_idx, mid_frames, side_frames, amplitude, amplitude_step);
+        amplitude += 4*amplitude_step;
+    }
+    _mm512_storeu_si512(copies.phases, phase);
+    accumulate_unison_scalar(mid + f_idx, side + f_idx, frames - f_idx, copies, amplitude, amplitude_step, evaluate);
+}
+
+TARGET_AVX512 static void accumulate_fast_sine_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step) {
+    accumulate_avx512(out, frames, phase, increment, amplitude, amplitude_step, Fast_Sine_Lanes_AVX512());
+}
+TARGET_AVX512 static void accumulate_wavetable_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_avx512(out, frames, phase, increment, amplitude, amplitude_step, Wavetable_Lanes_AVX512{{{{levels}}}});
+}
+TARGET_AVX512 static void accumulate_pulse_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_avx512(out, frames, phase, increment, amplitude, amplitude_step, Pulse_Lanes_AVX512{{{{shape}}}});
+}
+TARGET_AVX512 static void accumulate_additive_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_avx512(out, frames, phase, increment, amplitude, amplitude_step, Additive_Lanes_AVX512{{{{partials}}}});
+}
+TARGET_AVX512 static void accumulate_modulated_sine_avx512(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, const float* modulation, float amplitude, float amplitude_step) {
+    accumulate_modulated_avx512(out, frames, phase, increment, modulation, amplitude, amplitude_step, Fast_Sine_Lanes_AVX512());
+}
+TARGET_AVX512 static void accumulate_unison_fast_sine_avx512(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, float amplitude, float amplitude_step) {
+    accumulate_unison_avx512(mid, side, frames, copies, amplitude, amplitude_step, Fast_Sine_Lanes_AVX512());
+}
+TARGET_AVX512 static void accumulate_unison_wavetable_avx512(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Wavetable_Levels& levels, float amplitude, float amplitude_step) {
+    accumulate_unison_avx512(mid, side, frames, copies, amplitude, amplitude_step, Wavetable_Lanes_AVX512{{{{levels}}}});
+}
+TARGET_AVX512 static void accumulate_unison_pulse_avx512(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Pulse_Shape& shape, float amplitude, float amplitude_step) {
+    accumulate_unison_avx512(mid, side, frames, copies, amplitude, amplitude_step, Pulse_Lanes_AVX512{{{{shape}}}});
+}
+TARGET_AVX512 static void accumulate_unison_additive_avx512(float* mid, float* side, uint32_t frames, const Unison_Copies& copies, const Additive_Partials& partials, float amplitude, float amplitude_step) {
+    accumulate_unison_avx512(mid, side, frames, copies, amplitude, amplitude_step, Additive_Lanes_AVX512{{{{partials}}}});
+}
+
+TARGET_AVX512 static void fill_ramp_avx512(float* out, uint32_t frames, float start, float step) {
+    const __m512 starts = _mm512_set1_ps(start);
+    const __m512 steps = _mm512_set1_ps(step);
+    __m512i indices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i sixteen = _mm512_set1_epi32(16);
+    uint32_t f_idx = 0;
+    for (; f_idx + 16 <= frames; f_idx += 16) {
+        _mm512_storeu_ps(out + f_idx, _mm512_add_ps(starts, _mm512_mul_ps(_mm512_cvtepi32_ps(indices), steps)));
+        indices = _mm512_add_epi32(indices, sixteen);
+    }
+    for (; f_idx < frames; ++f_idx) {
+        out[f_idx] = start + float(f_idx)*step;
+    }
+}
+TARGET_AVX512 static void multiply_block_avx512(float* out, const float* gains, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 16 <= frames; f_idx += 16) {
+        _mm512_storeu_ps(out + f_idx, _mm512_mul_ps(_mm512_loadu_ps(out + f_idx), _mm512_loadu_ps(gains + f_idx)));
+    }
+    multiply_block_avx2(out + f_idx, gains + f_idx, frames - f_idx);
+}
+TARGET_AVX512 static void mid_side_to_left_right_avx512(float* mid_left, float* side_right, uint32_t frames) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 16 <= frames; f_idx += 16) {
+        __m512 mid = _mm512_loadu_ps(mid_left + f_idx);
+        __m512 side = _mm512_loadu_ps(side_right + f_idx);
+        _mm512_storeu_ps(mid_left + f_idx, _mm512_add_ps(mid, side));
+        _mm512_storeu_ps(side_right + f_idx, _mm512_sub_ps(mid, side));
+    }
+    mid_side_to_left_right_avx2(mid_left + f_idx, side_right + f_idx, frames - f_idx);
+}
+
+TARGET_AVX512 static void accumulate_panned_avx512(float* mid, float* side, const float* voice_mid, const float* voice_side, uint32_t frames, const Pan_Gains& gains) {
+    const __m512 mid_steps = _mm512_set1_ps(gains.mid_step);
+    const __m512 side_steps = _mm512_set1_ps(gains.side_step);
+    __m512i indices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i step = _mm512_set1_epi32(16);
+    uint32_t f_idx = 0;
+    for (; f_idx + 16 <= frames; f_idx += 16) {
+        const __m512 index = _mm512_cvtepi32_ps(indices);
+        const __m512 mid_gain = _mm512_add_ps(_mm512_set1_ps(gains.mid), _mm512_mul_ps(index, mid_steps));
+        const __m512 side_gain = _mm512_add_ps(_mm512_set1_ps(gains.side), _mm512_mul_ps(index, side_steps));
+        const __m512 y_mid = _mm512_loadu_ps(voice_mid + f_idx);
+        const __m512 y_side = (voice_side != nullptr) ? _mm512_loadu_ps(voice_side + f_idx) : _mm512_setzero_ps();
+        _mm512_storeu_ps(mid + f_idx, _mm512_add_ps(_mm512_loadu_ps(mid + f_idx), _mm512_add_ps(_mm512_mul_ps(mid_gain, y_mid), _mm512_mul_ps(side_gain, y_side))));
+        _mm512_storeu_ps(side + f_idx, _mm512_add_ps(_mm512_loadu_ps(side + f_idx), _mm512_add_ps(_mm512_mul_ps(side_gain, y_mid), _mm512_mul_ps(mid_gain, y_side))));
+        indices = _mm512_add_epi32(indices, step);
+    }
+    accumulate_panned_frames(mid, side, voice_mid, voice_side, f_idx, frames, gains);
+}
+template <uint32_t line_count>
+TARGET_AVX512 static void mix_feedback_avx512(float* const* lines, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    uint32_t f_idx = 0;
+    for (; f_idx + 16 <= frames; f_idx += 16) {
+        __m512 y[line_count];
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            y[l_idx] = _mm512_loadu_ps(lines[l_idx] + f_idx);
+        }
+        __m512 left = y[0];
+        __m512 right = y[1];
+        for (uint32_t l_idx = 2; l_idx < line_count; l_idx += 2) {
+            if (l_idx & 2) {
+                left = _mm512_sub_ps(left, y[l_idx]);
+                right = _mm512_sub_ps(right, y[l_idx + 1]);
+            } else {
+                left = _mm512_add_ps(left, y[l_idx]);
+                right = _mm512_add_ps(right, y[l_idx + 1]);
+            }
+        }
+        for (uint32_t stride = 1; stride < line_count; stride *= 2) {
+            for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+                if ((l_idx & stride) == 0) {
+                    const __m512 a = y[l_idx];
+                    const __m512 b = y[l_idx + stride];
+                    y[l_idx] = _mm512_add_ps(a, b);
+                    y[l_idx + stride] = _mm512_sub_ps(a, b);
+                }
+            }
+        }
+        const __m512 x_left = _mm512_loadu_ps(in_left + f_idx);
+        const __m512 x_right = _mm512_loadu_ps(in_right + f_idx);
+        for (uint32_t l_idx = 0; l_idx < line_count; l_idx += 2) {
+            _mm512_storeu_ps(lines[l_idx] + f_idx, _mm512_add_ps(y[l_idx], x_left));
+            _mm512_storeu_ps(lines[l_idx + 1] + f_idx, _mm512_add_ps(y[l_idx + 1], x_right));
+        }
+        _mm512_storeu_ps(out_left + f_idx, left);
+        _mm512_storeu_ps(out_right + f_idx, right);
+    }
+    if (f_idx < frames) {
+        float* rest[line_count];
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            rest[l_idx] = lines[l_idx] + f_idx;
+        }
+        mix_feedback_avx2<line_count>(rest, frames - f_idx, in_left + f_idx, in_right + f_idx, out_left + f_idx, out_right + f_idx);
+    }
+}
+TARGET_AVX512 static void mix_feedback_lines_avx512(float* const* lines, uint32_t line_count, uint32_t frames, const float* in_left, const float* in_right, float* out_left, float* out_right) {
+    if (line_count == 16) {
+        mix_feedback_avx512<16>(lines, frames, in_left, in_right, out_left, out_right);
+    } else {
+        mix_feedback_avx512<8>(lines, frames, in_left, in_right, out_left, out_right);
+    }
+}
+
+static const Kernel_Table avx512_kernels = {
+    accumulate_fast_sine_avx512,
+    accumulate_wavetable_avx512,
+    accumulate_pulse_avx512,
+    accumulate_additive_avx512,
+    accumulate_modulated_sine_avx512,
+    accumulate_unison_fast_sine_avx512,
+    accumulate_unison_wavetable_avx512,
+    accumulate_unison_pulse_avx512,
+    accumulate_unison_additive_avx512,
+    fill_ramp_avx512,
+    multiply_block_avx512,
+    mid_side_to_left_right_avx512,
+    accumulate_panned_avx512,
+    mix_feedback_lines_avx512,
+};
+
+const Kernel_Table* get_avx2_kernels() {
+    return &avx2_kernels;
+}
+const Kernel_Table* get_avx512_kernels() {
+    return &avx512_kernels;
+}
+#else
+const Kernel_Table* get_avx2_kernels() {
+    return nullptr;
+}
+const Kernel_Table* get_avx512_kernels() {
+    return nullptr;
+}
+#endif
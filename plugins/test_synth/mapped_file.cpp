@@ -0,0 +1,112 @@
+/*
+mapped_file.cpp
+Read-only memory-mapped files for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Mapped_File::~Mapped_File() {
+    if (data == nullptr) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+#endif
+}
+
+bool Mapped_File::open(const char* path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return false;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping open
+    if (view == nullptr) {
+        return false;
+    }
+    data = static_cast<const uint8_t*>(view);
+    size = size_t(file_size.QuadPart);
+    return true;
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd); // the mapping keeps the file open
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<const uint8_t*>(view);
+    size = size_t(info.st_size);
+    return true;
+#endif
+}
+
+#if !defined(_WIN32)
+static const size_t page_size = size_t(sysconf(_SC_PAGESIZE));
+#endif
+
+void Mapped_File::will_need(size_t offset, size_t bytes) const {
+#if !defined(_WIN32)
+    // every page the range touches
+    const size_t start = offset - offset % page_size;
+    const size_t end = std::min(offset + bytes, size);
+    if (start < end) {
+        madvise(const_cast<uint8_t*>(data) + start, end - start, MADV_WILLNEED);
+    }
+#endif
+}
+
+void Mapped_File::dont_need(size_t offset, size_t bytes) const {
+#if !defined(_WIN32)
+    // only pages entirely inside the range, so the neighbouring frames stay mapped
+    const size_t start = (offset + page_size - 1)/page_size*page_size;
+    const size_t end = std::min(offset + bytes, size)/page_size*page_size;
+    if (start < end) {
+        madvise(const_cast<uint8_t*>(data) + start, end - start, MADV_DONTNEED);
+    }
+#endif
+}
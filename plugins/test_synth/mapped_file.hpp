@@ -0,0 +1,46 @@
+/*
+mapped_file.hpp
+Read-only memory-mapped files for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class Mapped_File {
+    // A whole file mapped read-only. Pages are read from disk when first touched and the OS can drop them again at any
+    // time, so a mapping costs address space rather than memory.
+    public:
+    Mapped_File() {}
+    ~Mapped_File();
+    Mapped_File(const Mapped_File&) = delete;
+    Mapped_File& operator=(const Mapped_File&) = delete;
+
+    bool open(const char* path); // false if the file can't be read or is empty
+    const uint8_t* get_data() const { return data; }
+    size_t get_size() const { return size; }
+
+    // Hints, rounded to whole pages: start reading a range from disk, or give back the pages of a range already copied out
+    void will_need(size_t offset, size_t bytes) const;
+    void dont_need(size_t offset, size_t bytes) const;
+
+    protected:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
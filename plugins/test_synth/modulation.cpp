@@ -0,0 +1,158 @@
+/*
+modulation.cpp
+Modulation matrix and LFOs for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "modulation.hpp"
+#include "kernels.hpp"
+
+#include <cmath>
+
+LFO::LFO() {
+    set_parameters(5, LFO_Shape::sine, 48000);
+    phase = 0;
+    block_start_frame = 0;
+}
+
+void LFO::set_parameters(float rate_hz, LFO_Shape shape_in, double sample_rate) {
+    increment = phase_increment_from_frequency(rate_hz, 1/sample_rate);
+    shape = shape_in;
+}
+
+float LFO::value_at(uint64_t frame) const {
+    // voices read up to a control period past the end of the block, which is still exact: the product wraps like the phase
+    const uint32_t phase_at_frame = phase + uint32_t(frame - block_start_frame)*increment;
+    switch (shape) {
+    case LFO_Shape::triangle: {
+        // every shape starts at 0 and rises, like the sine
+        const int32_t folded = int32_t(phase_at_frame + 0x40000000u);
+        return std::abs(float(folded))*(2.f/0x80000000u) - 1;
+    }
+    case LFO_Shape::saw:
+        return int32_t(phase_at_frame)*(1.f/0x80000000u);
+    case LFO_Shape::square:
+        return (phase_at_frame < 0x80000000u) ? 1.f : -1.f;
+    case LFO_Shape::sine:
+    default:
+        return fast_sine(phase_at_frame);
+    }
+}
+
+Modulation_Matrix::Modulation_Matrix() {
+    for (Mod_Slot& slot : slots) {
+        slot = Mod_Slot{Mod_Source::none, Mod_Destination::none, 0};
+    }
+    mod_wheel = 0;
+    update_active();
+}
+
+void Modulation_Matrix::set_slot(uint32_t slot, Mod_Source source, Mod_Destination destination, float amount) {
+    if (slot >= slot_count) {
+        return;
+    }
+    slots[slot] = Mod_Slot{source, destination, amount};
+    update_active();
+}
+
+void Modulation_Matrix::set_lfo(uint32_t lfo, float rate_hz, LFO_Shape shape, double sample_rate) {
+    if (lfo >= lfo_count) {
+        return;
+    }
+    lfos[lfo].set_parameters(rate_hz, shape, sample_rate);
+}
+
+void Modulation_Matrix::reset_lfos() {
+    for (LFO& lfo : lfos) {
+        lfo.reset();
+    }
+}
+
+void Modulation_Matrix::start_block(uint64_t frame) {
+    for (LFO& lfo : lfos) {
+        lfo.start_block(frame);
+    }
+}
+
+void Modulation_Matrix::advance_lfos(uint32_t frames) {
+    for (LFO& lfo : lfos) {
+        lfo.advance(frames);
+    }
+}
+
+void Modulation_Matrix::update_active() {
+    routed_count = 0;
+    uses_lfo[0] = false;
+    uses_lfo[1] = false;
+    for (const Mod_Slot& slot : slots) {
+        if (slot.source == Mod_Source::none || slot.source >= Mod_Source::count || slot.amount == 0) {
+            continue;
+        }
+        Mod_Targets weights = {0, 0, 0, 0};
+        switch (slot.destination) {
+        case Mod_Destination::pitch:
+            weights.pitch_st = slot.amount*pitch_range_st;
+            break;
+        case Mod_Destination::amplitude:
+            weights.amplitude = slot.amount;
+            break;
+        case Mod_Destination::pulse_width:
+            weights.duty_offset = slot.amount*0.5f;
+            break;
+        case Mod_Destination::pan:
+            weights.pan = slot.amount;
+            break;
+        default:
+            continue;
+        }
+        routed[routed_count++] = Routed_Slot{slot.source, weights};
+        uses_lfo[0] = uses_lfo[0] || slot.source == Mod_Source::lfo_1;
+        uses_lfo[1] = uses_lfo[1] || slot.source == Mod_Source::lfo_2;
+    }
+    active = routed_count > 0;
+}
+
+bool Modulation_Matrix::is_routed(Mod_Destination destination) const {
+    for (const Mod_Slot& slot : slots) {
+        if (slot.destination == destination && slot.source != Mod_Source::none && slot.source < Mod_Source::count && slot.amount != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Mod_Targets Modulation_Matrix::evaluate(const Voice_Pool& voices, uint32_t voice, uint64_t frame, float envelope_level) const {
+    float sources[uint32_t(Mod_Source::count)];
+    sources[uint32_t(Mod_Source::none)] = 0;
+    sources[uint32_t(Mod_Source::lfo_1)] = uses_lfo[0] ? lfos[0].value_at(frame) : 0;
+    sources[uint32_t(Mod_Source::lfo_2)] = uses_lfo[1] ? lfos[1].value_at(frame) : 0;
+    sources[uint32_t(Mod_Source::envelope)] = envelope_level;
+    sources[uint32_t(Mod_Source::velocity)] = voices.velocity[voice];
+    sources[uint32_t(Mod_Source::pressure)] = voices.pressure[voice];
+    sources[uint32_t(Mod_Source::timbre)] = voices.timbre[voice];
+    sources[uint32_t(Mod_Source::mod_wheel)] = mod_wheel;
+
+    Mod_Targets targets = {0, 0, 0, 0};
+    for (uint32_t s_idx = 0; s_idx < routed_count; ++s_idx) {
+        const float value = sources[uint32_t(routed[s_idx].source)];
+        targets.pitch_st += routed[s_idx].weights.pitch_st*value;
+        targets.amplitude += routed[s_idx].weights.amplitude*value;
+        targets.duty_offset += routed[s_idx].weights.duty_offset*value;
+        targets.pan += routed[s_idx].weights.pan*value;
+    }
+    return targets;
+}
@@ -0,0 +1,130 @@
+/*
+modulation.hpp
+Modulation matrix and LFOs for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "voices.hpp"
+
+enum class Mod_Source : uint8_t {
+    none,
+    lfo_1,     // -1 to 1
+    lfo_2,
+    envelope,  // the voice's amplitude envelope, 0 to 1
+    velocity,  // 0 to 1
+    pressure,  // 0 to 1, channel pressure or polyphonic aftertouch
+    timbre,    // 0 to 1, CC74
+    mod_wheel, // 0 to 1, CC1 on any channel
+    count,
+};
+
+enum class Mod_Destination : uint8_t {
+    none,
+    pitch,       // amount 1 is pitch_range_st
+    amplitude,   // amount 1 doubles the gain at full source, -1 silences it
+    pulse_width, // amount 1 moves the duty cycle by half a cycle, clamped to stay audible
+    pan,         // amount 1 moves a centred voice all the way right; only heard while voices are panned
+    count,
+};
+
+enum class LFO_Shape : uint8_t {
+    sine,
+    triangle,
+    saw,
+    square,
+    count,
+};
+
+class LFO {
+    // Free-running and shared by every voice. It accumulates its phase a block at a time, so a rate change carries on
+    // from the current phase rather than jumping. Within a block the phase is a function of the frame alone, so any
+    // voice can read the LFO at any frame, in any order and from any thread, and the result doesn't depend on how the
+    // block is split.
+    public:
+    LFO();
+    void set_parameters(float rate_hz, LFO_Shape shape_in, double sample_rate);
+    void reset() { phase = 0; }
+    void start_block(uint64_t frame) { block_start_frame = frame; }
+    void advance(uint32_t frames) { phase += frames*increment; } // wraps like the phase itself
+    float value_at(uint64_t frame) const;
+
+    protected:
+    uint32_t phase;              // fixed point (see kernels.hpp), at block_start_frame
+    uint64_t block_start_frame;
+    uint32_t increment;          // phase per frame
+    LFO_Shape shape;
+};
+
+struct Mod_Slot {
+    Mod_Source source;
+    Mod_Destination destination;
+    float amount; // -1 to 1
+};
+
+struct Mod_Targets {
+    // Summed over the slots; zero with nothing routed
+    float pitch_st;
+    float amplitude;
+    float duty_offset;
+    float pan;
+};
+
+class Modulation_Matrix {
+    // Routes sources to destinations through a fixed number of slots. Voices evaluate it once per envelope control
+    // period (see Signal_Generator), never per frame. Only change it between blocks.
+    public:
+    static const uint32_t slot_count = 4;
+    static const uint32_t lfo_count = 2;
+    static constexpr float pitch_range_st = 12;
+
+    Modulation_Matrix();
+
+    void set_slot(uint32_t slot, Mod_Source source, Mod_Destination destination, float amount);
+    void set_lfo(uint32_t lfo, float rate_hz, LFO_Shape shape, double sample_rate);
+    // The LFOs run at the internal rate: reset them in activate(), start each block at its first frame, and advance
+    // them by the block's length at the end of it. Rates and the oversampling factor only change in between.
+    void reset_lfos();
+    void start_block(uint64_t frame);
+    void advance_lfos(uint32_t frames);
+    void set_mod_wheel(float value) { mod_wheel = value; }
+
+    bool is_active() const { return active; } // anything routed at all
+    bool is_routed(Mod_Destination destination) const; // anything routed to `destination`
+    // Sum the slots for a voice at `frame`, with its envelope at `envelope_level`
+    Mod_Targets evaluate(const Voice_Pool& voices, uint32_t voice, uint64_t frame, float envelope_level) const;
+
+    protected:
+    void update_active();
+
+    Mod_Slot slots[slot_count];
+    LFO lfos[lfo_count];
+    float mod_wheel;
+    bool active;
+
+    struct Routed_Slot {
+        Mod_Source source;
+        Mod_Targets weights; // what a source value of 1 adds to each target, zero for the other destinations
+    };
+    // The routed slots, packed to the front, so evaluate() only reads the sources it needs and each LFO at most once
+    Routed_Slot routed[slot_count];
+    uint32_t routed_count;
+    bool uses_lfo[lfo_count];
+};
@@ -0,0 +1,142 @@
+/*
+mpe.cpp
+MIDI Polyphonic Expression zones for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "mpe.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const uint8_t lower_manager = 0;
+static const uint8_t upper_manager = 15;
+static const uint8_t max_members = 15;  // a zone on its own can use every other channel
+static const uint8_t no_parameter = 0x7f;
+
+MPE_Zones::MPE_Zones() {
+    set_layout(MPE_Layout::off);
+    reset_expression();
+}
+
+void MPE_Zones::set_layout(MPE_Layout layout_in) {
+    layout = layout_in;
+    switch (layout) {
+    case MPE_Layout::lower:
+        lower_members = max_members;
+        upper_members = 0;
+        break;
+    case MPE_Layout::upper:
+        lower_members = 0;
+        upper_members = max_members;
+        break;
+    case MPE_Layout::both:
+        lower_members = 7;
+        upper_members = 7;
+        break;
+    case MPE_Layout::off:
+    default:
+        lower_members = 0;
+        upper_members = 0;
+        break;
+    }
+    lower_bend_range_st = default_member_bend_range_st;
+    upper_bend_range_st = default_member_bend_range_st;
+    for (uint8_t c_idx = 0; c_idx < channels; ++c_idx) {
+        rpn_msb[c_idx] = no_parameter;
+        rpn_lsb[c_idx] = no_parameter;
+    }
+}
+
+void MPE_Zones::reset_expression() {
+    for (Channel_Expression& channel : expression) {
+        channel.bend = 1;
+        channel.pressure = 0;
+        channel.timbre = 64/127.f;
+    }
+}
+
+bool MPE_Zones::is_member(uint8_t channel) const {
+    return (channel >= 1 && channel <= lower_members) || (channel < upper_manager && channel >= upper_manager - upper_members);
+}
+
+bool MPE_Zones::control_change(uint8_t channel, uint8_t controller, uint8_t value) {
+    channel &= 0x0f;
+    switch (controller) {
+    case 101: // RPN MSB
+        rpn_msb[channel] = value;
+        return false;
+    case 100: // RPN LSB
+        rpn_lsb[channel] = value;
+        return false;
+    case 99:  // NRPN MSB and LSB, which deselect any RPN
+    case 98:
+        rpn_msb[channel] = no_parameter;
+        rpn_lsb[channel] = no_parameter;
+        return false;
+    case 6:   // data entry MSB
+        break;
+    default:
+        return false;
+    }
+    if (rpn_msb[channel] != 0) {
+        return false;
+    }
+
+    if (rpn_lsb[channel] == 6) {
+        // MPE Configuration Message
+        if (channel == lower_manager && (layout == MPE_Layout::lower || layout == MPE_Layout::both)) {
+            return configure_zone(channel, value);
+        }
+        if (channel == upper_manager && (layout == MPE_Layout::upper || layout == MPE_Layout::both)) {
+            return configure_zone(channel, value);
+        }
+    } else if (rpn_lsb[channel] == 0 && is_member(channel)) {
+        // pitch bend sensitivity, in semitones, sent on any member channel applies to the whole zone
+        if (channel <= lower_members) {
+            lower_bend_range_st = value;
+        } else {
+            upper_bend_range_st = value;
+        }
+    }
+    return false;
+}
+
+bool MPE_Zones::configure_zone(uint8_t manager_channel, uint8_t member_count) {
+    member_count = std::min(member_count, max_members);
+    // a zone that grows into the other one shrinks it; the 14 channels between the managers are all there is to share
+    const uint8_t room = (member_count < max_members - 1) ? max_members - 1 - member_count : 0;
+    if (manager_channel == lower_manager) {
+        lower_members = member_count;
+        upper_members = std::min(upper_members, room);
+        lower_bend_range_st = default_member_bend_range_st;
+    } else {
+        upper_members = member_count;
+        lower_members = std::min(lower_members, room);
+        upper_bend_range_st = default_member_bend_range_st;
+    }
+    return true;
+}
+
+float MPE_Zones::member_pitch_bend(uint8_t channel, uint16_t value) {
+    channel &= 0x0f;
+    const float range_st = (channel <= lower_members) ? lower_bend_range_st : upper_bend_range_st;
+    // once per message, so the voices only ever multiply by the ratio
+    const float bend = (int32_t(value & 0x3fff) - 0x2000)/float(0x2000);
+    expression[channel].bend = std::exp2(bend*range_st/12);
+    return expression[channel].bend;
+}
@@ -0,0 +1,77 @@
+/*
+mpe.hpp
+MIDI Polyphonic Expression zones for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+enum class MPE_Layout : uint8_t {
+    off,   // plain MIDI: every channel bends all voices
+    lower, // manager channel 1, members from channel 2 up
+    upper, // manager channel 16, members from channel 15 down
+    both,  // both zones, sharing the 14 channels in between
+    count,
+};
+
+struct Channel_Expression {
+    // the last expression received on a channel, which its next note starts with
+    float bend;     // frequency ratio; only used on member channels, other channels bend every voice
+    float pressure; // 0 to 1, from channel pressure
+    float timbre;   // 0 to 1, from CC74
+};
+
+class MPE_Zones {
+    // Tracks which channels are members of an MPE zone. Each note on a member channel has the channel to itself,
+    // so the channel's pitch bend, pressure and timbre only reach that note's voice. Manager channels and channels
+    // outside the zones behave as in plain MIDI.
+    // The layout parameter picks the zones; MPE Configuration Messages (RPN 6) on a manager channel then resize them,
+    // and RPN 0 on a member channel sets the zone's member pitch bend range. Messages for a zone the layout
+    // doesn't include are ignored, so stray RPNs don't turn MPE on for a plain MIDI controller.
+    public:
+    static const uint8_t channels = 16;
+    static const uint8_t default_member_bend_range_st = 48;
+
+    MPE_Zones();
+
+    void set_layout(MPE_Layout layout_in); // resets the zone sizes and bend ranges to their defaults
+    MPE_Layout get_layout() const { return layout; }
+    void reset_expression();                // every channel back to no bend, no pressure and centred timbre
+
+    bool is_member(uint8_t channel) const;
+
+    // Feed every control change. Returns true when the zones changed, after which held notes may be on channels
+    // that no longer belong to them, so the caller should release them.
+    bool control_change(uint8_t channel, uint8_t controller, uint8_t value);
+    // Store a member channel's 14-bit pitch bend and return it as a frequency ratio
+    float member_pitch_bend(uint8_t channel, uint16_t value);
+
+    Channel_Expression expression[channels];
+
+    protected:
+    bool configure_zone(uint8_t manager_channel, uint8_t member_count);
+
+    MPE_Layout layout;
+    uint8_t lower_members; // channels 1 to lower_members (counting from 0) belong to the lower zone
+    uint8_t upper_members; // channels 14 down to 15 - upper_members belong to the upper zone
+    float lower_bend_range_st;
+    float upper_bend_range_st;
+    uint8_t rpn_msb[channels]; // registered parameter selected by CC101/CC100, 0x7f when none is
+    uint8_t rpn_lsb[channels];
+};
@@ -19,67 +19,435 @@ PERFORMANCE OF THIS SOFTWARE.
 */
 
 #include "oscillators.hpp"
+#include <algorithm>
+#include <cmath>
 
-Note::Note(uint8_t note_number_in, uint8_t velocity_in, uint32_t frames_until_press) {
-    note_number = note_number_in;
-    velocity = velocity_in;
-
-    frequency = get_frequency_from_note_number(note_number);
-    phase = 0;
-    frames_since_pressed = -frames_until_press;
+Oscillator::Oscillator(float phase_shift, float duty_cycle_in) {
+    phase_offset = phase_shift;
+    duty_cycle = duty_cycle_in;
 }
 
-Note::Note() {
-    // invalid Note object, but required by unordered_map
-    note_number = 0;
-    velocity = 0;
-    frequency = 0;
-    phase = 0;
-    frames_since_pressed = 0;
+void Oscillator::render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float /* duty_offset */) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        phase += increment;
+        out[f_idx] += amplitude*evaluate(phase*phase_to_cycles);
+        amplitude += amplitude_step;
+    }
 }
+void Oscillator::render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float /* duty_offset */) {
+    const uint32_t copies = unison.get_copies();
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        float mid_sum = 0;
+        float side_sum = 0;
+        for (uint32_t c_idx = 0; c_idx < copies; ++c_idx) {
+            phases[c_idx] += increments[c_idx];
+            float y = evaluate(phases[c_idx]*phase_to_cycles);
+            mid_sum += y*unison.mid_gain[c_idx];
+            side_sum += y*unison.side_gain[c_idx];
+        }
+        mid[f_idx] += amplitude*mid_sum;
+        side[f_idx] += amplitude*side_sum;
+        amplitude += amplitude_step;
+    }
+}
+
+void Oscillator::render_voice_block(float* /* out */, uint32_t /* frames */, Voice_Pool& /* voices */, uint32_t /* voice */, uint32_t /* increment */, float /* amplitude */, float /* amplitude_step */) {}
+void Oscillator::render_unison_voice_block(float* /* mid */, float* /* side */, uint32_t /* frames */, Voice_Pool& /* voices */, uint32_t /* voice */, const uint32_t* /* increments */, const Unison& /* unison */, float /* amplitude */, float /* amplitude_step */) {}
 
-float Note::get_frequency_from_note_number(uint8_t note_number) {
-    return 440*pow(2, (note_number-69)/12.f);
+// the highest copy decides the mip levels, so none of them alias
+static uint32_t max_increment(const uint32_t* increments, uint32_t copies) {
+    return *std::max_element(increments, increments + copies);
 }
 
-Oscillator::Oscillator(float phase_shift, float duty_cycle_in) {
-    phase_offset = phase_shift;
-    duty_cycle = duty_cycle_in;
+static Unison_Copies unison_copies(uint32_t* phases, const uint32_t* increments, const Unison& unison) {
+    return Unison_Copies{phases, increments, unison.mid_gain, unison.side_gain, unison.get_copies()};
 }
 
-Signal_Generator::Signal_Generator(Oscillator* osc, double* sample_period_in, float* frequency_coefficient) {
+Signal_Generator::Signal_Generator(Oscillator* osc, const Envelope* envelope_in, const Unison* unison_in, const Modulation_Matrix* modulation_in, double* sample_period_in, float* frequency_coefficient) {
     oscillator = osc;
+    envelope = envelope_in;
+    unison = unison_in;
+    modulation = modulation_in;
     pitch_bend_coefficient = frequency_coefficient;
     sample_period = sample_period_in;
 }
 
 Signal_Generator::Signal_Generator() {
     oscillator = nullptr;
+    envelope = nullptr;
+    unison = nullptr;
+    modulation = nullptr;
     pitch_bend_coefficient = nullptr;
     sample_period = nullptr;
 }
 
-float Signal_Generator::pop_time_step(Note& current_note) {
-    current_note.frames_since_pressed += 1;
+// move a glide towards 0 by `distance` semitones without overshooting
+static float glide_towards_zero(float glide_st, float distance) {
+    return (glide_st > 0) ? std::max(0.f, glide_st - distance) : std::min(0.f, glide_st + distance);
+}
+
+bool Signal_Generator::update_envelope(Voice_Pool& voices, uint32_t voice, uint64_t frame) {
+    if (voices.envelope_frames_left[voice] > 0) {
+        return true;
+    }
+    if (voices.envelope_stage[voice] == Envelope_Stage::finished) {
+        return false;
+    }
+
+    // periods end on multiples of control_period, so a voice's first period may be shorter (a power of two, so mask)
+    const uint32_t control_period = envelope->get_control_period();
+    uint32_t period = control_period - (uint32_t(frame) & (control_period - 1));
+    const float start_level = voices.envelope_amplitude[voice];
+    float end_level = envelope->advance(voices.envelope_stage[voice], voices.envelope_level[voice], period);
+    voices.envelope_slope[voice] = (end_level - start_level)/period;
+    voices.envelope_frames_left[voice] = period;
+
+    // Modulation follows the same control periods, evaluated once each at the end of the period. The gain ramps to
+    // its end value, like the envelope. Pitch holds the mean of its start and end values (for glide, the value
+    // halfway through), so the phase lands where a smooth sweep would have taken it by the end of the period.
+    float gain_end = 1 + pressure_depth*voices.pressure[voice];
+    float pitch_st = 0;
+    float duty_offset = 0;
+    float pan = voices.pan[voice];
+    if (voices.glide_st[voice] != 0) {
+        pitch_st = glide_towards_zero(voices.glide_st[voice], voices.glide_rate_st[voice]*period*0.5f);
+        voices.glide_st[voice] = glide_towards_zero(voices.glide_st[voice], voices.glide_rate_st[voice]*period);
+    }
+    if (modulation != nullptr && modulation->is_active()) {
+        const Mod_Targets end = modulation->evaluate(voices, voice, frame + period, end_level);
+        // a new voice holds its first value rather than ramping from the last note's
+        const float start_pitch_st = voices.pitch_modulation_initialised[voice] ? voices.pitch_modulation_st[voice] : end.pitch_st;
+        voices.pitch_modulation_st[voice] = end.pitch_st;
+        voices.pitch_modulation_initialised[voice] = 1;
+        pitch_st += 0.5f*(start_pitch_st + end.pitch_st);
+        duty_offset = end.duty_offset;
+        gain_end *= std::max(0.f, 1 + end.amplitude);
+        pan += end.pan;
+    }
+    if (pitch_st != voices.pitch_offset_st[voice]) {
+        voices.pitch_offset_st[voice] = pitch_st;
+        voices.pitch_ratio[voice] = std::exp2(pitch_st*(1.f/12)); // at most once per period, never per frame
+    }
+    voices.duty_offset[voice] = duty_offset;
+    voices.modulation_gain_end[voice] = gain_end;
+    voices.modulation_gain_slope[voice] = (gain_end - voices.modulation_gain[voice])/period;
+    if (panning) {
+        pan = std::clamp(pan, -1.f, 1.f);
+        // not a NaN sentinel for the new voice, since -ffast-math assumes there are none
+        if (!voices.pan_initialised[voice] || pan != voices.pan_position[voice]) {
+            float left, right;
+            constant_power_pan(pan, left, right);
+            voices.pan_mid_gain_end[voice] = (left + right)/2;
+            voices.pan_side_gain_end[voice] = (left - right)/2;
+            if (!voices.pan_initialised[voice]) {
+                // a new note starts where it's panned rather than sweeping there
+                voices.pan_mid_gain[voice] = voices.pan_mid_gain_end[voice];
+                voices.pan_side_gain[voice] = voices.pan_side_gain_end[voice];
+                voices.pan_initialised[voice] = 1;
+            }
+            voices.pan_position[voice] = pan;
+        }
+    }
+    return true;
+}
+
+void Signal_Generator::advance_envelope(Voice_Pool& voices, uint32_t voice, uint32_t frames) {
+    voices.envelope_frames_left[voice] -= frames;
+    if (voices.envelope_frames_left[voice] == 0) {
+        voices.envelope_amplitude[voice] = voices.envelope_level[voice]; // land exactly on the exponential curve
+        voices.modulation_gain[voice] = voices.modulation_gain_end[voice];
+    } else {
+        voices.envelope_amplitude[voice] += voices.envelope_slope[voice]*frames;
+        voices.modulation_gain[voice] += voices.modulation_gain_slope[voice]*frames;
+    }
+}
 
-    // do not sound if the note hasn't started yet
-    if (current_note.frames_since_pressed <= 1) {
+float Signal_Generator::pop_time_step(Voice_Pool& voices, uint32_t voice, uint64_t frame) {
+    if (!update_envelope(voices, voice, frame)) {
         return 0;
     }
 
     // calculate phase
-    float effective_frequency = current_note.frequency * (*pitch_bend_coefficient);
-    current_note.phase += effective_frequency * (*sample_period);
-    if (current_note.phase > 1) {
-        current_note.phase -= 1;
-    }
+    float effective_frequency = voices.frequency[voice] * (*pitch_bend_coefficient) * voices.bend[voice] * voices.pitch_ratio[voice];
+    voices.phase[voice] += phase_increment_from_frequency(effective_frequency, *sample_period);
+
+    float amplitude = 0.5f*voices.velocity[voice]*voices.modulation_gain[voice]*voices.envelope_amplitude[voice];
+    advance_envelope(voices, voice, 1);
+    return amplitude * oscillator->evaluate(voices.phase[voice]*phase_to_cycles);
+}
+
+void Signal_Generator::render_block(Voice_Pool& voices, uint32_t voice, float* mid, float* side, uint32_t frames, uint64_t start_frame) {
+    // the caller splits blocks at MIDI events, so pitch bend is constant here; modulation changes once per period
+    const float frequency = voices.frequency[voice] * (*pitch_bend_coefficient) * voices.bend[voice];
+    const bool unison_enabled = unison != nullptr && unison->is_enabled();
+    uint32_t increment = 0;
+    uint32_t unison_increments[Unison::max_copies] = {}; // unused copies stay at 0, so their padding lanes don't move
+    float increment_ratio = 0; // the pitch_ratio the increments are for; 0 until the first span
+
+    // The amplitude ramps linearly from one envelope control period to the next. The modulation gain ramps as well,
+    // and the product of the two ramps is close enough to linear over a period to fold into one amplitude step.
+    const float gain = 0.5f*voices.velocity[voice];
 
-    // later: do envelope-related calculations. For now just use velocity
-    float rel_velocity = current_note.velocity/127.f;
+    // While panning, each span renders into these (spans never cross a control period), then pans into mid and side
+    float voice_mid[Envelope::max_control_period];
+    float voice_side[Envelope::max_control_period];
 
-    return 0.5*rel_velocity * oscillator->evaluate(current_note.phase);
+    uint32_t f_idx = 0;
+    while (f_idx < frames && update_envelope(voices, voice, start_frame + f_idx)) {
+        uint32_t span = std::min(frames - f_idx, voices.envelope_frames_left[voice]);
+        if (voices.pitch_ratio[voice] != increment_ratio) {
+            increment_ratio = voices.pitch_ratio[voice];
+            const float effective_frequency = frequency*increment_ratio;
+            increment = phase_increment_from_frequency(effective_frequency, *sample_period);
+            if (unison_enabled) {
+                for (uint32_t c_idx = 0; c_idx < unison->get_copies(); ++c_idx) {
+                    unison_increments[c_idx] = phase_increment_from_frequency(effective_frequency*unison->ratio[c_idx], *sample_period);
+                }
+            }
+        }
+        const float modulated_gain = gain*voices.modulation_gain[voice];
+        const float amplitude = modulated_gain*voices.envelope_amplitude[voice];
+        const float amplitude_step = modulated_gain*voices.envelope_slope[voice] + gain*voices.modulation_gain_slope[voice]*voices.envelope_amplitude[voice];
+        float* span_mid = mid + f_idx;
+        float* span_side = unison_enabled ? side + f_idx : nullptr;
+        if (panning) {
+            span_mid = voice_mid;
+            std::fill(voice_mid, voice_mid + span, 0.f);
+            if (unison_enabled) {
+                span_side = voice_side;
+                std::fill(voice_side, voice_side + span, 0.f);
+            }
+        }
+        if (oscillator->has_voice_state()) {
+            if (unison_enabled) {
+                oscillator->render_unison_voice_block(span_mid, span_side, span, voices, voice, unison_increments, *unison, amplitude, amplitude_step);
+            } else {
+                oscillator->render_voice_block(span_mid, span, voices, voice, increment, amplitude, amplitude_step);
+            }
+        } else if (unison_enabled) {
+            oscillator->render_unison_block(span_mid, span_side, span, voices.get_unison_phases(voice), unison_increments, *unison, amplitude, amplitude_step, voices.duty_offset[voice]);
+        } else {
+            oscillator->render_block(span_mid, span, voices.phase[voice], increment, amplitude, amplitude_step, voices.duty_offset[voice]);
+        }
+        if (panning) {
+            // the gains ramp to where the control period ends, and land there exactly
+            const float frames_left = float(voices.envelope_frames_left[voice]);
+            const Pan_Gains gains = {
+                voices.pan_mid_gain[voice], voices.pan_side_gain[voice],
+                (voices.pan_mid_gain_end[voice] - voices.pan_mid_gain[voice])/frames_left,
+                (voices.pan_side_gain_end[voice] - voices.pan_side_gain[voice])/frames_left,
+            };
+            accumulate_panned(mid + f_idx, side + f_idx, voice_mid, span_side, span, gains);
+            if (span == voices.envelope_frames_left[voice]) {
+                voices.pan_mid_gain[voice] = voices.pan_mid_gain_end[voice];
+                voices.pan_side_gain[voice] = voices.pan_side_gain_end[voice];
+            } else {
+                voices.pan_mid_gain[voice] += gains.mid_step*span;
+                voices.pan_side_gain[voice] += gains.side_step*span;
+            }
+        }
+        advance_envelope(voices, voice, span);
+        f_idx += span;
+    }
 }
 
 float Sine_Oscillator::evaluate(float phase) {
     return sin(2*M_PI*phase);
-}
\ No newline at end of file
+}
+
+void Fast_Sine_Oscillator::render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float /* duty_offset */) {
+    accumulate_fast_sine(out, frames, phase, increment, amplitude, amplitude_step);
+}
+void Fast_Sine_Oscillator::render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float /* duty_offset */) {
+    accumulate_unison_fast_sine(mid, side, frames, unison_copies(phases, increments, unison), amplitude, amplitude_step);
+}
+
+float Wavetable_Oscillator::evaluate(float phase) {
+    return Wavetable::lookup(table->get_level(0), phase_from_cycles(phase));
+}
+
+void Wavetable_Oscillator::render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float /* duty_offset */) {
+    Wavetable_Levels levels;
+    table->select_levels(increment, levels.level_a, levels.level_b, levels.b_weight);
+    accumulate_wavetable(out, frames, phase, increment, levels, amplitude, amplitude_step);
+}
+void Wavetable_Oscillator::render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float /* duty_offset */) {
+    Wavetable_Levels levels;
+    table->select_levels(max_increment(increments, unison.get_copies()), levels.level_a, levels.level_b, levels.b_weight);
+    accumulate_unison_wavetable(mid, side, frames, unison_copies(phases, increments, unison), levels, amplitude, amplitude_step);
+}
+
+// a pulse is the difference of two ramps read from the saw table (see Pulse_Lanes in kernel_sets.hpp)
+static const uint32_t half_cycle = 0x80000000u;
+
+float Pulse_Oscillator::evaluate(float phase) {
+    const float* level = table->get_level(0);
+    uint32_t fixed_phase = phase_from_cycles(phase) + half_cycle;
+    uint32_t duty_phase = phase_from_cycles(duty_cycle);
+    return Wavetable::lookup(level, fixed_phase - duty_phase) - Wavetable::lookup(level, fixed_phase) + (2*duty_cycle - 1);
+}
+
+// modulation keeps the duty cycle clear of 0 and 1, where the pulse would fade into silence
+static const float min_duty_cycle = 0.05f;
+
+static void set_duty_cycle(Pulse_Shape& shape, float duty_cycle) {
+    duty_cycle = std::clamp(duty_cycle, min_duty_cycle, 1 - min_duty_cycle);
+    shape.duty_phase = phase_from_cycles(duty_cycle);
+    shape.dc_offset = 2*duty_cycle - 1;
+}
+
+void Pulse_Oscillator::render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) {
+    Pulse_Shape shape;
+    table->select_levels(increment, shape.saw.level_a, shape.saw.level_b, shape.saw.b_weight);
+    set_duty_cycle(shape, duty_cycle + duty_offset);
+    accumulate_pulse(out, frames, phase, increment, shape, amplitude, amplitude_step);
+}
+void Pulse_Oscillator::render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset) {
+    Pulse_Shape shape;
+    table->select_levels(max_increment(increments, unison.get_copies()), shape.saw.level_a, shape.saw.level_b, shape.saw.b_weight);
+    set_duty_cycle(shape, duty_cycle + duty_offset);
+    accumulate_unison_pulse(mid, side, frames, unison_copies(phases, increments, unison), shape, amplitude, amplitude_step);
+}
+
+float Additive_Oscillator::evaluate(float phase) {
+    const float* amplitudes = spectrum->get_amplitudes();
+    double sum = 0;
+    for (uint32_t p_idx = 0; p_idx < spectrum->get_partial_count(); ++p_idx) {
+        sum += amplitudes[p_idx]*sin(2*M_PI*(p_idx + 1)*phase);
+    }
+    return float(sum);
+}
+
+void Additive_Oscillator::render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float /* duty_offset */) {
+    alignas(64) float amplitudes[Additive_Spectrum::max_partials]; // on the stack, since voices may render on several threads at once
+    Additive_Partials partials = {amplitudes, spectrum->band_limit(increment, amplitudes)};
+    if (partials.count == 0) {
+        phase += frames*increment; // nothing below nyquist
+        return;
+    }
+    accumulate_additive(out, frames, phase, increment, partials, amplitude, amplitude_step);
+}
+void Additive_Oscillator::render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float /* duty_offset */) {
+    alignas(64) float amplitudes[Additive_Spectrum::max_partials];
+    Additive_Partials partials = {amplitudes, spectrum->band_limit(max_increment(increments, unison.get_copies()), amplitudes)};
+    if (partials.count == 0) {
+        for (uint32_t c_idx = 0; c_idx < unison.get_copies(); ++c_idx) {
+            phases[c_idx] += frames*increments[c_idx];
+        }
+        return;
+    }
+    accumulate_unison_additive(mid, side, frames, unison_copies(phases, increments, unison), partials, amplitude, amplitude_step);
+}
+
+float FM_Oscillator::evaluate(float phase) {
+    double modulation[FM_Patch::max_operators] = {};
+    double sum = 0;
+    for (uint32_t s_idx = 0; s_idx < patch->get_step_count(); ++s_idx) {
+        const FM_Patch::Step& step = patch->get_steps()[s_idx];
+        const double y = step.gain*sin(2*M_PI*(step.ratio*phase + modulation[step.op]));
+        for (uint32_t op = 0; op < FM_Patch::max_operators; ++op) {
+            if ((step.targets >> op) & 1) {
+                modulation[op] += y;
+            }
+        }
+        sum += (step.targets == 0) ? y : 0;
+    }
+    return float(sum);
+}
+
+void FM_Oscillator::render_chunk(float* out, uint32_t frames, uint32_t* phases, float* feedback, uint32_t increment, float amplitude, float amplitude_step) const {
+    // Each modulated operator gets a buffer that its modulators add to. An operator modulating several others renders
+    // once into `shared`, which is then added to each of theirs.
+    alignas(64) float modulation[FM_Patch::max_operators][chunk_frames];
+    alignas(64) float shared[chunk_frames];
+    const FM_Patch::Step* steps = patch->get_steps();
+    for (uint32_t s_idx = 0; s_idx < patch->get_step_count(); ++s_idx) {
+        if (steps[s_idx].modulated) {
+            std::fill(modulation[steps[s_idx].op], modulation[steps[s_idx].op] + frames, 0.f);
+        }
+    }
+
+    for (uint32_t s_idx = 0; s_idx < patch->get_step_count(); ++s_idx) {
+        const FM_Patch::Step& step = steps[s_idx];
+        // an operator tuned past nyquist wraps around and aliases, like any increment over half a cycle
+        const uint32_t op_increment = uint32_t(int64_t(double(increment)*step.ratio));
+        const float* input = step.modulated ? modulation[step.op] : nullptr;
+
+        float* target = out;
+        float gain = amplitude*step.gain;
+        float gain_step = amplitude_step*step.gain;
+        const bool fan_out = (step.targets & (step.targets - 1)) != 0;
+        if (fan_out) {
+            std::fill(shared, shared + frames, 0.f);
+            target = shared;
+        } else if (step.targets != 0) {
+            target = modulation[step.first_target];
+        }
+        if (step.targets != 0) {
+            gain = step.gain; // modulation depth in cycles, independent of the voice's level
+            gain_step = 0;
+        }
+
+        if (step.feedback && patch->get_feedback_cycles() > 0) {
+            accumulate_feedback_sine(target, frames, phases[step.op], op_increment, input, feedback, patch->get_feedback_cycles(), gain, gain_step);
+        } else if (input != nullptr) {
+            accumulate_modulated_sine(target, frames, phases[step.op], op_increment, input, gain, gain_step);
+        } else {
+            accumulate_fast_sine(target, frames, phases[step.op], op_increment, gain, gain_step);
+        }
+
+        if (fan_out) {
+            for (uint32_t op = 0; op < FM_Patch::max_operators; ++op) {
+                if ((step.targets >> op) & 1) {
+                    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+                        modulation[op][f_idx] += shared[f_idx];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FM_Oscillator::render_voice_block(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t increment, float amplitude, float amplitude_step) {
+    const Operator_State state = voices.get_operator_state(voice);
+    for (uint32_t f_idx = 0; f_idx < frames; f_idx += chunk_frames) {
+        const uint32_t chunk = std::min(chunk_frames, frames - f_idx);
+        render_chunk(out + f_idx, chunk, state.phases, state.feedback, increment, amplitude, amplitude_step);
+        amplitude += chunk*amplitude_step;
+    }
+}
+void FM_Oscillator::render_unison_voice_block(float* mid, float* side, uint32_t frames, Voice_Pool& voices, uint32_t voice, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step) {
+    const Operator_State state = voices.get_operator_state(voice);
+    // each copy is a whole voice of operators, so they can't share vector lanes like the other oscillators' copies
+    alignas(64) float copy_out[chunk_frames];
+    for (uint32_t f_idx = 0; f_idx < frames; f_idx += chunk_frames) {
+        const uint32_t chunk = std::min(chunk_frames, frames - f_idx);
+        for (uint32_t c_idx = 0; c_idx < unison.get_copies(); ++c_idx) {
+            std::fill(copy_out, copy_out + chunk, 0.f);
+            render_chunk(copy_out, chunk, state.phases + c_idx*FM_Patch::max_operators, state.feedback + 2*c_idx, increments[c_idx], amplitude, amplitude_step);
+            const float mid_gain = unison.mid_gain[c_idx];
+            const float side_gain = unison.side_gain[c_idx];
+            for (uint32_t c_frame = 0; c_frame < chunk; ++c_frame) {
+                mid[f_idx + c_frame] += mid_gain*copy_out[c_frame];
+                side[f_idx + c_frame] += side_gain*copy_out[c_frame];
+            }
+        }
+        amplitude += chunk*amplitude_step;
+    }
+}
+
+float Sample_Oscillator::evaluate(float /* phase */) {
+    return 0;
+}
+
+void Sample_Oscillator::render_voice_block(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t increment, float amplitude, float amplitude_step) {
+    streamer->render(out, frames, voices, voice, increment, amplitude, amplitude_step);
+}
+void Sample_Oscillator::render_unison_voice_block(float* mid, float* /* side */, uint32_t frames, Voice_Pool& voices, uint32_t voice, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step) {
+    // a voice has one stream, so unison plays it once, in the middle, at the copies' mean pitch
+    uint64_t increment_sum = 0;
+    for (uint32_t c_idx = 0; c_idx < unison.get_copies(); ++c_idx) {
+        increment_sum += increments[c_idx];
+    }
+    streamer->render(mid, frames, voices, voice, uint32_t(increment_sum/unison.get_copies()), amplitude, amplitude_step);
+}
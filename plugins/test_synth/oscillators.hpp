@@ -18,20 +18,19 @@ OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
 PERFORMANCE OF THIS SOFTWARE.
 */
 
-#include "../../DPF/distrho/DistrhoPlugin.hpp"
-
-struct Note {
-    Note(uint8_t note_number_in, uint8_t velocity_in, uint32_t frames_until_press);
-    Note();
-    uint8_t note_number;
-    uint8_t velocity;
+#pragma once
 
-    float frequency;
-    float phase;
-    int32_t frames_since_pressed;
+#include "../../DPF/distrho/DistrhoPlugin.hpp"
 
-    float get_frequency_from_note_number(uint8_t note_number);
-};
+#include "additive.hpp"
+#include "envelope.hpp"
+#include "fm.hpp"
+#include "kernels.hpp"
+#include "modulation.hpp"
+#include "sampler.hpp"
+#include "unison.hpp"
+#include "voices.hpp"
+#include "wavetables.hpp"
 
 class Oscillator {
     // abstract base class for all oscillators
@@ -41,23 +40,61 @@ class Oscillator {
 
     virtual float evaluate(float phase) = 0;    // phase is normalized between 0 and 1. Result should be equal to 0 at phase=0.
 
+    // Advance the fixed-point phase by `increment` each frame and add amplitude*evaluate(phase) to out,
+    // ramping the amplitude by amplitude_step per frame. duty_offset is added to the duty cycle, for pulse width modulation.
+    // The default calls evaluate() per frame; subclasses override it with a block kernel.
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset);
+
+    // The same for the detuned copies of a unison voice, each with its own phase and increment, mixed into mid and
+    // side with the gains from `unison` (see Unison_Copies in kernels.hpp for the layout).
+    // The default calls evaluate() per copy and frame; subclasses override it with a kernel that runs copies in vector lanes.
+    virtual void render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset);
+
+    // Oscillators with more state per voice than a phase (FM_Oscillator's operators, Sample_Oscillator's streams) find
+    // it from the voice instead, and Signal_Generator renders them through these when has_voice_state() is true.
+    // The defaults render nothing.
+    virtual bool has_voice_state() const { return false; }
+    virtual void render_voice_block(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t increment, float amplitude, float amplitude_step);
+    virtual void render_unison_voice_block(float* mid, float* side, uint32_t frames, Voice_Pool& voices, uint32_t voice, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step);
+
     protected:
     float phase_offset;
-    float duty_cycle;  // generalized, modifies phase before passing into the signal function. Not yet implemented.
+    float duty_cycle;  // generalized, modifies phase before passing into the signal function. Currently only used by Pulse_Oscillator.
 };
 
 class Signal_Generator {
     public:
-    Signal_Generator(Oscillator* osc, double* sample_period_in, float* frequency_coefficient);
+    Signal_Generator(Oscillator* osc, const Envelope* envelope_in, const Unison* unison_in, const Modulation_Matrix* modulation_in, double* sample_period_in, float* frequency_coefficient);
     Signal_Generator();
     protected:
     Oscillator* oscillator; // can be a list in the future
-    // Envelope* envelope; // to implement later
+    const Envelope* envelope;
+    const Unison* unison;
+    const Modulation_Matrix* modulation;
     const float* pitch_bend_coefficient;
     const double* sample_period;
+    float pressure_depth = 0; // gain added at full pressure
+    bool panning = false;
 
     public:
-    float pop_time_step(Note& current_note); // advance time, then get the value
+    void set_oscillator(Oscillator* osc) { oscillator = osc; } // only between blocks; voices keep their phase
+    void set_pressure_depth(float depth) { pressure_depth = depth; } // only between blocks
+    // Pan each voice to its own position (see Voice_Pool::pan), which needs the side channel even outside unison mode.
+    // Voices then render into a buffer of their own first, one span at a time. Only between blocks.
+    void set_panning(bool enabled) { panning = enabled; }
+    bool is_panning() const { return panning; }
+    float pop_time_step(Voice_Pool& voices, uint32_t voice, uint64_t frame); // advance time, then get the value
+    // Advance time by `frames`, adding the result to mid, and to side in unison mode or while panning (side may be null otherwise).
+    // start_frame is the running frame count of the first frame, which keeps envelope control periods on the same
+    // grid however the host and MIDI events split the blocks, so the output doesn't depend on the buffer size.
+    // Each voice's pitch bend is read once per call. Pressure, glide and the modulation matrix are evaluated once per
+    // control period: gain ramps through the amplitude step the kernels already interpolate, pan ramps from one period
+    // to the next as well, and pitch and pulse width change between periods.
+    void render_block(Voice_Pool& voices, uint32_t voice, float* mid, float* side, uint32_t frames, uint64_t start_frame);
+
+    protected:
+    bool update_envelope(Voice_Pool& voices, uint32_t voice, uint64_t frame); // start the next control period (envelope and modulation) if needed; false once finished
+    void advance_envelope(Voice_Pool& voices, uint32_t voice, uint32_t frames);
 };
 
 class Sine_Oscillator : public Oscillator {
@@ -67,3 +104,112 @@ class Sine_Oscillator : public Oscillator {
     protected:
     virtual float evaluate(float phase) override;
 };
+
+class Fast_Sine_Oscillator : public Sine_Oscillator {
+    // same signal as Sine_Oscillator, rendered in blocks with a polynomial sine (see kernels.hpp)
+    public:
+    Fast_Sine_Oscillator(float phase_shift = 0, float duty_cycle_in = 0.5) : Sine_Oscillator(phase_shift, duty_cycle_in) {}
+
+    protected:
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) override;
+    virtual void render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset) override;
+};
+
+enum class Waveform : uint8_t {
+    sine,
+    saw,
+    pulse,
+    triangle,
+    additive,
+    fm,
+    sample,
+    count,
+};
+
+class Wavetable_Oscillator : public Oscillator {
+    // Reads a band-limited Wavetable, crossfading between mip levels according to the pitch.
+    // The table is owned elsewhere and has to be built before the oscillator renders.
+    public:
+    Wavetable_Oscillator(const Wavetable* table_in, float phase_shift = 0, float duty_cycle_in = 0.5) : Oscillator(phase_shift, duty_cycle_in), table(table_in) {}
+
+    protected:
+    virtual float evaluate(float phase) override; // full-bandwidth level; aliases at high pitches
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) override;
+    virtual void render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset) override;
+
+    const Wavetable* table;
+};
+
+class Saw_Oscillator : public Wavetable_Oscillator {
+    public:
+    Saw_Oscillator(const Wavetable* saw_table, float phase_shift = 0, float duty_cycle_in = 0.5) : Wavetable_Oscillator(saw_table, phase_shift, duty_cycle_in) {}
+};
+
+class Triangle_Oscillator : public Wavetable_Oscillator {
+    public:
+    Triangle_Oscillator(const Wavetable* triangle_table, float phase_shift = 0, float duty_cycle_in = 0.5) : Wavetable_Oscillator(triangle_table, phase_shift, duty_cycle_in) {}
+};
+
+class Pulse_Oscillator : public Wavetable_Oscillator {
+    // Pulse wave that is high for duty_cycle of each period, built as the difference of two saws,
+    // so any duty cycle is band-limited using only the saw table.
+    public:
+    Pulse_Oscillator(const Wavetable* saw_table, float phase_shift = 0, float duty_cycle_in = 0.5) : Wavetable_Oscillator(saw_table, phase_shift, duty_cycle_in) {}
+
+    protected:
+    virtual float evaluate(float phase) override;
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) override;
+    virtual void render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset) override;
+};
+
+class Additive_Oscillator : public Oscillator {
+    // Sums the harmonics of an Additive_Spectrum, owned elsewhere, with the additive kernels (see kernels.hpp).
+    // Harmonics are dropped and faded against nyquist for each span, so every pitch is band-limited exactly.
+    public:
+    Additive_Oscillator(const Additive_Spectrum* spectrum_in, float phase_shift = 0, float duty_cycle_in = 0.5) : Oscillator(phase_shift, duty_cycle_in), spectrum(spectrum_in) {}
+
+    protected:
+    virtual float evaluate(float phase) override; // every harmonic, with sin(); aliases at high pitches
+    virtual void render_block(float* out, uint32_t frames, uint32_t& phase, uint32_t increment, float amplitude, float amplitude_step, float duty_offset) override;
+    virtual void render_unison_block(float* mid, float* side, uint32_t frames, uint32_t* phases, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step, float duty_offset) override;
+
+    const Additive_Spectrum* spectrum;
+};
+
+class FM_Oscillator : public Oscillator {
+    // Phase-modulated sines, connected and tuned by an FM_Patch owned elsewhere. Operators render one at a time over a
+    // whole chunk of frames with the block kernels, in the patch's order, so each modulator's output is in a buffer
+    // before the operators it modulates read it. Only the feedback operator runs a frame at a time.
+    public:
+    FM_Oscillator(const FM_Patch* patch_in, float phase_shift = 0, float duty_cycle_in = 0.5) : Oscillator(phase_shift, duty_cycle_in), patch(patch_in) {}
+
+    static const uint32_t chunk_frames = 64; // frames per pass through the operators, which sizes their buffers on the stack
+
+    protected:
+    // Every operator with sin(), at its ratio times the phase and without feedback; the same as rendering the patch
+    // only for whole-number ratios and no feedback
+    virtual float evaluate(float phase) override;
+    virtual bool has_voice_state() const override { return true; }
+    virtual void render_voice_block(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t increment, float amplitude, float amplitude_step) override;
+    virtual void render_unison_voice_block(float* mid, float* side, uint32_t frames, Voice_Pool& voices, uint32_t voice, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step) override;
+
+    // one copy of a voice, at most chunk_frames long: max_operators phases and two feedback samples
+    void render_chunk(float* out, uint32_t frames, uint32_t* phases, float* feedback, uint32_t increment, float amplitude, float amplitude_step) const;
+
+    const FM_Patch* patch;
+};
+
+class Sample_Oscillator : public Oscillator {
+    // Plays each voice's stream from a Sample_Streamer owned elsewhere (see sampler.hpp), pitched by how far the voice's
+    // frequency is from the region's root key. A sample has no cycle, so evaluate() is silent.
+    public:
+    Sample_Oscillator(Sample_Streamer* streamer_in, float phase_shift = 0, float duty_cycle_in = 0.5) : Oscillator(phase_shift, duty_cycle_in), streamer(streamer_in) {}
+
+    protected:
+    virtual float evaluate(float phase) override;
+    virtual bool has_voice_state() const override { return true; }
+    virtual void render_voice_block(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t increment, float amplitude, float amplitude_step) override;
+    virtual void render_unison_voice_block(float* mid, float* side, uint32_t frames, Voice_Pool& voices, uint32_t voice, const uint32_t* increments, const Unison& unison, float amplitude, float amplitude_step) override;
+
+    Sample_Streamer* streamer;
+};
@@ -0,0 +1,181 @@
+/*
+oversampling.cpp
+Oversampling for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "oversampling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static double bessel_i0(double x) {
+    // power series of the zeroth order modified Bessel function, which converges quickly for Kaiser windows
+    double sum = 1;
+    double term = 1;
+    for (uint32_t k = 1; k < 50 && term > sum*1e-12; ++k) {
+        term *= (x/(2*k))*(x/(2*k));
+        sum += term;
+    }
+    return sum;
+}
+
+void Half_Band_Decimator::design(uint32_t half_length, float kaiser_beta) {
+    coefficients.assign(half_length, 0);
+
+    // tap j sits 2j + 1 frames from the centre of a filter with 2*half_length - 1 taps on each side
+    const double half_width = 2.0*half_length - 1;
+    double sum = 0;
+    for (uint32_t j = 0; j < half_length; ++j) {
+        double offset = 2.0*j + 1;
+        double sinc = std::sin(M_PI*offset/2)/(M_PI*offset);
+        double ratio = offset/half_width;
+        double window = bessel_i0(kaiser_beta*std::sqrt(1 - ratio*ratio))/bessel_i0(kaiser_beta);
+        coefficients[j] = float(sinc*window);
+        sum += 2*coefficients[j];
+    }
+
+    // the side taps add up to 0.5 along with the centre tap, for unity gain at DC
+    for (float& coefficient : coefficients) {
+        coefficient = float(coefficient*0.5/sum);
+    }
+}
+void Half_Band_Decimator::allocate(uint32_t max_output_frames) {
+    even.assign(2*coefficients.size() - 1 + max_output_frames, 0);
+    odd.assign(coefficients.size() + max_output_frames, 0);
+}
+void Half_Band_Decimator::free_storage() {
+    even = std::vector<float>();
+    odd = std::vector<float>();
+}
+void Half_Band_Decimator::reset() {
+    std::fill(even.begin(), even.end(), 0.f);
+    std::fill(odd.begin(), odd.end(), 0.f);
+}
+
+void Half_Band_Decimator::process(const float* in, uint32_t output_frames, float* out) {
+    const uint32_t half_length = coefficients.size();
+    const uint32_t even_history = 2*half_length - 1;
+    const uint32_t odd_history = half_length;
+    float* const e = even.data() + even_history;
+    float* const o = odd.data() + odd_history;
+
+    // split into polyphase branches
+    uint32_t m_idx = 0;
+#if defined(__SSE2__)
+    for (; m_idx + 4 <= output_frames; m_idx += 4) {
+        __m128 a = _mm_loadu_ps(in + 2*m_idx);
+        __m128 b = _mm_loadu_ps(in + 2*m_idx + 4);
+        _mm_storeu_ps(e + m_idx, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(o + m_idx, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#endif
+    for (; m_idx < output_frames; ++m_idx) {
+        e[m_idx] = in[2*m_idx];
+        o[m_idx] = in[2*m_idx + 1];
+    }
+
+    // y[m] = 0.5*o[m - K] + sum over j of h[j]*(e[m - (K - 1 - j)] + e[m - (K + j)])
+    const float* const h = coefficients.data();
+    const float* const centre = o - half_length;
+    m_idx = 0;
+#if defined(__SSE2__)
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; m_idx + 4 <= output_frames; m_idx += 4) {
+        __m128 sum = _mm_mul_ps(half, _mm_loadu_ps(centre + m_idx));
+        for (uint32_t j = 0; j < half_length; ++j) {
+            const float* newer = e - (half_length - 1 - j);
+            const float* older = e - (half_length + j);
+            __m128 pair = _mm_add_ps(_mm_loadu_ps(newer + m_idx), _mm_loadu_ps(older + m_idx));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(h[j]), pair));
+        }
+        _mm_storeu_ps(out + m_idx, sum);
+    }
+#endif
+    for (; m_idx < output_frames; ++m_idx) {
+        float sum = 0.5f*centre[m_idx];
+        for (uint32_t j = 0; j < half_length; ++j) {
+            const float* newer = e - (half_length - 1 - j);
+            const float* older = e - (half_length + j);
+            sum += h[j]*(newer[m_idx] + older[m_idx]);
+        }
+        out[m_idx] = sum;
+    }
+
+    // keep the newest samples as history for the next block
+    std::memmove(even.data(), even.data() + output_frames, even_history*sizeof(float));
+    std::memmove(odd.data(), odd.data() + output_frames, odd_history*sizeof(float));
+}
+
+Decimator::Decimator() {
+    stages[0].design(14, 8); // 55 taps: passband to 0.4, stopband from 0.6 of the host rate
+    stages[1].design(6, 8);  // 23 taps
+    stages[2].design(4, 8);  // 15 taps
+}
+void Decimator::allocate(uint32_t max_frames) {
+    for (uint32_t s_idx = 0; s_idx < num_stages; ++s_idx) {
+        stages[s_idx].allocate(max_frames << s_idx);
+    }
+}
+void Decimator::free_storage() {
+    for (Half_Band_Decimator& stage : stages) {
+        stage.free_storage();
+    }
+}
+void Decimator::set_factor(uint32_t factor_in) {
+    factor = 1;
+    stage_count = 0;
+    while (factor < factor_in && factor < max_factor) {
+        factor *= 2;
+        ++stage_count;
+    }
+    for (Half_Band_Decimator& stage : stages) {
+        stage.reset();
+    }
+}
+double Decimator::get_latency() const {
+    // stage s runs at 2^(s + 1) times the host rate
+    double latency = 0;
+    for (uint32_t s_idx = 0; s_idx < stage_count; ++s_idx) {
+        latency += stages[s_idx].get_latency()/double(2u << s_idx);
+    }
+    return latency;
+}
+uint32_t Decimator::get_tail_frames() const {
+    // each stage's history is all zeros once a whole filter length of silence has passed through it
+    uint32_t tail = 0;
+    for (uint32_t s_idx = 0; s_idx < stage_count; ++s_idx) {
+        uint32_t stage_rate = 2u << s_idx;
+        tail += (stages[s_idx].get_length() + stage_rate - 1)/stage_rate;
+    }
+    return tail;
+}
+
+void Decimator::process(float* in, uint32_t frames, float* out) {
+    if (stage_count == 0) {
+        std::memcpy(out, in, frames*sizeof(float));
+        return;
+    }
+    for (uint32_t s_idx = stage_count; s_idx-- > 0;) {
+        stages[s_idx].process(in, frames << s_idx, s_idx == 0 ? out : in);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+oversampling.hpp
+Oversampling for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Half_Band_Decimator {
+    // Halves the sample rate with a linear-phase half-band FIR. All of a half-band filter's even-offset taps are
+    // zero apart from the centre one, so the input is split into its two polyphase branches: the odd samples only
+    // meet the centre tap (0.5), and the even samples go through a short symmetric filter that runs at the output rate.
+    public:
+    // half_length K gives a 4K - 1 tap Kaiser-windowed filter; larger kaiser_beta trades a wider transition for
+    // more stopband attenuation (8 gives about 80 dB). Not RT safe.
+    void design(uint32_t half_length, float kaiser_beta);
+    void allocate(uint32_t max_output_frames); // not RT safe
+    void free_storage();
+    void reset();
+
+    // Read 2*output_frames samples from in and write output_frames samples to out, which may be the same buffer
+    void process(const float* in, uint32_t output_frames, float* out);
+
+    double get_latency() const { return 2.0*coefficients.size() - 1; } // in input frames
+    uint32_t get_length() const { return 4*uint32_t(coefficients.size()) - 1; } // in input frames
+
+    protected:
+    std::vector<float> coefficients; // the nonzero taps on one side of the centre, nearest first
+    std::vector<float> even;         // the last 2K - 1 even samples, then the current block's
+    std::vector<float> odd;          // the last K odd samples, then the current block's
+};
+
+class Decimator {
+    // Brings an oversampled signal back down to the host rate with a cascade of half-band stages. The last stage
+    // has the narrowest transition band (passband to 0.4 of the host rate), while earlier stages only have to
+    // remove what would alias into the band the later stages keep, so they're much shorter.
+    public:
+    static const uint32_t max_factor = 8;
+
+    Decimator(); // designs the filters
+    void allocate(uint32_t max_frames); // at the host rate; not RT safe
+    void free_storage();
+    void set_factor(uint32_t factor_in); // 1, 2, 4 or max_factor. Clears the filters.
+    uint32_t get_factor() const { return factor; }
+    double get_latency() const; // group delay in host frames
+    uint32_t get_tail_frames() const; // host frames after the input goes silent until the output is exactly 0
+
+    // Filter frames*factor samples from in down to frames samples in out. in is used as scratch space.
+    void process(float* in, uint32_t frames, float* out);
+
+    protected:
+    static const uint32_t num_stages = 3;
+    Half_Band_Decimator stages[num_stages]; // stages[0] outputs the host rate, stages[1] feeds it, and so on
+    uint32_t stage_count = 0;
+    uint32_t factor = 1;
+};
@@ -0,0 +1,71 @@
+/*
+parameters.cpp
+Parameter smoothing for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "parameters.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+
+void Smoothed_Parameter::allocate(uint32_t max_frames) {
+    buffer.assign(max_frames, value);
+    settled_frames = max_frames;
+}
+void Smoothed_Parameter::free_storage() {
+    buffer = std::vector<float>();
+    settled_frames = 0;
+}
+void Smoothed_Parameter::set_ramp_time(float seconds, double sample_rate) {
+    ramp_frames = std::max(uint32_t(seconds*sample_rate), uint32_t(1));
+}
+
+void Smoothed_Parameter::reset(float value_in) {
+    value = value_in;
+    target = value_in;
+    frames_left = 0;
+    settled_frames = 0;
+}
+void Smoothed_Parameter::set_target(float target_in) {
+    if (target_in == target) {
+        return; // hosts resend unchanged values; don't restart the ramp
+    }
+    target = target_in;
+    frames_left = ramp_frames;
+    step = (target - value)/ramp_frames;
+}
+
+const float* Smoothed_Parameter::render(uint32_t frames) {
+    float* const out = buffer.data();
+    uint32_t f_idx = 0;
+
+    if (frames_left > 0) {
+        f_idx = std::min(frames, frames_left);
+        fill_ramp(out, f_idx, value + step, step);
+        frames_left -= f_idx;
+        value = (frames_left == 0) ? target : value + f_idx*step; // land exactly on the target
+        settled_frames = 0;
+    }
+
+    if (f_idx == 0 && settled_frames >= frames) {
+        return out; // still holding the same constant as last block
+    }
+    fill_ramp(out + f_idx, frames - f_idx, value, 0);
+    settled_frames = (f_idx == 0) ? frames : 0;
+    return out;
+}
@@ -0,0 +1,55 @@
+/*
+parameters.hpp
+Parameter smoothing for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Smoothed_Parameter {
+    // A value that moves to each new target in a straight line over a fixed ramp time, so automation doesn't zipper.
+    // render() writes a whole block of values into a buffer at once, so following automation costs one vectorized
+    // fill per block, and nothing at all once the value has settled.
+    public:
+    void allocate(uint32_t max_frames); // not RT safe
+    void free_storage();
+    void set_ramp_time(float seconds, double sample_rate);
+
+    void reset(float value_in); // jump straight to value_in
+    void set_target(float target_in); // start a ramp from the current value
+
+    // Values for the next `frames` frames (at most max_frames), where the last one is the value after the block.
+    // The buffer stays valid until the next call.
+    const float* render(uint32_t frames);
+
+    bool is_smoothing() const { return frames_left > 0; }
+    float get_value() const { return value; }
+    float get_target() const { return target; }
+
+    protected:
+    std::vector<float> buffer;
+    uint32_t settled_frames = 0; // leading buffer entries already equal to value
+
+    float value = 0;
+    float target = 0;
+    float step = 0;
+    uint32_t frames_left = 0;
+    uint32_t ramp_frames = 1;
+};
@@ -0,0 +1,150 @@
+/*
+reverb.cpp
+Feedback delay network reverb for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "reverb.hpp"
+#include "kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Reverb::Reverb() {
+    update_lengths();
+    update_gains();
+    std::fill(positions, positions + max_lines, 0);
+    std::fill(lowpass, lowpass + max_lines, 0.f);
+}
+
+void Reverb::allocate(double sample_rate_in) {
+    sample_rate = sample_rate_in;
+    // update_lengths() can push the longest line a couple of frames past max_delay_s
+    capacity = uint32_t(std::ceil(max_delay_s*sample_rate)) + 2*max_lines;
+    storage.assign(size_t(max_lines)*capacity, 0);
+    update_lengths();
+    update_gains();
+    clear();
+}
+
+void Reverb::free_storage() {
+    std::vector<float>().swap(storage);
+    capacity = 0;
+}
+
+void Reverb::clear() {
+    std::fill(storage.begin(), storage.end(), 0.f);
+    std::fill(positions, positions + max_lines, 0);
+    std::fill(lowpass, lowpass + max_lines, 0.f);
+}
+
+void Reverb::set_parameters(uint32_t line_count_in, float size_in, float decay_s_in, float damping_in) {
+    const uint32_t new_line_count = (line_count_in >= max_lines) ? max_lines : 8;
+    const float new_size = std::clamp(size_in, 0.f, 1.f);
+    if (new_line_count != line_count || new_size != size) {
+        line_count = new_line_count;
+        size = new_size;
+        update_lengths();
+        clear();
+    }
+    decay_s = std::max(0.05f, decay_s_in);
+    damping = std::clamp(damping_in, 0.f, 1.f);
+    update_gains();
+}
+
+void Reverb::update_lengths() {
+    // Spread geometrically over a factor of 3, and odd, so the lines' echoes rarely land on the same frame
+    const double shortest = 0.005*std::pow(8.0, double(size))*sample_rate;
+    uint32_t previous = 0;
+    double total_length = 0;
+    for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+        uint32_t length = uint32_t(std::lround(shortest*std::pow(3.0, double(l_idx)/(line_count - 1)))) | 1;
+        length = std::max({length, previous + 2, chunk_frames + 1});
+        if (capacity > 0) {
+            length = std::min(length, capacity);
+        }
+        lengths[l_idx] = length;
+        previous = length;
+        total_length += length;
+    }
+    // Longer lines come back around less often, so the tail would get quieter as the size goes up. About as loud as
+    // the input at full level with the default decay.
+    output_gain = float(std::sqrt(150*total_length/(line_count*sample_rate)));
+}
+
+void Reverb::update_gains() {
+    // -60 dB over decay_s: each trip of `length` frames around a line takes off 60*length/(decay_s*sample_rate) dB
+    const float matrix_gain = 1/std::sqrt(float(line_count));
+    for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+        gains[l_idx] = matrix_gain*float(std::pow(10.0, -3.0*lengths[l_idx]/(decay_s*sample_rate)));
+    }
+    // the lowpass corner falls six octaves from just below nyquist as damping goes from 0 to 1
+    const double corner_hz = 0.45*sample_rate*std::exp2(-6.0*damping);
+    lowpass_coefficient = float(1 - std::exp(-2*M_PI*corner_hz/sample_rate));
+}
+
+uint32_t Reverb::get_tail_frames() const {
+    return uint32_t(std::ceil(decay_s*sample_rate*100/60)) + lengths[line_count - 1];
+}
+
+void Reverb::process(float* left, float* right, uint32_t frames, const float* wet_gains) {
+    if (storage.empty()) {
+        return;
+    }
+    float line_buffers[max_lines][chunk_frames];
+    float* lines[max_lines];
+    float wet_left[chunk_frames];
+    float wet_right[chunk_frames];
+    for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+        lines[l_idx] = line_buffers[l_idx];
+    }
+    for (uint32_t done = 0; done < frames; done += chunk_frames) {
+        const uint32_t chunk = std::min(chunk_frames, frames - done);
+
+        // read the oldest frames of each line, through its lowpass and gain
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            const float* line = storage.data() + size_t(l_idx)*capacity;
+            uint32_t position = positions[l_idx];
+            float state = lowpass[l_idx];
+            for (uint32_t f_idx = 0; f_idx < chunk; ++f_idx) {
+                state += lowpass_coefficient*(line[position] - state);
+                line_buffers[l_idx][f_idx] = gains[l_idx]*state;
+                position = (position + 1 == lengths[l_idx]) ? 0 : position + 1;
+            }
+            lowpass[l_idx] = state;
+        }
+
+        mix_feedback_lines(lines, line_count, chunk, left + done, right + done, wet_left, wet_right);
+
+        // and write what goes back in over them
+        for (uint32_t l_idx = 0; l_idx < line_count; ++l_idx) {
+            float* line = storage.data() + size_t(l_idx)*capacity;
+            const uint32_t position = positions[l_idx];
+            const uint32_t before_wrap = std::min(chunk, lengths[l_idx] - position);
+            std::memcpy(line + position, line_buffers[l_idx], sizeof(float)*before_wrap);
+            std::memcpy(line, line_buffers[l_idx] + before_wrap, sizeof(float)*(chunk - before_wrap));
+            positions[l_idx] = (position + chunk < lengths[l_idx]) ? position + chunk : position + chunk - lengths[l_idx];
+        }
+
+        for (uint32_t f_idx = 0; f_idx < chunk; ++f_idx) {
+            const float gain = output_gain*wet_gains[done + f_idx];
+            left[done + f_idx] += gain*wet_left[f_idx];
+            right[done + f_idx] += gain*wet_right[f_idx];
+        }
+    }
+}
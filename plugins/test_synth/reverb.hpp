@@ -0,0 +1,72 @@
+/*
+reverb.hpp
+Feedback delay network reverb for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class Reverb {
+    // Stereo feedback delay network: 8 or 16 delay lines of different lengths, each through a one-pole lowpass and a
+    // gain that takes it down 60 dB in the decay time, feeding back into each other through a Hadamard matrix.
+    // Left goes into the even lines and right into the odd ones, and they come back out the same way, so the tail
+    // is wide even from a mono input. Lines are at least chunk_frames long, so a whole chunk of every line can be
+    // read before any of it is written back, and mix_feedback_lines() (see kernels.hpp) mixes the chunk at once.
+    public:
+    static const uint32_t max_lines = 16;
+    static const uint32_t chunk_frames = 64;
+    static constexpr float max_delay_s = 0.12f; // longest line at the largest size
+
+    Reverb();
+
+    void allocate(double sample_rate_in); // room for max_lines lines at the largest size; not RT safe. Clears the lines.
+    void free_storage();
+    void clear(); // silence the tail
+
+    // Only between blocks. line_count is 8 or max_lines, and size goes from 0 (5 to 15 ms lines) to 1 (40 to 120 ms).
+    // Changing either of them clears the tail, so they're settings rather than something to automate.
+    void set_parameters(uint32_t line_count_in, float size_in, float decay_s_in, float damping_in);
+
+    // Host frames after the input goes silent until the tail is 100 dB down
+    uint32_t get_tail_frames() const;
+
+    // Add the reverb of left and right, times wet_gains[f], back into left and right
+    void process(float* left, float* right, uint32_t frames, const float* wet_gains);
+
+    protected:
+    void update_lengths();
+    void update_gains();
+
+    std::vector<float> storage; // max_lines lines of capacity frames each
+    uint32_t capacity = 0;
+    double sample_rate = 48000;
+
+    uint32_t line_count = max_lines;
+    float size = 0.5f;
+    float decay_s = 2;
+    float damping = 0.5f;
+
+    uint32_t lengths[max_lines];     // in frames; each line is a ring of exactly this many
+    uint32_t positions[max_lines];   // where the oldest frame is read and the newest written
+    float gains[max_lines];          // decay per trip around the line, and the matrix's 1/sqrt(line_count)
+    float lowpass[max_lines];        // each line's filter state
+    float lowpass_coefficient = 1;
+    float output_gain = 1;
+};
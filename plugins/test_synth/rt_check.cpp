@@ -0,0 +1,196 @@
+/*
+rt_check.cpp
+Real-time safety checks for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "rt_check.hpp"
+
+#if ENABLE_RT_CHECK
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#endif
+
+// A plain counter, so reading it can't allocate, or take a lock, itself
+static thread_local uint32_t realtime_depth = 0;
+
+Realtime_Scope::Realtime_Scope() {
+    ++realtime_depth;
+}
+
+Realtime_Scope::~Realtime_Scope() {
+    --realtime_depth;
+}
+
+static void check_realtime(const char* function) {
+    if (realtime_depth == 0) {
+        return;
+    }
+    realtime_depth = 0; // printing may allocate, and that shouldn't report again
+    std::fprintf(stderr, "test_synth: %s called on a real-time thread (inside TestSynth::run() or a voice worker)\n", function);
+    std::abort();
+}
+
+static void* allocate_aligned(std::size_t size, std::size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignment);
+#else
+    void* memory = nullptr;
+    return (posix_memalign(&memory, alignment, size) == 0) ? memory : nullptr;
+#endif
+}
+
+static void free_aligned(void* memory) {
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+// The array and nothrow forms call these by default
+void* operator new(std::size_t size) {
+    check_realtime("operator new");
+    void* memory = std::malloc((size > 0) ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    check_realtime("operator new");
+    void* memory = allocate_aligned((size > 0) ? size : 1, std::size_t(alignment));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr) {
+        check_realtime("operator delete");
+    }
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    if (memory != nullptr) {
+        check_realtime("operator delete");
+    }
+    free_aligned(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    ::operator delete(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    ::operator delete(memory, alignment);
+}
+
+#if defined(__GLIBC__)
+// Everything else in the process allocates through these, including C libraries and the C++ runtime. glibc exports
+// its own versions under these names for exactly this.
+extern "C" {
+void* __libc_malloc(size_t size);
+void __libc_free(void* memory);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* memory, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) noexcept {
+    check_realtime("malloc");
+    return __libc_malloc(size);
+}
+
+void free(void* memory) noexcept {
+    if (memory != nullptr) {
+        check_realtime("free");
+    }
+    __libc_free(memory);
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    check_realtime("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* memory, size_t size) noexcept {
+    check_realtime("realloc");
+    return __libc_realloc(memory, size);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    check_realtime("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    check_realtime("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memory, size_t alignment, size_t size) noexcept {
+    check_realtime("posix_memalign");
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return 22; // EINVAL
+    }
+    *memory = __libc_memalign(alignment, size);
+    return (*memory != nullptr) ? 0 : 12; // ENOMEM
+}
+}
+
+// Only resolved the first time each is called, so looking them up never happens inside a Realtime_Scope that
+// wouldn't have aborted anyway
+template <typename Function>
+static Function* find_next(std::atomic<Function*>& next, const char* name) {
+    Function* function = next.load(std::memory_order_acquire);
+    if (function == nullptr) {
+        function = reinterpret_cast<Function*>(dlsym(RTLD_NEXT, name));
+        next.store(function, std::memory_order_release);
+    }
+    return function;
+}
+
+extern "C" {
+int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept {
+    check_realtime("pthread_mutex_lock");
+    static std::atomic<int (*)(pthread_mutex_t*)> next{nullptr};
+    return find_next(next, "pthread_mutex_lock")(mutex);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock) noexcept {
+    check_realtime("pthread_rwlock_rdlock");
+    static std::atomic<int (*)(pthread_rwlock_t*)> next{nullptr};
+    return find_next(next, "pthread_rwlock_rdlock")(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock) noexcept {
+    check_realtime("pthread_rwlock_wrlock");
+    static std::atomic<int (*)(pthread_rwlock_t*)> next{nullptr};
+    return find_next(next, "pthread_rwlock_wrlock")(lock);
+}
+}
+#endif // __GLIBC__
+#endif // ENABLE_RT_CHECK
@@ -0,0 +1,46 @@
+/*
+rt_check.hpp
+Real-time safety checks for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Build with `make RT_CHECK=true` to enable. When disabled, Realtime_Scope is an empty class, so none of this costs
+// anything.
+#ifndef ENABLE_RT_CHECK
+#define ENABLE_RT_CHECK 0
+#endif
+
+class Realtime_Scope {
+    // While one is in scope on a thread, allocating or freeing memory or locking a mutex on that thread prints what was
+    // called and aborts, so a debugger or core dump shows where. The check build replaces operator new and delete, and
+    // with glibc also malloc and friends and pthread_mutex_lock and the rwlock locks, for the whole process; that
+    // only works in an executable, so it builds just the JACK standalone and the benchmark.
+    // Waiting on a futex or spinning isn't caught; the worker pool does both on purpose.
+    public:
+#if ENABLE_RT_CHECK
+    Realtime_Scope();
+    ~Realtime_Scope();
+    Realtime_Scope(const Realtime_Scope&) = delete;
+    Realtime_Scope& operator=(const Realtime_Scope&) = delete;
+#else
+    Realtime_Scope() {}
+#endif
+};
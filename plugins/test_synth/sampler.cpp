@@ -0,0 +1,626 @@
+/*
+sampler.cpp
+Disk-streaming sample playback for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "sampler.hpp"
+#include "address_wait.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+// WAV files: http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
+// Everything is little-endian, and read a byte at a time so the mapping needs no alignment.
+
+static uint16_t read_u16(const uint8_t* bytes) {
+    return uint16_t(bytes[0] | (bytes[1] << 8));
+}
+static uint32_t read_u32(const uint8_t* bytes) {
+    return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+static bool parse_wav(const Mapped_File& file, Sample_Region& region) {
+    const uint8_t* data = file.get_data();
+    const size_t size = file.get_size();
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    bool have_format = false;
+    uint16_t format_tag = 0;
+    uint16_t bits = 0;
+    for (size_t offset = 12; offset + 8 <= size;) {
+        const uint32_t chunk_size = read_u32(data + offset + 4);
+        const size_t body = offset + 8;
+        if (std::memcmp(data + offset, "fmt ", 4) == 0 && chunk_size >= 16 && body + chunk_size <= size) {
+            format_tag = read_u16(data + body);
+            region.channels = read_u16(data + body + 2);
+            region.sample_rate = float(read_u32(data + body + 4));
+            region.frame_bytes = read_u16(data + body + 12);
+            bits = read_u16(data + body + 14);
+            if (format_tag == 0xfffe && chunk_size >= 26) {
+                format_tag = read_u16(data + body + 24); // WAVE_FORMAT_EXTENSIBLE: the sub-format GUID starts with the tag
+            }
+            have_format = true;
+        } else if (std::memcmp(data + offset, "data", 4) == 0 && have_format) {
+            if (region.channels == 0 || region.sample_rate <= 0 || region.frame_bytes != region.channels*(bits/8)) {
+                return false;
+            }
+            if (format_tag == 1 && bits == 16) {
+                region.format = Sample_Format::int16;
+            } else if (format_tag == 1 && bits == 24) {
+                region.format = Sample_Format::int24;
+            } else if (format_tag == 1 && bits == 32) {
+                region.format = Sample_Format::int32;
+            } else if (format_tag == 3 && bits == 32) {
+                region.format = Sample_Format::float32;
+            } else {
+                return false;
+            }
+            // a file that was cut short claims more data than it has; play what's there
+            const size_t bytes = std::min(size_t(chunk_size), size - body);
+            region.data_offset = body;
+            region.frames = uint32_t(bytes/region.frame_bytes);
+            return region.frames > 0;
+        }
+        offset = body + chunk_size + (chunk_size & 1); // chunks are padded to an even size
+    }
+    return false;
+}
+
+// Mix each frame's channels down to their mean
+template <typename Decode>
+static void mix_down(const uint8_t* in, uint32_t count, uint32_t channels, uint32_t frame_bytes, uint32_t sample_bytes, float* out, Decode decode) {
+    const float scale = 1.f/channels;
+    for (uint32_t f_idx = 0; f_idx < count; ++f_idx) {
+        float sum = 0;
+        for (uint32_t c_idx = 0; c_idx < channels; ++c_idx) {
+            sum += decode(in + c_idx*sample_bytes);
+        }
+        out[f_idx] = sum*scale;
+        in += frame_bytes;
+    }
+}
+
+void Sample_Region::read_frames(uint32_t first, uint32_t count, float* out) const {
+    const uint8_t* in = file->get_data() + data_offset + size_t(first)*frame_bytes;
+    switch (format) {
+    case Sample_Format::int16:
+        mix_down(in, count, channels, frame_bytes, 2, out, [](const uint8_t* bytes) { return int16_t(read_u16(bytes))*(1.f/32768); });
+        break;
+    case Sample_Format::int24:
+        mix_down(in, count, channels, frame_bytes, 3, out, [](const uint8_t* bytes) {
+            return int32_t((uint32_t(bytes[0]) << 8) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 24))*(1.f/2147483648.f);
+        });
+        break;
+    case Sample_Format::int32:
+        mix_down(in, count, channels, frame_bytes, 4, out, [](const uint8_t* bytes) { return int32_t(read_u32(bytes))*(1.f/2147483648.f); });
+        break;
+    case Sample_Format::float32:
+        mix_down(in, count, channels, frame_bytes, 4, out, [](const uint8_t* bytes) {
+            const uint32_t word = read_u32(bytes);
+            float value;
+            std::memcpy(&value, &word, sizeof(value));
+            return value;
+        });
+        break;
+    }
+}
+
+// SFZ files: https://sfzformat.com/
+// Opcodes are name=value pairs under a <header>. A value runs up to the next opcode, header, comment or line break,
+// so sample paths can have spaces in them. Comments are // to the end of the line, or between /* and */.
+
+typedef std::map<std::string, std::string> Sfz_Opcodes;
+typedef std::pair<std::string, std::string> Sfz_Token; // a header, with no value, or an opcode
+
+static bool is_opcode_start(const std::string& text, size_t pos) {
+    size_t end = pos;
+    while (end < text.size() && (std::isalnum(static_cast<unsigned char>(text[end])) || text[end] == '_')) {
+        ++end;
+    }
+    return end > pos && end < text.size() && text[end] == '=';
+}
+
+static void tokenize_sfz(const std::string& text, std::vector<Sfz_Token>& tokens) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        if (std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        } else if (text.compare(pos, 2, "//") == 0) {
+            pos = std::min(text.find('\n', pos), text.size());
+        } else if (text.compare(pos, 2, "/*") == 0) {
+            const size_t end = text.find("*/", pos + 2);
+            pos = (end == std::string::npos) ? text.size() : end + 2;
+        } else if (text[pos] == '<') {
+            const size_t end = text.find('>', pos);
+            if (end == std::string::npos) {
+                return;
+            }
+            tokens.emplace_back(text.substr(pos, end + 1 - pos), std::string());
+            pos = end + 1;
+        } else if (is_opcode_start(text, pos)) {
+            const size_t equals = text.find('=', pos);
+            size_t end = equals + 1;
+            while (end < text.size() && text[end] != '\n' && text[end] != '\r' && text[end] != '<' && text.compare(end, 2, "//") != 0
+                   && !(std::isspace(static_cast<unsigned char>(text[end - 1])) && is_opcode_start(text, end))) {
+                ++end;
+            }
+            size_t value_end = end;
+            while (value_end > equals + 1 && std::isspace(static_cast<unsigned char>(text[value_end - 1]))) {
+                --value_end;
+            }
+            tokens.emplace_back(text.substr(pos, equals - pos), text.substr(equals + 1, value_end - equals - 1));
+            pos = end;
+        } else {
+            // not something we understand; skip the word
+            while (pos < text.size() && !std::isspace(static_cast<unsigned char>(text[pos]))) {
+                ++pos;
+            }
+        }
+    }
+}
+
+static const std::string* find_opcode(const Sfz_Opcodes& opcodes, const char* name) {
+    const auto found = opcodes.find(name);
+    return (found == opcodes.end()) ? nullptr : &found->second;
+}
+
+// A MIDI note number, or a note name like c4, f#3 or eb-1, with c4 = 60
+static int32_t parse_key(const std::string* value, int32_t fallback) {
+    if (value == nullptr || value->empty()) {
+        return fallback;
+    }
+    const char* text = value->c_str();
+    char* end;
+    const long number = strtol(text, &end, 10);
+    if (end != text) {
+        return int32_t(std::clamp(number, 0L, 127L));
+    }
+
+    static const int32_t letter_semitones[] = {9, 11, 0, 2, 4, 5, 7}; // a to g
+    const char letter = char(std::tolower(static_cast<unsigned char>(text[0])));
+    if (letter < 'a' || letter > 'g') {
+        return fallback;
+    }
+    int32_t semitone = letter_semitones[letter - 'a'];
+    const char* octave_text = text + 1;
+    if (*octave_text == '#') {
+        ++semitone;
+        ++octave_text;
+    } else if (*octave_text == 'b') {
+        --semitone;
+        ++octave_text;
+    }
+    const long octave = strtol(octave_text, &end, 10);
+    if (end == octave_text) {
+        return fallback;
+    }
+    return int32_t(std::clamp((octave + 1)*12 + semitone, 0L, 127L));
+}
+
+static float parse_number(const std::string* value, float fallback) {
+    if (value == nullptr) {
+        return fallback;
+    }
+    char* end;
+    const float number = strtof(value->c_str(), &end);
+    return (end == value->c_str()) ? fallback : number;
+}
+
+static bool is_absolute_path(const std::string& path) {
+    return (!path.empty() && path[0] == '/') || (path.size() > 1 && path[1] == ':');
+}
+
+// Sample_Library
+
+bool Sample_Library::load_sfz(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    std::vector<Sfz_Token> tokens;
+    tokenize_sfz(text.str(), tokens);
+
+    // samples are relative to the SFZ file
+    std::string directory = path;
+    const size_t separator = directory.find_last_of("/\\");
+    directory = (separator == std::string::npos) ? std::string() : directory.substr(0, separator + 1);
+
+    enum class Level { none, control, global, group, region } level = Level::none;
+    std::string default_path;
+    Sfz_Opcodes global, group, region;
+    std::map<std::string, const Mapped_File*> mapped;
+    auto finish_region = [&]() {
+        Sfz_Opcodes opcodes = global;
+        for (const auto& opcode : group) opcodes[opcode.first] = opcode.second;
+        for (const auto& opcode : region) opcodes[opcode.first] = opcode.second;
+        const std::string* sample = find_opcode(opcodes, "sample");
+        if (sample != nullptr) {
+            add_region(opcodes, directory, default_path + *sample, mapped);
+        }
+    };
+
+    for (const Sfz_Token& token : tokens) {
+        if (token.first[0] == '<') {
+            if (level == Level::region) {
+                finish_region();
+            }
+            if (token.first == "<control>") {
+                level = Level::control;
+            } else if (token.first == "<global>") {
+                level = Level::global;
+                global.clear();
+                group.clear();
+            } else if (token.first == "<group>") {
+                level = Level::group;
+                group.clear();
+            } else if (token.first == "<region>") {
+                level = Level::region;
+                region.clear();
+            } else {
+                level = Level::none; // opcodes under headers we don't know are ignored
+            }
+            continue;
+        }
+        switch (level) {
+        case Level::control:
+            if (token.first == "default_path") {
+                default_path = token.second;
+            }
+            break;
+        case Level::global:
+            global[token.first] = token.second;
+            break;
+        case Level::group:
+            group[token.first] = token.second;
+            break;
+        case Level::region:
+            region[token.first] = token.second;
+            break;
+        case Level::none:
+            break;
+        }
+    }
+    if (level == Level::region) {
+        finish_region();
+    }
+
+    for (uint32_t r_idx = 0; r_idx < regions.size(); ++r_idx) {
+        for (uint32_t key = regions[r_idx].low_key; key <= regions[r_idx].high_key; ++key) {
+            key_regions[key].push_back(r_idx);
+        }
+    }
+    return !regions.empty();
+}
+
+void Sample_Library::add_region(const Sfz_Opcodes& opcodes, const std::string& directory, std::string sample_path, std::map<std::string, const Mapped_File*>& mapped) {
+    std::replace(sample_path.begin(), sample_path.end(), '\\', '/');
+    if (!is_absolute_path(sample_path)) {
+        sample_path = directory + sample_path;
+    }
+    const Mapped_File* sample_file = nullptr;
+    const auto found = mapped.find(sample_path);
+    if (found != mapped.end()) {
+        sample_file = found->second;
+    } else {
+        std::unique_ptr<Mapped_File> new_file(new Mapped_File());
+        if (new_file->open(sample_path.c_str())) {
+            sample_file = new_file.get();
+            files.push_back(std::move(new_file));
+        }
+        mapped[sample_path] = sample_file; // don't try a missing file again
+    }
+    if (sample_file == nullptr) {
+        return;
+    }
+
+    Sample_Region new_region = {};
+    new_region.file = sample_file;
+    if (!parse_wav(*sample_file, new_region)) {
+        return;
+    }
+    const int32_t key = parse_key(find_opcode(opcodes, "key"), -1);
+    new_region.low_key = uint8_t(parse_key(find_opcode(opcodes, "lokey"), key >= 0 ? key : 0));
+    new_region.high_key = uint8_t(parse_key(find_opcode(opcodes, "hikey"), key >= 0 ? key : 127));
+    new_region.low_velocity = uint8_t(std::clamp(parse_number(find_opcode(opcodes, "lovel"), 0), 0.f, 127.f));
+    new_region.high_velocity = uint8_t(std::clamp(parse_number(find_opcode(opcodes, "hivel"), 127), 0.f, 127.f));
+    const int32_t root_key = parse_key(find_opcode(opcodes, "pitch_keycenter"), key >= 0 ? key : 60);
+    const float tune_ct = parse_number(find_opcode(opcodes, "tune"), 0);
+    new_region.root_frequency = Voice_Pool::get_frequency_from_note_number(uint8_t(root_key))*std::exp2(-tune_ct/1200);
+    new_region.gain = std::pow(10.f, parse_number(find_opcode(opcodes, "volume"), 0)/20);
+    if (new_region.low_key > new_region.high_key) {
+        return;
+    }
+
+    // the head is all the audio thread ever reads from the file, so give its pages back once it's copied
+    new_region.head_count = std::min(new_region.frames, head_frames);
+    new_region.head.assign(new_region.head_count + 3, 0.f);
+    new_region.read_frames(0, new_region.head_count, new_region.head.data() + 1);
+    sample_file->dont_need(new_region.data_offset, size_t(new_region.head_count)*new_region.frame_bytes);
+    regions.push_back(std::move(new_region));
+}
+
+int32_t Sample_Library::find_region(uint8_t note_number, uint8_t velocity) const {
+    for (uint32_t r_idx : key_regions[note_number & 0x7f]) {
+        if (velocity >= regions[r_idx].low_velocity && velocity <= regions[r_idx].high_velocity) {
+            return int32_t(r_idx);
+        }
+    }
+    return -1;
+}
+
+// Sample_Streamer
+
+static const Sample_Library empty_library = Sample_Library(); // what plays before anything is loaded, and after unload()
+
+static void free_library(const Sample_Library* library) {
+    if (library != &empty_library) {
+        delete library;
+    }
+}
+
+// 4-point, 3rd-order Hermite interpolation between x1 and x2
+static inline float hermite(float x0, float x1, float x2, float x3, float t) {
+    const float c1 = 0.5f*(x2 - x0);
+    const float c2 = x0 - 2.5f*x1 + 2*x2 - 0.5f*x3;
+    const float c3 = 0.5f*(x3 - x0) + 1.5f*(x1 - x2);
+    return ((c3*t + c2)*t + c1)*t + x1;
+}
+
+// `frame` returns the region's frame at an index, which can be one before the frames the span plays and two after
+template <typename Frame>
+static void interpolate(float* out, uint32_t frames, uint64_t& position, uint64_t rate, float amplitude, float amplitude_step, Frame frame) {
+    for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+        const int64_t index = int64_t(position >> 32);
+        const float t = float(uint32_t(position))*(1.f/4294967296.f);
+        out[f_idx] += amplitude*hermite(frame(index - 1), frame(index), frame(index + 1), frame(index + 2), t);
+        position += rate;
+        amplitude += amplitude_step;
+    }
+}
+
+Sample_Streamer::Sample_Streamer() : stream_count(0), active(&empty_library), pending(nullptr), retired(nullptr), running(false), wake_generation(0), prefetcher_sleeping(false), underruns(0) {}
+
+Sample_Streamer::~Sample_Streamer() {
+    stop();
+    free_library(active.load());
+    free_library(pending.exchange(nullptr));
+    free_library(retired.exchange(nullptr));
+}
+
+void Sample_Streamer::start(uint32_t max_voices) {
+    stop();
+    streams.reset(new Stream[max_voices]);
+    stream_count = max_voices;
+    rings.assign(size_t(max_voices)*ring_frames, 0);
+    underruns.store(0);
+    running.store(true);
+    prefetcher = std::thread(&Sample_Streamer::prefetch_main, this);
+}
+
+void Sample_Streamer::stop() {
+    if (!prefetcher.joinable()) {
+        return;
+    }
+    running.store(false);
+    wake_prefetcher();
+    prefetcher.join();
+    free_library(retired.exchange(nullptr));
+    streams.reset();
+    stream_count = 0;
+    rings = std::vector<float>();
+}
+
+bool Sample_Streamer::load_sfz(const char* path) {
+    Sample_Library* library = new Sample_Library();
+    if (!library->load_sfz(path)) {
+        delete library;
+        return false;
+    }
+    publish(library);
+    return true;
+}
+
+void Sample_Streamer::unload() {
+    publish(&empty_library);
+}
+
+void Sample_Streamer::publish(const Sample_Library* library) {
+    // a library the audio thread never picked up can be freed straight away
+    free_library(pending.exchange(library, std::memory_order_acq_rel));
+}
+
+void Sample_Streamer::update() {
+    // only take a new library once the prefetch thread has freed the last one we retired
+    if (retired.load(std::memory_order_acquire) != nullptr) {
+        return;
+    }
+    const Sample_Library* library = pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (library == nullptr) {
+        return;
+    }
+    const Sample_Library* old_library = active.load(std::memory_order_relaxed);
+    active.store(library, std::memory_order_release);
+
+    // Stop every stream, so no request points into the old library. The prefetch thread sees the stops before it
+    // sees the retired library, and checks each request's generation, so it never reads a region after freeing it.
+    for (uint32_t s_idx = 0; s_idx < stream_count; ++s_idx) {
+        Stream& stream = streams[s_idx];
+        stream.region = nullptr;
+        stream.generation += 1;
+        stream.request.store(uint64_t(stream.generation) << 32, std::memory_order_release);
+    }
+    retired.store(old_library, std::memory_order_release);
+    wake_prefetcher(); // to free it
+}
+
+void Sample_Streamer::start_note(Stream& stream, Voice_Pool& voices, uint32_t voice) {
+    const Sample_Library* library = active.load(std::memory_order_relaxed);
+    const int32_t region = library->find_region(voices.note_number[voice], uint8_t(std::lround(voices.velocity[voice]*127)));
+    stream.started = true;
+    stream.start_order = voices.start_order[voice];
+    stream.region = (region >= 0) ? &library->get_region(region) : nullptr;
+    stream.position = 0;
+
+    // needed_from goes back to the start before the new request is published, so the prefetch thread never pairs the
+    // new request with the old note's position
+    stream.generation += 1;
+    stream.needed_from.store(0, std::memory_order_relaxed);
+    stream.request.store((uint64_t(stream.generation) << 32) | uint32_t(region + 1), std::memory_order_release);
+    if (stream.region != nullptr && stream.region->head_count < stream.region->frames) {
+        wake_prefetcher();
+    }
+}
+
+void Sample_Streamer::render(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t rate_increment, float amplitude, float amplitude_step) {
+    if (voice >= stream_count || frames == 0) {
+        return;
+    }
+    Stream& stream = streams[voice];
+    if (!stream.started || stream.start_order != voices.start_order[voice]) {
+        start_note(stream, voices, voice);
+    }
+    const Sample_Region* region = stream.region;
+    if (region == nullptr || (stream.position >> 32) >= region->frames) {
+        return;
+    }
+
+    // frames from the head are always there; the ones after it are once the prefetch thread has filled them for this note
+    const float* head = region->head.data() + 1; // from frame -1
+    const float* ring = rings.data() + size_t(voice)*ring_frames;
+    const int64_t head_count = int64_t(region->head_count);
+    const int64_t region_frames = int64_t(region->frames);
+    const int64_t head_end = (head_count == region_frames) ? head_count + 2 : head_count; // including the silence
+    const uint64_t filled = stream.filled.load(std::memory_order_acquire);
+    const int64_t readable = (uint32_t(filled >> 32) == stream.generation) ? std::max(int64_t(uint32_t(filled)), head_count) : head_count;
+
+    const uint64_t rate = uint64_t(std::llround(double(rate_increment)*region->sample_rate/region->root_frequency)); // 32.32, like position
+    amplitude *= region->gain;
+    amplitude_step *= region->gain;
+
+    // whole spans inside the head or the filled part of the ring skip the checks
+    const int64_t first = int64_t(stream.position >> 32) - 1;
+    const int64_t last = int64_t((stream.position + rate*(frames - 1)) >> 32) + 2;
+    bool starved = false;
+    if (first >= -1 && last < head_end) {
+        interpolate(out, frames, stream.position, rate, amplitude, amplitude_step, [head](int64_t index) { return head[index]; });
+    } else if (first >= head_count && last < readable) {
+        interpolate(out, frames, stream.position, rate, amplitude, amplitude_step, [ring](int64_t index) { return ring[index & (ring_frames - 1)]; });
+    } else {
+        interpolate(out, frames, stream.position, rate, amplitude, amplitude_step, [&](int64_t index) {
+            if (index < 0 || index >= region_frames) {
+                return 0.f;
+            } else if (index < head_count) {
+                return head[index];
+            } else if (index < readable) {
+                return ring[index & (ring_frames - 1)];
+            }
+            starved = true;
+            return 0.f;
+        });
+    }
+
+    // the frame before the playhead is the oldest the next block can read
+    const uint32_t needed_from = uint32_t(std::min(std::max(int64_t(stream.position >> 32) - 1, int64_t(0)), region_frames));
+    const uint32_t last_needed_from = stream.needed_from.load(std::memory_order_relaxed); // only this thread stores it
+    stream.needed_from.store(needed_from, std::memory_order_release);
+    // once a chunk's worth of the ring has been played, there's room for the prefetch thread to copy another
+    if (region_frames > head_count && needed_from/prefetch_frames != last_needed_from/prefetch_frames) {
+        wake_prefetcher();
+    }
+    if (starved) {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Sample_Streamer::wake_prefetcher() {
+    // Either this sees prefetcher_sleeping and wakes it, or its wait sees the new generation and doesn't sleep
+    wake_generation.fetch_add(1);
+    if (prefetcher_sleeping.load()) {
+        wake_address(wake_generation);
+    }
+}
+
+void Sample_Streamer::prefetch_main() {
+    while (running.load(std::memory_order_acquire)) {
+        // anything woken for after this is seen by the pass below, or stops the wait from sleeping
+        const uint32_t generation = wake_generation.load();
+        free_library(retired.exchange(nullptr, std::memory_order_acq_rel));
+
+        // a chunk per voice at a time, so one fast voice can't hold up the others
+        bool busy = false;
+        for (uint32_t s_idx = 0; s_idx < stream_count; ++s_idx) {
+            busy |= prefetch(streams[s_idx], rings.data() + size_t(s_idx)*ring_frames);
+        }
+        if (!busy) {
+            prefetcher_sleeping.store(true);
+            if (running.load()) {
+                wait_on_address(wake_generation, generation);
+            }
+            prefetcher_sleeping.store(false);
+        }
+    }
+}
+
+bool Sample_Streamer::prefetch(Stream& stream, float* ring) {
+    const uint64_t request = stream.request.load(std::memory_order_acquire);
+    // Loaded after the request, so a request this library can't serve has already been abandoned by the audio thread
+    const Sample_Library* library = active.load(std::memory_order_acquire);
+    if (request != stream.fill_request) {
+        stream.fill_request = request;
+        stream.fill_end = 0;
+    }
+    const uint32_t region_slot = uint32_t(request);
+    if (region_slot == 0 || region_slot > library->get_region_count()) {
+        return false;
+    }
+    const Sample_Region& region = library->get_region(region_slot - 1);
+    const uint32_t head_count = region.head_count;
+    stream.fill_end = std::max(stream.fill_end, head_count);
+
+    // the ring holds ring_frames from the first frame the voice still needs; frames in the head never go in the ring
+    const uint64_t needed_from = std::max(stream.needed_from.load(std::memory_order_acquire), head_count);
+    const uint32_t limit = uint32_t(std::min(uint64_t(region.frames), needed_from + ring_frames));
+    if (stream.fill_end >= limit) {
+        return false;
+    }
+    const uint32_t count = std::min(limit - stream.fill_end, prefetch_frames);
+
+    // have the disk start on the next chunk while this one is converted
+    region.file->will_need(region.data_offset + size_t(stream.fill_end + count)*region.frame_bytes, size_t(prefetch_frames)*region.frame_bytes);
+    for (uint32_t done = 0; done < count;) {
+        const uint32_t slot = (stream.fill_end + done) & (ring_frames - 1);
+        const uint32_t piece = std::min(count - done, ring_frames - slot);
+        region.read_frames(stream.fill_end + done, piece, ring + slot);
+        done += piece;
+    }
+    region.file->dont_need(region.data_offset + size_t(stream.fill_end)*region.frame_bytes, size_t(count)*region.frame_bytes);
+
+    stream.fill_end += count;
+    stream.filled.store((request & 0xffffffff00000000ull) | stream.fill_end, std::memory_order_release);
+    return count == prefetch_frames;
+}
@@ -0,0 +1,163 @@
+/*
+sampler.hpp
+Disk-streaming sample playback for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "voices.hpp"
+
+enum class Sample_Format : uint8_t {
+    int16,
+    int24,
+    int32,
+    float32,
+};
+
+struct Sample_Region {
+    // One WAV file's samples and the keys and velocities they play for, from an SFZ <region>
+    const Mapped_File* file;
+    size_t data_offset;    // first frame, in bytes from the start of the file
+    uint32_t frames;
+    uint32_t channels;     // mixed down to mono as they're read
+    uint32_t frame_bytes;
+    Sample_Format format;
+    float sample_rate;
+    float root_frequency;  // Hz the sample plays back at its own speed, from pitch_keycenter= and tune=
+    float gain;            // from volume=
+    uint8_t low_key, high_key;
+    uint8_t low_velocity, high_velocity;
+    // The first Sample_Library::head_frames frames (all of a shorter sample), always in memory, after a frame of silence
+    // for the interpolator to start from, and followed by two more if the sample ends there
+    std::vector<float> head;
+    uint32_t head_count;   // frames of the sample in head
+
+    void read_frames(uint32_t first, uint32_t count, float* out) const; // from the mapped file, as mono float
+};
+
+class Sample_Library {
+    // Regions from an SFZ file over memory-mapped WAV files. Loading maps the files and copies the head of each region
+    // into memory; the rest stays on disk until a Sample_Streamer reads it. A loaded library never changes, so the
+    // audio thread and the prefetch thread share it without locks.
+    // Understood: the <control>, <global>, <group> and <region> headers, and sample=, default_path=, key=, lokey=,
+    // hikey=, pitch_keycenter=, lovel=, hivel=, volume= and tune=. Keys are numbers or names, with c4 = 60.
+    // WAV files can be 16, 24 or 32-bit PCM or 32-bit float, with any number of channels.
+    public:
+    static const uint32_t head_frames = 8192; // 32 KB per region; about 170 ms at 48 kHz for the prefetch thread to catch up
+
+    bool load_sfz(const char* path); // not RT safe; false if the file can't be read or has no playable regions
+
+    int32_t find_region(uint8_t note_number, uint8_t velocity) const; // the first region that plays the note, or -1
+    uint32_t get_region_count() const { return regions.size(); }
+    const Sample_Region& get_region(uint32_t index) const { return regions[index]; }
+
+    protected:
+    // Map the file (each path only once, through `mapped`) and add a region for it, unless it isn't a WAV file we can play
+    void add_region(const std::map<std::string, std::string>& opcodes, const std::string& directory, std::string sample_path, std::map<std::string, const Mapped_File*>& mapped);
+
+    std::vector<std::unique_ptr<Mapped_File>> files;
+    std::vector<Sample_Region> regions;
+    std::vector<uint32_t> key_regions[128]; // the regions each key plays, in file order
+};
+
+class Sample_Streamer {
+    // Plays a Sample_Library for the voices of a Voice_Pool without the audio thread ever touching the disk.
+    // A voice starts on its region's head, which is in memory, while a prefetch thread copies the frames after the head
+    // from the mapped file into the voice's ring buffer and keeps it filled ahead of the playhead. Each ring is a
+    // single-producer, single-consumer queue with atomic positions, and a ring that falls behind plays silence and
+    // counts an underrun rather than waiting. Memory is the heads plus ring_frames per voice, however big the files are.
+    // The prefetch thread sleeps until there's something to do: a note starting on a region that's longer than its head,
+    // a playhead moving on by prefetch_frames, or a library to free. With no library loaded, or another waveform
+    // selected, nothing wakes it, so an idle instance costs nothing.
+    // Libraries are handed over like Tuning's tables: loaded off the audio thread, picked up by update(), and freed by
+    // the prefetch thread once it can no longer be reading them.
+    public:
+    static const uint32_t ring_frames = 1 << 15;    // per voice; 128 KB
+    static const uint32_t prefetch_frames = 4096;   // most frames copied for one voice before moving on to the next
+
+    Sample_Streamer();
+    ~Sample_Streamer();
+
+    void start(uint32_t max_voices); // allocate the rings and start the prefetch thread; call from activate()
+    void stop();                     // call from deactivate()
+
+    // Not RT safe. Load an SFZ file and publish it; returns false, changing nothing, if the file can't be loaded.
+    bool load_sfz(const char* path);
+    void unload(); // publish an empty library; not RT safe
+
+    // RT safe. Called at the start of each block to pick up a newly loaded library; every voice goes quiet until its
+    // next note.
+    void update();
+
+    // RT safe. Add the voice's sample to out, starting it over if the voice has started a new note since the last call.
+    // rate_increment is the voice's phase increment (see kernels.hpp); the region plays at its own speed when that's the
+    // increment for its root frequency. Different voices can be rendered from different threads.
+    void render(float* out, uint32_t frames, Voice_Pool& voices, uint32_t voice, uint32_t rate_increment, float amplitude, float amplitude_step);
+
+    uint32_t get_underruns() const { return underruns.load(std::memory_order_relaxed); } // since start()
+
+    protected:
+    struct alignas(64) Stream {
+        // Shared. The audio thread asks for a region by storing request, and the prefetch thread answers through filled;
+        // both carry the audio thread's generation for the note, so neither reads what was meant for an older note.
+        std::atomic<uint64_t> request{0}; // generation << 32 | region index + 1, or 0 for no region
+        std::atomic<uint64_t> filled{0};  // generation << 32 | frames of the region readable from the head and ring
+        std::atomic<uint32_t> needed_from{0}; // first frame the voice can still read; anything before it can be overwritten
+
+        // audio thread
+        uint32_t generation = 0;
+        uint32_t start_order = 0; // Voice_Pool::start_order of the note being played
+        bool started = false;
+        const Sample_Region* region = nullptr;
+        uint64_t position = 0;    // in frames of the region, 32.32 fixed point
+
+        // prefetch thread
+        uint64_t fill_request = 0; // the request fill_end is for
+        uint32_t fill_end = 0;
+    };
+
+    void publish(const Sample_Library* library);
+    void start_note(Stream& stream, Voice_Pool& voices, uint32_t voice);
+    void prefetch_main();
+    void wake_prefetcher(); // RT safe, from any thread
+    bool prefetch(Stream& stream, float* ring); // true if it copied a whole chunk, so there may be more to do
+
+    std::unique_ptr<Stream[]> streams;
+    std::vector<float> rings; // ring_frames per voice
+    uint32_t stream_count;
+
+    std::atomic<const Sample_Library*> active;  // written by the audio thread, read by the prefetch thread
+    std::atomic<const Sample_Library*> pending; // published by the loader, taken by the audio thread
+    std::atomic<const Sample_Library*> retired; // handed back by the audio thread, freed by the prefetch thread
+
+    std::thread prefetcher;
+    std::atomic<bool> running;
+    std::atomic<uint32_t> wake_generation; // bumped by every wake; what the prefetch thread sleeps on
+    std::atomic<bool> prefetcher_sleeping;
+    std::atomic<uint32_t> underruns;
+};
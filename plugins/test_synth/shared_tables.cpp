@@ -0,0 +1,94 @@
+/*
+shared_tables.cpp
+Tables shared between instances of the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "shared_tables.hpp"
+
+#include <future>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+bool Table_Key::operator<(const Table_Key& other) const {
+    return std::tie(kind, sample_rate, parameters) < std::tie(other.kind, other.sample_rate, other.parameters);
+}
+
+struct Registry_Entry {
+    std::weak_ptr<const void> table; // weak, so the registry never keeps a table alive by itself
+    std::shared_future<std::shared_ptr<const void>> building; // valid while a thread is building the table
+};
+
+// Constructed on first use, so instances created during static initialisation still find it
+struct Registry_State {
+    std::mutex mutex;
+    std::map<Table_Key, Registry_Entry> entries;
+};
+static Registry_State& get_registry() {
+    static Registry_State registry;
+    return registry;
+}
+
+std::shared_ptr<const void> Table_Registry::acquire_any(const Table_Key& key, const std::function<std::shared_ptr<const void>()>& build) {
+    Registry_State& registry = get_registry();
+    std::unique_lock<std::mutex> lock(registry.mutex);
+    // map entries never move, and nothing erases one while it's building, so this stays valid without the lock
+    Registry_Entry& entry = registry.entries[key];
+    if (std::shared_ptr<const void> held = entry.table.lock()) {
+        return held;
+    }
+    if (entry.building.valid()) {
+        std::shared_future<std::shared_ptr<const void>> building = entry.building;
+        lock.unlock();
+        return building.get(); // rethrows if the build failed
+    }
+    std::promise<std::shared_ptr<const void>> built;
+    entry.building = built.get_future().share();
+    lock.unlock();
+
+    std::shared_ptr<const void> table;
+    try {
+        table = build();
+    } catch (...) {
+        lock.lock();
+        entry.building = {};
+        built.set_exception(std::current_exception());
+        throw;
+    }
+
+    lock.lock();
+    entry.table = table;
+    entry.building = {};
+    built.set_value(table);
+    // forget tables no one holds any more, e.g. for sample rates no longer in use
+    for (auto other = registry.entries.begin(); other != registry.entries.end();) {
+        const bool unused = other->second.table.expired() && !other->second.building.valid();
+        other = unused ? registry.entries.erase(other) : std::next(other);
+    }
+    return table;
+}
+
+size_t Table_Registry::get_table_count() {
+    Registry_State& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    size_t count = 0;
+    for (const auto& entry : registry.entries) {
+        count += entry.second.table.expired() ? 0 : 1;
+    }
+    return count;
+}
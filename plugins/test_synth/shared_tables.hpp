@@ -0,0 +1,56 @@
+/*
+shared_tables.hpp
+Tables shared between instances of the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct Table_Key {
+    // Everything a table is generated from, so two tables with equal keys are identical
+    std::string kind;               // what the table is, e.g. "saw wavetable"
+    double sample_rate = 0;         // 0 for tables that don't depend on it
+    std::vector<double> parameters; // anything else it's built from
+
+    bool operator<(const Table_Key& other) const;
+};
+
+class Table_Registry {
+    // Immutable tables shared by every instance in the process, so a session with many instances holds one copy of
+    // each and only the first activation builds it. Instances hold tables through shared_ptr, and a table is freed
+    // when the last one lets go, so that has to happen off the audio thread (in deactivate() or the destructor).
+    // The audio thread only ever reads tables through plain pointers.
+    public:
+    // Not RT safe. The table for key, calling build() (which returns a std::unique_ptr<Table>) if no one holds one.
+    // Builds run without the lock, so different tables can be built at once and a build can acquire other tables.
+    // Anyone asking for a table while it's being built waits for that build rather than starting another.
+    template <typename Table, typename Build>
+    static std::shared_ptr<const Table> acquire(const Table_Key& key, Build build) {
+        return std::static_pointer_cast<const Table>(acquire_any(key, [&build]() -> std::shared_ptr<const void> { return build(); }));
+    }
+
+    static size_t get_table_count(); // tables held by anyone right now
+
+    protected:
+    static std::shared_ptr<const void> acquire_any(const Table_Key& key, const std::function<std::shared_ptr<const void>()>& build);
+};
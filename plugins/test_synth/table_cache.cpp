@@ -0,0 +1,246 @@
+/*
+table_cache.cpp
+On-disk cache of precomputed tables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "table_cache.hpp"
+#include "mapped_file.hpp"
+
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+// File layout, in the machine's byte order
+struct Cache_Header {
+    char magic[8];          // "TSTABLE\0"
+    uint32_t format_version;
+    uint32_t key_bytes;     // the key follows the header
+    uint64_t float_count;   // the floats follow the key, at data_offset()
+    uint64_t checksum;      // of the key and the floats
+};
+static const char cache_magic[8] = {'T', 'S', 'T', 'A', 'B', 'L', 'E', 0};
+static const size_t data_alignment = 64;
+
+static size_t data_offset(uint32_t key_bytes) {
+    return (sizeof(Cache_Header) + key_bytes + data_alignment - 1)/data_alignment*data_alignment;
+}
+
+// FNV-1a; fast enough to check a table every time it's mapped, and catches truncated or overwritten files
+static uint64_t fnv1a(const void* bytes, size_t count, uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint8_t* byte = static_cast<const uint8_t*>(bytes);
+    for (size_t b_idx = 0; b_idx < count; ++b_idx) {
+        hash = (hash ^ byte[b_idx])*0x100000001b3ull;
+    }
+    return hash;
+}
+
+// The key as it's stored: kind length and characters, sample rate, then parameter count and parameters
+static std::string serialize_key(const Table_Key& key) {
+    std::string bytes;
+    auto append = [&bytes](const void* value, size_t size) { bytes.append(static_cast<const char*>(value), size); };
+    const uint32_t kind_length = uint32_t(key.kind.size());
+    append(&kind_length, sizeof(kind_length));
+    bytes += key.kind;
+    append(&key.sample_rate, sizeof(key.sample_rate));
+    const uint32_t parameter_count = uint32_t(key.parameters.size());
+    append(&parameter_count, sizeof(parameter_count));
+    append(key.parameters.data(), sizeof(double)*parameter_count);
+    return bytes;
+}
+
+// e.g. "saw_wavetable-0123456789abcdef.table", named after the kind so the directory is readable
+static std::string get_file_name(const Table_Key& key, const std::string& key_bytes) {
+    std::string name;
+    for (char c : key.kind) {
+        name += (std::isalnum(static_cast<unsigned char>(c)) != 0) ? c : '_';
+    }
+    char hash[24];
+    snprintf(hash, sizeof(hash), "-%016llx", static_cast<unsigned long long>(fnv1a(key_bytes.data(), key_bytes.size())));
+    return name + hash + ".table";
+}
+
+std::string Table_Cache::get_directory() {
+    auto variable = [](const char* name) { const char* value = std::getenv(name); return (value != nullptr) ? std::string(value) : std::string(); };
+    const std::string chosen = variable("TEST_SYNTH_CACHE_DIR");
+    if (!chosen.empty()) {
+        return chosen;
+    }
+#if defined(_WIN32)
+    const std::string local_app_data = variable("LOCALAPPDATA");
+    return local_app_data.empty() ? std::string() : local_app_data + "\\TestSynth";
+#elif defined(__APPLE__)
+    const std::string home = variable("HOME");
+    return home.empty() ? std::string() : home + "/Library/Caches/TestSynth";
+#else
+    const std::string xdg_cache = variable("XDG_CACHE_HOME");
+    if (!xdg_cache.empty()) {
+        return xdg_cache + "/test_synth";
+    }
+    const std::string home = variable("HOME");
+    return home.empty() ? std::string() : home + "/.cache/test_synth";
+#endif
+}
+
+// The floats in the file at path, if it holds exactly what key_bytes and count describe
+static std::shared_ptr<const float> map_floats(const std::string& path, const std::string& key_bytes, size_t count) {
+    std::shared_ptr<Mapped_File> file = std::make_shared<Mapped_File>();
+    if (!file->open(path.c_str()) || file->get_size() < sizeof(Cache_Header)) {
+        return nullptr;
+    }
+    Cache_Header header;
+    std::memcpy(&header, file->get_data(), sizeof(header));
+    const size_t offset = data_offset(uint32_t(key_bytes.size()));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 || header.format_version != Table_Cache::format_version
+            || header.key_bytes != key_bytes.size() || header.float_count != count || file->get_size() != offset + sizeof(float)*count
+            || std::memcmp(file->get_data() + sizeof(header), key_bytes.data(), key_bytes.size()) != 0) {
+        return nullptr;
+    }
+    const uint8_t* data = file->get_data() + offset;
+    if (fnv1a(data, sizeof(float)*count, fnv1a(key_bytes.data(), key_bytes.size())) != header.checksum) {
+        return nullptr;
+    }
+    // shares ownership of the mapping, which is page aligned, so the floats are too
+    return std::shared_ptr<const float>(file, reinterpret_cast<const float*>(data));
+}
+
+static bool write_file(const std::string& directory, const std::string& path, const std::string& key_bytes, const float* floats, size_t count) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    Cache_Header header;
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.format_version = Table_Cache::format_version;
+    header.key_bytes = uint32_t(key_bytes.size());
+    header.float_count = count;
+    header.checksum = fnv1a(floats, sizeof(float)*count, fnv1a(key_bytes.data(), key_bytes.size()));
+    const char padding[data_alignment] = {};
+
+    // unique per thread and moment, so writers in other processes never share a temporary file
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%zx.%llx.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()),
+             static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    const std::string temporary_path = path + suffix;
+    FILE* file = fopen(temporary_path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    written = written && fwrite(key_bytes.data(), 1, key_bytes.size(), file) == key_bytes.size();
+    const size_t padding_bytes = data_offset(header.key_bytes) - sizeof(header) - key_bytes.size();
+    written = written && fwrite(padding, 1, padding_bytes, file) == padding_bytes;
+    written = written && fwrite(floats, sizeof(float), count, file) == count;
+    written = (fclose(file) == 0) && written;
+    if (written) {
+        std::filesystem::rename(temporary_path, path, error);
+        written = !error;
+    }
+    if (!written) {
+        std::filesystem::remove(temporary_path, error);
+    }
+    return written;
+}
+
+struct Pending_Write {
+    std::string directory;
+    std::string path;
+    std::string key_bytes;
+    std::shared_ptr<const float> floats; // keeps the table alive until it's written
+    size_t count;
+};
+
+// One thread for the whole process, started by the first write, and joined when the process exits or the plugin is
+// unloaded, after finishing whatever's queued
+struct Cache_Writer {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Pending_Write> queue;
+    bool writing = false;
+    bool stopping = false;
+    std::thread thread;
+
+    ~Cache_Writer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    void writer_main() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // stopping, with nothing left to write
+            }
+            Pending_Write write = std::move(queue.front());
+            queue.pop_front();
+            writing = true;
+            lock.unlock();
+            write_file(write.directory, write.path, write.key_bytes, write.floats.get(), write.count);
+            write.floats.reset();
+            lock.lock();
+            writing = false;
+            changed.notify_all();
+        }
+    }
+};
+static Cache_Writer& get_writer() {
+    static Cache_Writer writer;
+    return writer;
+}
+
+std::shared_ptr<const float> Table_Cache::get_floats(const Table_Key& key, size_t count, const std::function<void(float* out)>& build) {
+    const std::string directory = get_directory();
+    const std::string key_bytes = serialize_key(key);
+    const std::string path = directory + "/" + get_file_name(key, key_bytes);
+    if (!directory.empty()) {
+        if (std::shared_ptr<const float> mapped = map_floats(path, key_bytes, count)) {
+            return mapped;
+        }
+    }
+
+    std::shared_ptr<float> built(new float[count](), std::default_delete<float[]>());
+    build(built.get());
+    if (!directory.empty()) {
+        Cache_Writer& writer = get_writer();
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        writer.queue.push_back({directory, path, key_bytes, built, count});
+        if (!writer.thread.joinable()) {
+            writer.thread = std::thread(&Cache_Writer::writer_main, &writer);
+        }
+        writer.changed.notify_all();
+    }
+    return built;
+}
+
+void Table_Cache::wait_for_writes() {
+    Cache_Writer& writer = get_writer();
+    std::unique_lock<std::mutex> lock(writer.mutex);
+    writer.changed.wait(lock, [&writer]() { return writer.queue.empty() && !writer.writing; });
+}
@@ -0,0 +1,48 @@
+/*
+table_cache.hpp
+On-disk cache of precomputed tables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "shared_tables.hpp"
+
+class Table_Cache {
+    // Tables of floats precomputed on disk, so a new process maps them read-only instead of building them, and
+    // processes on the same machine share the pages. One file per table in get_directory(): a header, the table's
+    // Table_Key, then the floats, 64-byte aligned. A file is only used if its format version, key, length and checksum
+    // all match, so a stale or damaged file is built again and replaced. Missing tables are written by a background
+    // thread, to a temporary file renamed into place, so a reader never sees half a file.
+    // Files are in the machine's byte order; on another machine the format version won't match and they're rebuilt.
+    // Put a version number in the key's parameters, and bump it whenever the code building the table changes.
+    public:
+    static const uint32_t format_version = 1;
+
+    // Not RT safe. `count` floats for key: mapped from the cache if it has them, otherwise filled in by build(out),
+    // which gets count zeroed floats, and queued to be written. They stay valid as long as the pointer is held.
+    static std::shared_ptr<const float> get_floats(const Table_Key& key, size_t count, const std::function<void(float* out)>& build);
+
+    static void wait_for_writes(); // until everything queued so far is on disk
+    static std::string get_directory(); // from TEST_SYNTH_CACHE_DIR, or the user's cache directory; "" for none
+};
@@ -0,0 +1,236 @@
+/*
+tuning.cpp
+Tuning tables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "tuning.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+constexpr Pitch_Bend_Table default_pitch_bend_table = make_pitch_bend_table(default_pitch_bend_range_st);
+
+void fill_pitch_bend_table(Pitch_Bend_Table& table, double range_semitones) {
+    // 2^(range*(value - mid)/12/mid), split into a coarse and a fine factor, so only 256 calls to exp2(). Each entry is
+    // a single product, rather than a running one, so -ffast-math can't reorder it into something that rounds differently.
+    const int32_t mid_value = 0x2000;
+    const uint32_t fine_steps = 128;
+    const double semitones_per_value = range_semitones/mid_value;
+    double coarse[Pitch_Bend_Table::size/fine_steps];
+    double fine[fine_steps];
+    for (uint32_t step = 0; step < fine_steps; ++step) {
+        fine[step] = std::exp2(semitones_per_value*step/12);
+    }
+    for (uint32_t step = 0; step < Pitch_Bend_Table::size/fine_steps; ++step) {
+        coarse[step] = std::exp2(semitones_per_value*(int32_t(step*fine_steps) - mid_value)/12);
+    }
+    for (uint32_t value = 0; value < Pitch_Bend_Table::size; ++value) {
+        table.coefficient[value] = float(coarse[value/fine_steps]*fine[value % fine_steps]);
+    }
+}
+
+// Scala files: https://www.huygens-fokker.org/scala/scl_format.html
+// Lines starting with '!' are comments. Leading whitespace is ignored.
+static bool read_scala_line(std::ifstream& file, std::string& line) {
+    while (std::getline(file, line)) {
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start != std::string::npos && line[start] == '!') {
+            continue;
+        }
+        line = (start == std::string::npos) ? std::string() : line.substr(start);
+        return true;
+    }
+    return false;
+}
+
+// A pitch is in cents if it contains a '.', otherwise it is a ratio like 3/2 or a whole number like 2
+static bool parse_scala_pitch(const std::string& line, double& ratio) {
+    const char* text = line.c_str();
+    char* end;
+    if (line.find('.') != std::string::npos && line.find('.') < line.find_first_of(" \t/")) {
+        double cents = strtod(text, &end);
+        if (end == text) return false;
+        ratio = pow(2, cents/1200);
+        return true;
+    }
+    long numerator = strtol(text, &end, 10);
+    if (end == text || numerator <= 0) return false;
+    long denominator = 1;
+    if (*end == '/') {
+        const char* denominator_text = end + 1;
+        denominator = strtol(denominator_text, &end, 10);
+        if (end == denominator_text || denominator <= 0) return false;
+    }
+    ratio = double(numerator)/denominator;
+    return true;
+}
+
+// Ratios of scale degrees 1 to N relative to degree 0; the last one is the period (usually 2/1)
+static bool load_scl(const char* path, std::vector<double>& ratios) {
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !read_scala_line(file, line)) return false; // description
+    if (!read_scala_line(file, line)) return false;
+    long count = strtol(line.c_str(), nullptr, 10);
+    if (count <= 0) return false;
+
+    ratios.clear();
+    for (long i = 0; i < count; ++i) {
+        double ratio;
+        if (!read_scala_line(file, line) || !parse_scala_pitch(line, ratio)) return false;
+        ratios.push_back(ratio);
+    }
+    return true;
+}
+
+struct Keyboard_Mapping {
+    // defaults match a .kbm that maps scale degree 0 to middle C, with A4 at 440 Hz
+    int32_t first_note = 0;
+    int32_t last_note = 127;
+    int32_t middle_note = 60;
+    int32_t reference_note = 69;
+    double reference_frequency = 440;
+    int32_t octave_degree = 0;   // 0 means the size of the scale
+    std::vector<int32_t> degrees; // empty for a linear mapping; -1 for unmapped keys
+};
+
+static bool load_kbm(const char* path, Keyboard_Mapping& mapping) {
+    std::ifstream file(path);
+    std::string line;
+    int32_t header[7];
+    for (int32_t i = 0; i < 7; ++i) {
+        if (!file || !read_scala_line(file, line)) return false;
+        header[i] = int32_t(strtol(line.c_str(), nullptr, 10));
+        if (i == 5) mapping.reference_frequency = strtod(line.c_str(), nullptr);
+    }
+    int32_t map_size = header[0];
+    mapping.first_note = header[1];
+    mapping.last_note = header[2];
+    mapping.middle_note = header[3];
+    mapping.reference_note = header[4];
+    mapping.octave_degree = header[6];
+    if (map_size < 0 || mapping.reference_frequency <= 0) return false;
+
+    mapping.degrees.clear();
+    for (int32_t i = 0; i < map_size; ++i) {
+        // trailing entries may be left out, meaning unmapped
+        if (!read_scala_line(file, line) || line.empty() || line[0] == 'x') {
+            mapping.degrees.push_back(-1);
+        } else {
+            mapping.degrees.push_back(int32_t(strtol(line.c_str(), nullptr, 10)));
+        }
+    }
+    return true;
+}
+
+static int32_t floor_div(int32_t a, int32_t b) {
+    return (a >= 0) ? a/b : -((-a + b - 1)/b);
+}
+
+// Scale degree played by a key, or false if the key is unmapped
+static bool get_key_degree(const Keyboard_Mapping& mapping, int32_t scale_size, int32_t note, int32_t& degree) {
+    int32_t offset = note - mapping.middle_note;
+    if (mapping.degrees.empty()) {
+        degree = offset;
+        return true;
+    }
+    int32_t map_size = mapping.degrees.size();
+    int32_t repeats = floor_div(offset, map_size);
+    int32_t entry = mapping.degrees[offset - repeats*map_size];
+    if (entry < 0) {
+        return false;
+    }
+    degree = entry + repeats*(mapping.octave_degree > 0 ? mapping.octave_degree : scale_size);
+    return true;
+}
+
+static double get_degree_ratio(const std::vector<double>& ratios, int32_t degree) {
+    int32_t scale_size = ratios.size();
+    int32_t periods = floor_div(degree, scale_size);
+    int32_t step = degree - periods*scale_size;
+    return pow(ratios.back(), periods)*(step == 0 ? 1 : ratios[step - 1]);
+}
+
+Tuning::Tuning() : active(&equal_temperament_table), pending(nullptr), retired(nullptr) {}
+
+Tuning::~Tuning() {
+    // no audio thread is running by the time the plugin is destroyed
+    free_table(active);
+    free_table(pending.exchange(nullptr));
+    free_table(retired.exchange(nullptr));
+}
+
+bool Tuning::load_scala(const char* scl_path, const char* kbm_path) {
+    std::vector<double> ratios;
+    if (scl_path == nullptr || !load_scl(scl_path, ratios)) {
+        return false;
+    }
+    Keyboard_Mapping mapping;
+    if (kbm_path != nullptr && kbm_path[0] != '\0' && !load_kbm(kbm_path, mapping)) {
+        return false;
+    }
+
+    int32_t scale_size = ratios.size();
+    int32_t reference_degree = mapping.reference_note - mapping.middle_note;
+    get_key_degree(mapping, scale_size, mapping.reference_note, reference_degree); // if the reference key is unmapped, fall back to a linear offset
+    double reference_ratio = get_degree_ratio(ratios, reference_degree);
+
+    Tuning_Table* table = new Tuning_Table();
+    for (int32_t note = 0; note < 128; ++note) {
+        int32_t degree;
+        if (note < mapping.first_note || note > mapping.last_note || !get_key_degree(mapping, scale_size, note, degree)) {
+            table->note_frequency[note] = 0;
+            continue;
+        }
+        table->note_frequency[note] = float(mapping.reference_frequency*get_degree_ratio(ratios, degree)/reference_ratio);
+    }
+
+    publish(table);
+    return true;
+}
+
+void Tuning::reset() {
+    publish(&equal_temperament_table);
+}
+
+void Tuning::update() {
+    // only take a new table once the loader has collected the last one we retired
+    if (retired.load(std::memory_order_acquire) != nullptr) {
+        return;
+    }
+    const Tuning_Table* table = pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (table != nullptr) {
+        retired.store(active, std::memory_order_release);
+        active = table;
+    }
+}
+
+void Tuning::publish(const Tuning_Table* table) {
+    free_table(retired.exchange(nullptr, std::memory_order_acq_rel));
+    // a table the audio thread never picked up can be freed straight away
+    free_table(pending.exchange(table, std::memory_order_acq_rel));
+}
+
+void Tuning::free_table(const Tuning_Table* table) {
+    if (table != &equal_temperament_table) {
+        delete table;
+    }
+}
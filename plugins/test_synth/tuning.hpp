@@ -0,0 +1,105 @@
+/*
+tuning.hpp
+Tuning tables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Compile-time helpers, so the default tables cost nothing at runtime
+constexpr double constexpr_exp2(double x) {
+    // 2^x = 2^n * e^(f*ln2), with n the integer part; the series converges quickly for f in [0, 1)
+    int32_t n = int32_t(x);
+    if (double(n) > x) {
+        n -= 1;
+    }
+    double f = (x - n)*0.6931471805599453;
+    double term = 1;
+    double sum = 1;
+    for (int32_t k = 1; k < 25; ++k) {
+        term *= f/k;
+        sum += term;
+    }
+    for (; n > 0; --n) sum *= 2;
+    for (; n < 0; ++n) sum /= 2;
+    return sum;
+}
+
+struct Tuning_Table {
+    float note_frequency[128]; // Hz, indexed by MIDI note number; 0 for notes the tuning leaves unmapped
+};
+
+constexpr Tuning_Table make_equal_temperament_table() {
+    Tuning_Table table = {};
+    for (int32_t note = 0; note < 128; ++note) {
+        table.note_frequency[note] = float(440*constexpr_exp2((note - 69)/12.0));
+    }
+    return table;
+}
+
+constexpr Tuning_Table equal_temperament_table = make_equal_temperament_table();
+
+struct Pitch_Bend_Table {
+    // Frequency coefficient for every 14-bit pitch bend value
+    static const uint32_t size = 0x4000;
+    float coefficient[size];
+};
+
+constexpr Pitch_Bend_Table make_pitch_bend_table(double range_semitones) {
+    // Pitch bend has 14 bits of information, so the maximum possible value is 0x3fff, or 16383
+    // This leaves us with a center value of 8192.
+    Pitch_Bend_Table table = {};
+    const int32_t mid_value = 0x2000;
+    for (int32_t value = 0; value < int32_t(Pitch_Bend_Table::size); ++value) {
+        table.coefficient[value] = float(constexpr_exp2((range_semitones/12)*(value - mid_value)/mid_value));
+    }
+    return table;
+}
+
+constexpr float default_pitch_bend_range_st = 2;
+extern const Pitch_Bend_Table default_pitch_bend_table; // built at compile time in tuning.cpp, which is slow enough to only do once
+// The same for any other range at run time, with 256 calls to exp2(), so it's cheap enough for the audio thread.
+void fill_pitch_bend_table(Pitch_Bend_Table& table, double range_semitones);
+
+class Tuning {
+    // Owns the tuning table the audio thread reads. New tables are built off the audio thread (e.g. from Scala files)
+    // and handed over through atomic pointers, so the audio thread never waits, allocates or frees.
+    public:
+    Tuning();
+    ~Tuning();
+
+    // Not RT safe. Load a Scala scale (.scl) and an optional keyboard mapping (.kbm; pass nullptr or "" for the default),
+    // then publish the result. Returns false, leaving the tuning unchanged, if either file can't be read.
+    bool load_scala(const char* scl_path, const char* kbm_path);
+    void reset(); // back to 12-tone equal temperament; not RT safe
+
+    // RT safe. Called at the start of each block to pick up a newly published table.
+    void update();
+    float get_note_frequency(uint8_t note_number) const { return active->note_frequency[note_number & 0x7f]; }
+
+    protected:
+    void publish(const Tuning_Table* table);
+    void free_table(const Tuning_Table* table);
+
+    // Loading and resetting are expected to happen from a single non-RT thread at a time
+    const Tuning_Table* active;                 // only touched by the audio thread
+    std::atomic<const Tuning_Table*> pending;   // published by the loader, taken by the audio thread
+    std::atomic<const Tuning_Table*> retired;   // handed back by the audio thread, freed by the loader
+};
@@ -0,0 +1,58 @@
+/*
+unison.cpp
+Unison voice spreading for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "unison.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void constant_power_pan(float pan, float& left, float& right) {
+    float angle = (pan + 1)*float(M_PI)/4;
+    left = std::sqrt(2.f)*std::cos(angle);
+    right = std::sqrt(2.f)*std::sin(angle);
+}
+
+Unison::Unison() {
+    set_parameters(1, 0, 0);
+}
+
+void Unison::set_parameters(uint32_t copies_in, float detune_cents, float spread) {
+    copies = std::clamp(copies_in, uint32_t(1), max_copies);
+    const float level = 1/std::sqrt(float(copies));
+
+    for (uint32_t c_idx = 0; c_idx < max_copies; ++c_idx) {
+        ratio[c_idx] = 0;
+        mid_gain[c_idx] = 0;
+        side_gain[c_idx] = 0;
+    }
+    for (uint32_t c_idx = 0; c_idx < copies; ++c_idx) {
+        // position from -1 to 1 across the copies, 0 for a single copy
+        float position = (copies > 1) ? 2.f*c_idx/(copies - 1) - 1 : 0;
+        ratio[c_idx] = std::exp2(position*detune_cents/1200);
+
+        // each copy is panned opposite its mirror image, and which of the pair goes left alternates outwards
+        uint32_t pair = std::min(c_idx, copies - 1 - c_idx);
+        float pan = spread*position*((pair % 2) ? -1 : 1);
+        float left, right;
+        constant_power_pan(pan, left, right);
+        mid_gain[c_idx] = level*(left + right)/2;
+        side_gain[c_idx] = level*(left - right)/2;
+    }
+}
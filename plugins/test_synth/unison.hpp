@@ -0,0 +1,51 @@
+/*
+unison.hpp
+Unison voice spreading for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Constant-power pan law, scaled so a centred signal has unity gain in both channels: pan goes from -1 (left only) to
+// 1 (right only). Voices and unison copies both pan with it.
+void constant_power_pan(float pan, float& left, float& right);
+
+class Unison {
+    // How each voice spreads into detuned copies in unison mode. The copies are spaced evenly across +-detune and
+    // alternate left and right, with the most detuned panned widest. They are summed at 1/sqrt(copies) each, which
+    // keeps the loudness roughly constant since their phases drift apart.
+    public:
+    static const uint32_t max_copies = 16;
+
+    Unison();
+
+    // copies is clamped to 1..max_copies; spread goes from 0 (all centred) to 1 (outermost copies hard left/right)
+    void set_parameters(uint32_t copies_in, float detune_cents, float spread);
+
+    uint32_t get_copies() const { return copies; }
+    bool is_enabled() const { return copies > 1; } // a single copy is the plain mono voice
+
+    // Per copy, zero past get_copies() so the arrays can be read a whole vector of copies at a time (see Unison_Copies)
+    float ratio[max_copies];     // frequency relative to the voice
+    float mid_gain[max_copies];
+    float side_gain[max_copies];
+
+    protected:
+    uint32_t copies;
+};
@@ -0,0 +1,364 @@
+/*
+voices.cpp
+Voice pool for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "voices.hpp"
+#include "tuning.hpp"
+
+#include <algorithm>
+
+Voice_Pool::Voice_Pool() {
+    max_voices = 0;
+    voice_limit = 0;
+    steal_policy = Voice_Steal_Policy::released_first;
+    next_start_order = 0;
+    live_count = 0;
+    free_count = 0;
+    std::fill(&voice_for_note[0][0], &voice_for_note[0][0] + 16*128, -1);
+}
+
+void Voice_Pool::allocate(uint32_t max_voices_in) {
+    max_voices = max_voices_in;
+    voice_limit = max_voices;
+
+    note_number.assign(max_voices, 0);
+    frequency.assign(max_voices, 0);
+    phase.assign(max_voices, 0);
+    unison_phase.assign(max_voices*Unison::max_copies, 0);
+    operator_phase.assign(max_voices*operator_phases_per_voice, 0);
+    operator_feedback.assign(max_voices*2*Unison::max_copies, 0);
+    velocity.assign(max_voices, 0);
+    start_order.assign(max_voices, 0);
+    envelope_stage.assign(max_voices, Envelope_Stage::finished);
+    envelope_level.assign(max_voices, 0);
+    envelope_amplitude.assign(max_voices, 0);
+    envelope_slope.assign(max_voices, 0);
+    envelope_frames_left.assign(max_voices, 0);
+    channel.assign(max_voices, 0);
+    bend.assign(max_voices, 1);
+    pressure.assign(max_voices, 0);
+    timbre.assign(max_voices, 0);
+    glide_st.assign(max_voices, 0);
+    glide_rate_st.assign(max_voices, 0);
+    modulation_gain.assign(max_voices, 1);
+    modulation_gain_end.assign(max_voices, 1);
+    modulation_gain_slope.assign(max_voices, 0);
+    pitch_modulation_st.assign(max_voices, 0);
+    pitch_modulation_initialised.assign(max_voices, 0);
+    pitch_offset_st.assign(max_voices, 0);
+    pitch_ratio.assign(max_voices, 1);
+    duty_offset.assign(max_voices, 0);
+    pan.assign(max_voices, 0);
+    pan_position.assign(max_voices, 0);
+    pan_initialised.assign(max_voices, 0);
+    pan_mid_gain.assign(max_voices, 1);
+    pan_side_gain.assign(max_voices, 0);
+    pan_mid_gain_end.assign(max_voices, 1);
+    pan_side_gain_end.assign(max_voices, 0);
+
+    live_voices.assign(max_voices, 0);
+    live_position.assign(max_voices, 0);
+    free_voices.assign(max_voices, 0);
+
+    clear();
+}
+
+void Voice_Pool::free_storage() {
+    // swap with empty vectors, since clear() keeps the capacity around
+    std::vector<uint8_t>().swap(note_number);
+    std::vector<float>().swap(frequency);
+    std::vector<uint32_t>().swap(phase);
+    std::vector<uint32_t>().swap(unison_phase);
+    std::vector<uint32_t>().swap(operator_phase);
+    std::vector<float>().swap(operator_feedback);
+    std::vector<float>().swap(velocity);
+    std::vector<uint32_t>().swap(start_order);
+    std::vector<Envelope_Stage>().swap(envelope_stage);
+    std::vector<float>().swap(envelope_level);
+    std::vector<float>().swap(envelope_amplitude);
+    std::vector<float>().swap(envelope_slope);
+    std::vector<uint32_t>().swap(envelope_frames_left);
+    std::vector<uint8_t>().swap(channel);
+    std::vector<float>().swap(bend);
+    std::vector<float>().swap(pressure);
+    std::vector<float>().swap(timbre);
+    std::vector<float>().swap(glide_st);
+    std::vector<float>().swap(glide_rate_st);
+    std::vector<float>().swap(modulation_gain);
+    std::vector<float>().swap(modulation_gain_end);
+    std::vector<float>().swap(modulation_gain_slope);
+    std::vector<float>().swap(pitch_modulation_st);
+    std::vector<uint8_t>().swap(pitch_modulation_initialised);
+    std::vector<float>().swap(pitch_offset_st);
+    std::vector<float>().swap(pitch_ratio);
+    std::vector<float>().swap(duty_offset);
+    std::vector<float>().swap(pan);
+    std::vector<float>().swap(pan_position);
+    std::vector<uint8_t>().swap(pan_initialised);
+    std::vector<float>().swap(pan_mid_gain);
+    std::vector<float>().swap(pan_side_gain);
+    std::vector<float>().swap(pan_mid_gain_end);
+    std::vector<float>().swap(pan_side_gain_end);
+
+    std::vector<uint32_t>().swap(live_voices);
+    std::vector<uint32_t>().swap(live_position);
+    std::vector<uint32_t>().swap(free_voices);
+
+    max_voices = 0;
+    voice_limit = 0;
+    clear();
+}
+
+void Voice_Pool::clear() {
+    live_count = 0;
+    free_count = max_voices;
+    // hand out low voice indices first, so a sparse pool stays at the front of the arrays
+    for (uint32_t i = 0; i < max_voices; ++i) {
+        free_voices[i] = max_voices - 1 - i;
+    }
+    std::fill(&voice_for_note[0][0], &voice_for_note[0][0] + 16*128, -1);
+}
+
+int32_t Voice_Pool::note_on(uint8_t channel_in, uint8_t note_number_in, uint8_t velocity_in, float frequency_in) {
+    channel_in &= 0x0f;
+    note_number_in &= 0x7f;
+
+    // pressing a note that is still held restarts it in the same voice, attacking from its current level
+    // (a released voice of the same note keeps ringing out, and the new note gets its own voice).
+    // Stage changes take effect at the next envelope control period.
+    int32_t voice = voice_for_note[channel_in][note_number_in];
+    if (voice < 0 && (live_count >= voice_limit || free_count == 0)) {
+        voice = choose_victim();
+        if (voice < 0) {
+            return -1; // voice limit of 0
+        }
+        unmap_voice(voice);
+        voice_for_note[channel_in][note_number_in] = voice;
+    } else if (voice < 0) {
+        voice = free_voices[--free_count];
+
+        live_position[voice] = live_count;
+        live_voices[live_count++] = voice;
+        voice_for_note[channel_in][note_number_in] = voice;
+
+        phase[voice] = 0;
+        // unison copies start spread around the cycle (by the golden ratio), so they don't all peak together at the attack
+        uint32_t* copy_phases = get_unison_phases(voice);
+        for (uint32_t c_idx = 0; c_idx < Unison::max_copies; ++c_idx) {
+            copy_phases[c_idx] = c_idx*0x9e3779b9u;
+        }
+        // FM operators start in step within each copy, since their relative phases shape the sound
+        Operator_State operators = get_operator_state(voice);
+        for (uint32_t c_idx = 0; c_idx < Unison::max_copies; ++c_idx) {
+            std::fill(operators.phases + c_idx*FM_Patch::max_operators, operators.phases + (c_idx + 1)*FM_Patch::max_operators, c_idx*0x9e3779b9u);
+        }
+        std::fill(operators.feedback, operators.feedback + 2*Unison::max_copies, 0.f);
+        envelope_level[voice] = 0;
+        envelope_amplitude[voice] = 0;
+        envelope_frames_left[voice] = 0;
+        modulation_gain[voice] = 1;
+        modulation_gain_end[voice] = 1;
+        pitch_modulation_initialised[voice] = 0;
+        pitch_offset_st[voice] = 0;
+        pitch_ratio[voice] = 1;
+        duty_offset[voice] = 0;
+        pan_initialised[voice] = 0;
+    }
+
+    channel[voice] = channel_in;
+    note_number[voice] = note_number_in;
+    frequency[voice] = frequency_in;
+    velocity[voice] = velocity_in/127.f;
+    start_order[voice] = next_start_order++;
+    envelope_stage[voice] = Envelope_Stage::attack;
+    pan[voice] = 0;
+    bend[voice] = 1;
+    pressure[voice] = 0;
+    timbre[voice] = 0;
+    glide_st[voice] = 0;
+    glide_rate_st[voice] = 0;
+
+    return voice;
+}
+
+void Voice_Pool::note_off(uint8_t channel_in, uint8_t note_number_in) {
+    channel_in &= 0x0f;
+    note_number_in &= 0x7f;
+
+    int32_t voice = voice_for_note[channel_in][note_number_in];
+    if (voice < 0) {
+        return;
+    }
+    voice_for_note[channel_in][note_number_in] = -1;
+    envelope_stage[voice] = Envelope_Stage::release;
+}
+
+void Voice_Pool::release_all() {
+    for (uint32_t live_index = 0; live_index < live_count; ++live_index) {
+        const uint32_t voice = live_voices[live_index];
+        if (voice_for_note[channel[voice]][note_number[voice]] == int32_t(voice)) {
+            voice_for_note[channel[voice]][note_number[voice]] = -1;
+            envelope_stage[voice] = Envelope_Stage::release;
+        }
+    }
+}
+
+void Voice_Pool::set_voice_limit(uint32_t limit) {
+    voice_limit = (limit < max_voices) ? limit : max_voices;
+}
+
+void Voice_Pool::enforce_voice_limit() {
+    if (live_count <= voice_limit) {
+        return;
+    }
+    // Cutting a voice off mid-waveform clicks, and the limit drops under load, just when many voices are playing.
+    // Instead they fade out over a few milliseconds and free_finished_voices() frees them, so the live count only
+    // meets the limit once they're silent.
+    uint32_t fading = 0;
+    for (uint32_t live_index = 0; live_index < live_count; ++live_index) {
+        fading += (envelope_stage[live_voices[live_index]] == Envelope_Stage::fade) ? 1 : 0;
+    }
+    while (live_count - fading > voice_limit) {
+        uint32_t voice = choose_victim(true);
+        unmap_voice(voice);
+        envelope_stage[voice] = Envelope_Stage::fade;
+        ++fading;
+    }
+}
+
+void Voice_Pool::unmap_voice(uint32_t voice) {
+    if (voice_for_note[channel[voice]][note_number[voice]] == int32_t(voice)) {
+        voice_for_note[channel[voice]][note_number[voice]] = -1;
+    }
+}
+
+int32_t Voice_Pool::choose_victim(bool skip_fading) const {
+    // a linear scan, but only when the pool is full
+    int32_t victim = -1;
+    bool victim_released = false;
+    float victim_level = 0;
+    uint32_t victim_age = 0;
+
+    for (uint32_t live_index = 0; live_index < live_count; ++live_index) {
+        const uint32_t voice = live_voices[live_index];
+        if (skip_fading && envelope_stage[voice] == Envelope_Stage::fade) {
+            continue;
+        }
+        const bool released = envelope_stage[voice] >= Envelope_Stage::release;
+        const float level = velocity[voice]*envelope_amplitude[voice];
+        const uint32_t age = next_start_order - start_order[voice]; // wraps correctly
+
+        bool better = (victim < 0);
+        switch (steal_policy) {
+        case Voice_Steal_Policy::oldest:
+            better = better || age > victim_age;
+            break;
+        case Voice_Steal_Policy::quietest:
+            better = better || level < victim_level;
+            break;
+        case Voice_Steal_Policy::released_first:
+            if (released != victim_released) {
+                better = better || released;
+            } else {
+                better = better || (released ? level < victim_level : age > victim_age);
+            }
+            break;
+        }
+
+        if (better) {
+            victim = voice;
+            victim_released = released;
+            victim_level = level;
+            victim_age = age;
+        }
+    }
+    return victim;
+}
+
+void Voice_Pool::free_finished_voices() {
+    // walk backwards, so the voice free_voice() moves into the freed slot has already been checked
+    for (uint32_t live_index = live_count; live_index-- > 0;) {
+        uint32_t voice = live_voices[live_index];
+        if (envelope_stage[voice] == Envelope_Stage::finished && envelope_frames_left[voice] == 0) {
+            free_voice(voice);
+        }
+    }
+}
+
+void Voice_Pool::free_voice(uint32_t voice) {
+    // move the last live voice into the freed slot so the live list stays dense
+    uint32_t position = live_position[voice];
+    uint32_t last_voice = live_voices[--live_count];
+    live_voices[position] = last_voice;
+    live_position[last_voice] = position;
+
+    free_voices[free_count++] = voice;
+}
+
+float Voice_Pool::get_frequency_from_note_number(uint8_t note_number_in) {
+    return equal_temperament_table.note_frequency[note_number_in & 0x7f];
+}
+
+// Aim to keep rendering under this fraction of the deadline, leaving room for the host and other plugins
+static const float load_high = 0.7f;
+static const float load_low = 0.4f;
+static const uint32_t calm_blocks_before_raise = 32;
+static const uint32_t min_voice_limit = 4;
+
+Adaptive_Voice_Limit::Adaptive_Voice_Limit() {
+    reset(0);
+}
+
+void Adaptive_Voice_Limit::reset(uint32_t max_limit_in) {
+    max_limit = max_limit_in;
+    limit = max_limit;
+    load = 0;
+    calm_blocks = 0;
+}
+
+uint32_t Adaptive_Voice_Limit::update(double render_seconds, double deadline_seconds, uint32_t live_count) {
+    if (deadline_seconds <= 0) {
+        return limit;
+    }
+    float block_load = render_seconds/deadline_seconds;
+
+    // react to rising load quickly and to falling load slowly
+    load += (block_load > load ? 0.5f : 0.05f)*(block_load - load);
+
+    if (load > load_high) {
+        // assuming the cost is proportional to the voice count, shed the share of voices that brings the load back to load_high
+        uint32_t shed = uint32_t(live_count*(load - load_high)/load) + 1;
+        uint32_t target = (live_count > shed) ? live_count - shed : 0;
+        if (target < min_voice_limit) {
+            target = min_voice_limit < max_limit ? min_voice_limit : max_limit;
+        }
+        if (target < limit) {
+            limit = target;
+        }
+        calm_blocks = 0;
+    } else if (load < load_low && limit < max_limit) {
+        if (++calm_blocks >= calm_blocks_before_raise) {
+            limit += 1;
+            calm_blocks = 0;
+        }
+    } else {
+        calm_blocks = 0;
+    }
+    return limit;
+}
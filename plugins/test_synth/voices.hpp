@@ -0,0 +1,149 @@
+/*
+voices.hpp
+Voice pool for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "envelope.hpp"
+#include "fm.hpp"
+#include "unison.hpp"
+
+enum class Voice_Steal_Policy : uint8_t {
+    oldest,         // the voice whose note started longest ago
+    quietest,       // the voice with the lowest velocity times envelope level
+    released_first, // the quietest released voice; the oldest voice if none are released
+};
+
+class Voice_Pool {
+    // Fixed-capacity pool of voices, stored as a structure of arrays.
+    // Storage is only (re)allocated by allocate(), which must not be called from the audio thread.
+    // Everything else is O(1) and does not touch the heap.
+    public:
+    Voice_Pool();
+
+    void allocate(uint32_t max_voices_in);  // call from activate()
+    void free_storage();                    // call from deactivate()
+    void clear();                           // drop every voice without freeing storage
+
+    // Notes are owned by their MIDI channel, so the same key on two channels (e.g. two MPE member channels) gets two voices.
+    // Returns the voice index. When the voice limit is reached, a voice is stolen according to the steal policy;
+    // the new note takes over its phase, envelope level, modulation gain and stereo position, so the steal doesn't click.
+    // The voice starts centred and without expression or glide; the caller sets pan, bend, pressure, timbre and glide as needed.
+    int32_t note_on(uint8_t channel_in, uint8_t note_number_in, uint8_t velocity_in, float frequency_in);
+    void note_off(uint8_t channel_in, uint8_t note_number_in); // starts the release; the voice stays live until its envelope finishes
+    void release_all();                    // note off for every held note
+    int32_t get_held_voice(uint8_t channel_in, uint8_t note_number_in) const { return voice_for_note[channel_in & 0x0f][note_number_in & 0x7f]; }
+    bool is_held(uint32_t voice) const { return voice_for_note[channel[voice]][note_number[voice]] == int32_t(voice); }
+    void free_finished_voices();           // call after rendering, never while iterating the live voices
+
+    void set_voice_limit(uint32_t limit);   // at most the allocated size; doesn't drop voices by itself
+    void enforce_voice_limit();             // fade out voices chosen by the steal policy until the rest meet the limit
+    void set_steal_policy(Voice_Steal_Policy policy) { steal_policy = policy; }
+
+    uint32_t get_max_voices() const { return max_voices; }
+    uint32_t get_voice_limit() const { return voice_limit; }
+    uint32_t get_live_count() const { return live_count; }
+    uint32_t get_live_voice(uint32_t live_index) const { return live_voices[live_index]; }
+
+    static float get_frequency_from_note_number(uint8_t note_number_in); // 12-tone equal temperament
+
+    uint32_t* get_unison_phases(uint32_t voice) { return unison_phase.data() + voice*Unison::max_copies; }
+    Operator_State get_operator_state(uint32_t voice) {
+        return Operator_State{operator_phase.data() + voice*operator_phases_per_voice, operator_feedback.data() + voice*2*Unison::max_copies};
+    }
+    static const uint32_t operator_phases_per_voice = FM_Patch::max_operators*Unison::max_copies;
+
+    // per-voice state, indexed by voice index
+    std::vector<uint8_t> note_number;
+    std::vector<float> frequency;
+    std::vector<uint32_t> phase;       // fixed point, 2^32 per cycle (see kernels.hpp)
+    std::vector<uint32_t> unison_phase; // Unison::max_copies per voice, used instead of phase in unison mode
+    std::vector<uint32_t> operator_phase;  // FM operators, used instead of phase by FM_Oscillator (see Operator_State)
+    std::vector<float> operator_feedback;  // the FM feedback operator's last two samples, per unison copy
+    std::vector<float> velocity;
+    std::vector<uint32_t> start_order;        // note-on counter at the time the voice started
+    std::vector<Envelope_Stage> envelope_stage;
+    std::vector<float> envelope_level;         // level at the end of the current control period
+    std::vector<float> envelope_amplitude;     // current level, interpolated within the control period
+    std::vector<float> envelope_slope;         // amplitude change per frame
+    std::vector<uint32_t> envelope_frames_left; // frames left in the current control period
+    // Expression, set by MIDI between sub-blocks and picked up by the signal generator at the next control period
+    std::vector<uint8_t> channel;              // MIDI channel that owns the note
+    std::vector<float> bend;                   // frequency ratio from the channel's own pitch bend (MPE member channels)
+    std::vector<float> pressure;               // 0 to 1, from channel pressure or polyphonic aftertouch
+    std::vector<float> timbre;                 // 0 to 1, from CC74
+    std::vector<float> glide_st;               // portamento still to go, relative to the note's own pitch
+    std::vector<float> glide_rate_st;          // portamento speed per frame
+    // Modulation, evaluated once per control period (see Signal_Generator)
+    std::vector<float> modulation_gain;        // current gain from pressure and the matrix, interpolated like envelope_amplitude
+    std::vector<float> modulation_gain_end;    // gain at the end of the current control period
+    std::vector<float> modulation_gain_slope;  // gain change per frame
+    std::vector<float> pitch_modulation_st;    // pitch from the matrix at the end of the current control period
+    std::vector<uint8_t> pitch_modulation_initialised; // 0 until the first period sets pitch_modulation_st
+    std::vector<float> pitch_offset_st;        // pitch from glide and the matrix over the current control period
+    std::vector<float> pitch_ratio;            // the same as a frequency ratio
+    std::vector<float> duty_offset;            // pulse width change over the current control period
+    // Stereo position, only followed while Signal_Generator pans voices
+    std::vector<float> pan;                    // -1 (left) to 1 (right), set by the caller when the note starts
+    std::vector<float> pan_position;           // pan with modulation at the end of the current control period
+    std::vector<uint8_t> pan_initialised;      // 0 until the first period sets pan_position, so a new note starts in place
+    std::vector<float> pan_mid_gain;           // current gains into mid and side, interpolated like envelope_amplitude
+    std::vector<float> pan_side_gain;
+    std::vector<float> pan_mid_gain_end;       // gains at the end of the current control period
+    std::vector<float> pan_side_gain_end;
+
+    protected:
+    void free_voice(uint32_t voice);
+    void unmap_voice(uint32_t voice);
+    int32_t choose_victim(bool skip_fading = false) const;
+
+    uint32_t max_voices;
+    uint32_t voice_limit;
+    Voice_Steal_Policy steal_policy;
+    uint32_t next_start_order;
+    uint32_t live_count;
+    uint32_t free_count;
+    std::vector<uint32_t> live_voices;   // dense list of the voices currently sounding
+    std::vector<uint32_t> live_position; // position of each voice in live_voices, for O(1) removal
+    std::vector<uint32_t> free_voices;   // stack of unused voice indices
+
+    int32_t voice_for_note[16][128];     // voice playing each held note per MIDI channel, or -1. Released voices are not in here.
+};
+
+class Adaptive_Voice_Limit {
+    // Lowers the voice limit when run() takes too much of its deadline, and slowly raises it again once there is headroom.
+    // The load is smoothed so that a single slow block (e.g. a page fault) doesn't throw voices away.
+    public:
+    Adaptive_Voice_Limit();
+
+    void reset(uint32_t max_limit_in);
+    // Feed how long a block took to render and how long it was allowed to take; returns the new limit
+    uint32_t update(double render_seconds, double deadline_seconds, uint32_t live_count);
+    uint32_t get_limit() const { return limit; }
+    float get_load() const { return load; }
+
+    protected:
+    uint32_t max_limit;
+    uint32_t limit;
+    float load;           // smoothed fraction of the deadline used
+    uint32_t calm_blocks; // consecutive blocks with headroom
+};
@@ -0,0 +1,126 @@
+/*
+wavetables.cpp
+Band-limited wavetables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "wavetables.hpp"
+#include "table_cache.hpp"
+
+#include <cmath>
+#include <vector>
+
+// Stored with the tables in the disk cache; bump it whenever render() or the harmonics change what's built
+static const uint32_t generator_version = 1;
+
+// Fourier series of the classic waveforms, scaled to a peak of about 1 and equal to 0 at phase 0
+static float saw_harmonic(uint32_t harmonic) {
+    // rises from 0 to 1 over the first half cycle, then jumps to -1
+    float amplitude = 2/(M_PI*harmonic);
+    return (harmonic % 2) ? amplitude : -amplitude;
+}
+
+static float triangle_harmonic(uint32_t harmonic) {
+    if (harmonic % 2 == 0) {
+        return 0;
+    }
+    float amplitude = 8/(M_PI*M_PI*harmonic*harmonic);
+    return (harmonic % 4 == 1) ? amplitude : -amplitude;
+}
+
+Wavetable::Wavetable() {}
+
+void Wavetable::build(float (*harmonic_amplitude)(uint32_t harmonic)) {
+    std::shared_ptr<float> built(new float[sample_count](), std::default_delete<float[]>());
+    render(harmonic_amplitude, built.get());
+    samples = built;
+}
+
+void Wavetable::load(const char* kind, float (*harmonic_amplitude)(uint32_t harmonic)) {
+    samples = Table_Cache::get_floats({kind, 0, {double(size), double(generator_version)}}, sample_count, [harmonic_amplitude](float* out) {
+        render(harmonic_amplitude, out);
+    });
+}
+
+void Wavetable::render(float (*harmonic_amplitude)(uint32_t harmonic), float* out) {
+    // one cycle of a sine, so every harmonic can be read from it without calling sin()
+    std::vector<float> sine(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        sine[i] = sin(2*M_PI*i/size);
+    }
+
+    // Start from the silent top level and work down, each level adding the harmonics the level above it lacks
+    uint32_t highest_harmonic = 0;
+    for (int32_t level = num_levels - 2; level >= 0; --level) {
+        float* table = out + level*(size + 1);
+        const float* above = table + (size + 1);
+        for (uint32_t i = 0; i <= size; ++i) {
+            table[i] = above[i];
+        }
+
+        uint32_t level_harmonics = (size/2) >> level;
+        for (uint32_t harmonic = highest_harmonic + 1; harmonic <= level_harmonics; ++harmonic) {
+            float amplitude = harmonic_amplitude(harmonic);
+            if (amplitude == 0) {
+                continue;
+            }
+            for (uint32_t i = 0; i < size; ++i) {
+                table[i] += amplitude*sine[(harmonic*i) & (size - 1)];
+            }
+        }
+        table[size] = table[0];
+        highest_harmonic = level_harmonics;
+    }
+}
+
+void Wavetable::build_saw() {
+    build(saw_harmonic);
+}
+
+void Wavetable::build_triangle() {
+    build(triangle_harmonic);
+}
+
+void Wavetable::load_saw() {
+    load("saw wavetable", saw_harmonic);
+}
+
+void Wavetable::load_triangle() {
+    load("triangle wavetable", triangle_harmonic);
+}
+
+void Wavetable::select_levels(uint32_t increment, const float*& level_a, const float*& level_b, float& b_weight) const {
+    // position on the level scale: level k is safe while this is below k
+    float position = log2f(float(increment)*(float(size)/4294967296.f));
+    if (!(position >= 0)) { // also catches increment == 0
+        level_a = get_level(0);
+        level_b = level_a;
+        b_weight = 0;
+        return;
+    }
+
+    // fade from the lowest safe level towards the next one, so harmonics fade out instead of switching off
+    // (the last audible level holds only the fundamental, which must not fade into the silent level)
+    uint32_t level = uint32_t(position) + 1;
+    b_weight = position - floorf(position);
+    if (level >= num_levels - 2) {
+        level = (level > num_levels - 1) ? num_levels - 1 : level;
+        b_weight = 0;
+    }
+    level_a = get_level(level);
+    level_b = (b_weight > 0) ? get_level(level + 1) : level_a;
+}
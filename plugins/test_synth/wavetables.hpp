@@ -0,0 +1,64 @@
+/*
+wavetables.hpp
+Band-limited wavetables for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+class Wavetable {
+    // One periodic waveform stored as a stack of band-limited tables ("mip levels").
+    // Level k holds harmonics 1 to (size/2 >> k), so it is alias-free for phase increments up to 2^k/size cycles per frame.
+    // The tables don't depend on the sample rate, only on the phase increment, so they are built once.
+    public:
+    static const uint32_t size_bits = 11;
+    static const uint32_t size = 1 << size_bits;
+    static const uint32_t num_levels = size_bits + 1; // the last level is silent, for fundamentals above nyquist
+    static const uint32_t sample_count = num_levels*(size + 1);
+
+    Wavetable();
+
+    // Fill every level from the amplitudes of the sine harmonics. Not RT safe.
+    void build(float (*harmonic_amplitude)(uint32_t harmonic));
+    void build_saw();
+    void build_triangle();
+    // The same, but mapped from the disk cache (see table_cache.hpp) if an earlier build on this machine stored them
+    void load_saw();
+    void load_triangle();
+    bool is_built() const { return samples != nullptr; }
+
+    // Pick the two levels to crossfade between for a phase increment, once per block.
+    void select_levels(uint32_t increment, const float*& level_a, const float*& level_b, float& b_weight) const;
+    const float* get_level(uint32_t level) const { return samples.get() + level*(size + 1); }
+
+    // Linearly interpolated lookup; phase is fixed point (see kernels.hpp)
+    static float lookup(const float* level, uint32_t phase) {
+        const uint32_t index = phase >> (32 - size_bits);
+        const float frac = float(phase & ((1u << (32 - size_bits)) - 1))*(1.f/(1u << (32 - size_bits)));
+        return level[index] + frac*(level[index + 1] - level[index]);
+    }
+
+    protected:
+    static void render(float (*harmonic_amplitude)(uint32_t harmonic), float* out); // sample_count floats, zeroed
+    void load(const char* kind, float (*harmonic_amplitude)(uint32_t harmonic));
+
+    // num_levels tables of size+1 samples; the extra sample repeats the first for interpolation. In memory or mapped.
+    std::shared_ptr<const float> samples;
+};
@@ -0,0 +1,235 @@
+/*
+worker_pool.cpp
+Multi-threaded voice rendering for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "worker_pool.hpp"
+#include "address_wait.hpp"
+#include "rt_check.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+static inline void cpu_relax() { _mm_pause(); }
+#else
+static inline void cpu_relax() {}
+#endif
+
+// how long a worker busy-waits for the next block before going to sleep
+static const uint32_t spin_iterations = 20000;
+
+static inline uint64_t pack_job_state(uint32_t generation, uint32_t next_chunk, uint32_t chunk_count) {
+    return (uint64_t(generation) << 32) | (uint64_t(next_chunk) << 16) | chunk_count;
+}
+
+Voice_Worker_Pool::Voice_Worker_Pool() : running(false), job_state(0), job_generation(0), sleeping_workers(0), chunks_done(0),
+                                         requested_priority(-1), priority_failures(0) {
+    audio_priority_requested = false;
+    job_generator = nullptr;
+    job_voices = nullptr;
+    job_frames = 0;
+    job_start_frame = 0;
+    max_chunks = 0;
+    chunk_frames = 0;
+}
+
+Voice_Worker_Pool::~Voice_Worker_Pool() {
+    stop();
+}
+
+void Voice_Worker_Pool::start(uint32_t num_workers, uint32_t max_voices, uint32_t max_frames) {
+    stop();
+
+    max_chunks = (max_voices + voices_per_chunk - 1)/voices_per_chunk;
+    if (max_chunks > 0xffff) {
+        max_chunks = 0xffff;
+    }
+    chunk_frames = max_frames;
+    chunk_buffers.assign(size_t(max_chunks)*2*chunk_frames, 0);
+    audio_priority_requested = false;
+    requested_priority.store(-1);
+    priority_failures.store(0);
+
+    running.store(true);
+    for (uint32_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&Voice_Worker_Pool::worker_main, this);
+    }
+}
+
+void Voice_Worker_Pool::stop() {
+    if (workers.empty()) {
+        return;
+    }
+    running.store(false);
+    job_generation.fetch_add(1, std::memory_order_release);
+    wake_workers();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+bool Voice_Worker_Pool::render(Signal_Generator& generator, Voice_Pool& voices, float* mid, float* side, uint32_t frames, uint64_t start_frame) {
+    const uint32_t live_count = voices.get_live_count();
+    const uint32_t chunk_count = (live_count + voices_per_chunk - 1)/voices_per_chunk;
+    if (frames > chunk_frames || chunk_count > max_chunks) {
+        return false;
+    }
+    if (chunk_count == 0) {
+        return true;
+    }
+    if (!audio_priority_requested) {
+        request_audio_priority();
+    }
+
+    job_generator = &generator;
+    job_voices = &voices;
+    job_frames = frames;
+    job_has_side = side != nullptr;
+    job_start_frame = start_frame;
+    chunks_done.store(0, std::memory_order_relaxed);
+
+    const uint32_t generation = job_generation.load(std::memory_order_relaxed) + 1;
+    job_state.store(pack_job_state(generation, 0, chunk_count), std::memory_order_release);
+    job_generation.store(generation); // seq_cst, paired with the sleeping_workers check below
+    if (sleeping_workers.load() > 0) {
+        wake_workers();
+    }
+
+    // the audio thread works on the job too, then waits for the chunks still being rendered by workers
+    render_chunks(generation);
+    while (chunks_done.load(std::memory_order_acquire) < chunk_count) {
+        cpu_relax();
+    }
+
+    // fixed summation order keeps the result deterministic
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const float* buffer = chunk_buffers.data() + size_t(chunk)*2*chunk_frames;
+        for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+            mid[f_idx] += buffer[f_idx];
+        }
+        if (side != nullptr) {
+            const float* side_buffer = buffer + chunk_frames;
+            for (uint32_t f_idx = 0; f_idx < frames; ++f_idx) {
+                side[f_idx] += side_buffer[f_idx];
+            }
+        }
+    }
+    return true;
+}
+
+void Voice_Worker_Pool::render_chunks(uint32_t generation) {
+    uint64_t state = job_state.load(std::memory_order_acquire);
+    while (true) {
+        const uint32_t next_chunk = (state >> 16) & 0xffff;
+        const uint32_t chunk_count = state & 0xffff;
+        if (uint32_t(state >> 32) != generation || next_chunk >= chunk_count) {
+            return;
+        }
+        if (!job_state.compare_exchange_weak(state, state + (1 << 16), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            continue;
+        }
+
+        // the job can't complete, and so can't be replaced, until this chunk is counted as done
+        float* buffer = chunk_buffers.data() + size_t(next_chunk)*2*chunk_frames;
+        float* side_buffer = job_has_side ? buffer + chunk_frames : nullptr;
+        std::memset(buffer, 0, sizeof(float)*job_frames);
+        if (side_buffer != nullptr) {
+            std::memset(side_buffer, 0, sizeof(float)*job_frames);
+        }
+
+        const uint32_t live_count = job_voices->get_live_count();
+        const uint32_t end = std::min(live_count, (next_chunk + 1)*voices_per_chunk);
+        for (uint32_t v_idx = next_chunk*voices_per_chunk; v_idx < end; ++v_idx) {
+            job_generator->render_block(*job_voices, job_voices->get_live_voice(v_idx), buffer, side_buffer, job_frames, job_start_frame);
+        }
+
+        chunks_done.fetch_add(1, std::memory_order_release);
+        state = job_state.load(std::memory_order_acquire);
+    }
+}
+
+void Voice_Worker_Pool::worker_main() {
+    Denormal_Guard denormal_guard; // as run() does on the audio thread
+    Realtime_Scope realtime_scope;
+    int32_t applied_priority = -1;
+    // stop() may already have moved the generation on before this thread got here, so check before the first wait
+    uint32_t last_generation = job_generation.load(std::memory_order_acquire);
+    while (running.load(std::memory_order_acquire)) {
+        wait_for_job(last_generation);
+        last_generation = job_generation.load(std::memory_order_acquire);
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        follow_requested_priority(applied_priority);
+        render_chunks(last_generation);
+    }
+}
+
+void Voice_Worker_Pool::request_audio_priority() {
+    audio_priority_requested = true;
+#if defined(__unix__) || defined(__APPLE__)
+    // the audio thread waits on the workers, so they have to be realtime too, but never preempt it
+    int policy;
+    sched_param param;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR)) {
+        const int priority = std::max(sched_get_priority_min(policy), param.sched_priority - 1);
+        requested_priority.store((policy << 16) | priority, std::memory_order_relaxed);
+    }
+#endif
+}
+
+void Voice_Worker_Pool::follow_requested_priority(int32_t& applied) {
+    const int32_t requested = requested_priority.load(std::memory_order_relaxed);
+    if (requested == applied) {
+        return;
+    }
+    applied = requested;
+#if defined(__unix__) || defined(__APPLE__)
+    sched_param param = {};
+    param.sched_priority = requested & 0xffff;
+    if (pthread_setschedparam(pthread_self(), requested >> 16, &param) != 0) {
+        priority_failures.fetch_add(1, std::memory_order_relaxed); // e.g. no RLIMIT_RTPRIO; the worker stays as it was
+    }
+#endif
+}
+
+void Voice_Worker_Pool::wait_for_job(uint32_t last_generation) {
+    for (uint32_t i = 0; i < spin_iterations; ++i) {
+        if (job_generation.load(std::memory_order_acquire) != last_generation) {
+            return;
+        }
+        cpu_relax();
+    }
+    // Either render() sees sleeping_workers > 0 and wakes us, or the wait sees the new generation and doesn't sleep
+    sleeping_workers.fetch_add(1);
+    while (job_generation.load() == last_generation) {
+        wait_on_address(job_generation, last_generation);
+    }
+    sleeping_workers.fetch_sub(1);
+}
+
+void Voice_Worker_Pool::wake_workers() {
+    wake_address(job_generation);
+}
@@ -0,0 +1,87 @@
+/*
+worker_pool.hpp
+Multi-threaded voice rendering for the test synth, written by Jonah Hamer-Wilson using the Distrho plugin framework
+
+License:
+Copyright (C) 2025 Jonah Hamer-Wilson <updates@jonahhw.com>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "oscillators.hpp"
+#include "voices.hpp"
+
+class Voice_Worker_Pool {
+    // Renders the live voices of a Voice_Pool on a fixed set of pre-spawned worker threads plus the audio thread.
+    // The live voices are cut into fixed-size chunks, each rendered into its own scratch buffer, and the audio thread
+    // sums the buffers in chunk order, so the mix does not depend on which thread rendered what.
+    // start() and stop() allocate and spawn/join threads; render() takes no locks and does not allocate.
+    public:
+    static const uint32_t voices_per_chunk = 8;
+
+    Voice_Worker_Pool();
+    ~Voice_Worker_Pool();
+
+    void start(uint32_t num_workers, uint32_t max_voices, uint32_t max_frames); // call from activate()
+    void stop();                                                               // call from deactivate()
+    bool is_running() const { return !workers.empty(); }
+    uint32_t get_priority_failures() const { return priority_failures.load(std::memory_order_relaxed); } // since start()
+
+    // Render every live voice, adding the result to mid and, unless it's null, side. Returns false, having done
+    // nothing, if the block doesn't fit the scratch buffers; the caller should then render serially.
+    bool render(Signal_Generator& generator, Voice_Pool& voices, float* mid, float* side, uint32_t frames, uint64_t start_frame);
+
+    protected:
+    void worker_main();
+    void render_chunks(uint32_t generation); // claim and render chunks of the current job until none are left
+    void wait_for_job(uint32_t last_generation);
+    void wake_workers();
+    void request_audio_priority(); // audio thread, once per start()
+    void follow_requested_priority(int32_t& applied); // worker, after each wake
+
+
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+
+    // The current job. Written by the audio thread before `job_state` is published,
+    // and only read by a worker after it has claimed a chunk of that job.
+    Signal_Generator* job_generator;
+    Voice_Pool* job_voices;
+    uint32_t job_frames;
+    bool job_has_side;
+    uint64_t job_start_frame;
+
+    // Packed as generation (32 bits) | next chunk (16 bits) | chunk count (16 bits), so a late worker
+    // can never claim a chunk of a newer job than the one it was woken for.
+    std::atomic<uint64_t> job_state;
+    std::atomic<uint32_t> job_generation; // what the workers sleep on (see address_wait.hpp)
+    std::atomic<uint32_t> sleeping_workers;
+    std::atomic<uint32_t> chunks_done;
+
+    // Hosts call activate(), and so start(), from a normal thread, so the audio thread's priority is only known once
+    // render() runs. The workers then switch themselves to just below it: policy << 16 | priority, or -1 to stay put.
+    bool audio_priority_requested; // audio thread only
+    std::atomic<int32_t> requested_priority;
+    std::atomic<uint32_t> priority_failures;
+
+    uint32_t max_chunks;
+    uint32_t chunk_frames;
+    std::vector<float> chunk_buffers; // max_chunks pairs of mid and side buffers of chunk_frames samples
+};